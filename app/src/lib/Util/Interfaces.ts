@@ -39,6 +39,18 @@ export interface Direct6Token {
 export interface GameClientPlugin {
 	id: string;
 	uid: number;
+	profile?: { [event: string]: PluginEventProfile };
+}
+
+// CPU time spent in one plugin instance's handler for one type of event, as reported after a
+// request-plugin-profiles request. times are in microseconds; frame times cover the most recent 256 frames
+export interface PluginEventProfile {
+	calls: number;
+	frames: number;
+	total: number;
+	maxcall: number;
+	maxframe: number;
+	p99frame: number;
 }
 
 // connected game client for plugin management purposes
@@ -2,8 +2,11 @@
 #include "include/cef_process_message.h"
 #include "include/cef_v8.h"
 #include "include/cef_values.h"
+#include "include/cef_version.h"
 #include "include/internal/cef_types.h"
 
+#include <string>
+
 /*
 The functions in this file run in chromium's render process, which is subject to the full extent
 of its sandboxing measures. The seccomp sandbox in particular is the one to watch out for. Don't
@@ -27,10 +30,22 @@ static void* shm_file;
 static size_t shm_length;
 static bool shm_inited = false;
 
+// maximum number of released screen capture buffers that will be kept for reuse
+#define CAPTURE_BUFFER_RING_SIZE 4
+
 static bool set_launcher_ui = false;
 static bool has_custom_js = false;
 static CefString custom_js;
 
+// key for capture_buffers - frame identifiers are strings since CEF 122, but int64s before that
+static std::string FrameKey(CefRefPtr<CefFrame> frame) {
+#if CEF_VERSION_MAJOR >= 122
+	return frame->GetIdentifier().ToString();
+#else
+	return std::to_string(frame->GetIdentifier());
+#endif
+}
+
 // assumes the context has already been entered
 void PostPluginMessage(CefRefPtr<CefV8Context> context, CefRefPtr<CefProcessMessage> message) {
 	CefRefPtr<CefV8Value> post_message = context->GetGlobal()->GetValue("postMessage");
@@ -93,12 +108,19 @@ void Browser::App::OnContextCreated(CefRefPtr<CefBrowser> browser, CefRefPtr<Cef
 	global->SetValue("close", CefV8Value::CreateUndefined(), V8_PROPERTY_ATTRIBUTE_READONLY);
 	if (set_launcher_ui) {
 		global->SetValue("s", CefV8Value::CreateFunction("s", this), V8_PROPERTY_ATTRIBUTE_READONLY);
+	} else {
+		global->SetValue("releaseCapture", CefV8Value::CreateFunction("releaseCapture", this), V8_PROPERTY_ATTRIBUTE_READONLY);
 	}
 	if (has_custom_js) {
 		frame->ExecuteJavaScript(custom_js, CefString(), int());
 	}
 }
 
+void Browser::App::OnContextReleased(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, CefRefPtr<CefV8Context> context) {
+	// released buffers belong to the context that's going away, so they can't be reused by the next one
+	this->capture_buffers.erase(FrameKey(frame));
+}
+
 void Browser::App::OnUncaughtException(
 	CefRefPtr<CefBrowser>,
 	CefRefPtr<CefFrame> frame,
@@ -202,14 +224,16 @@ bool Browser::App::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefRe
 		}
 
 		CefRefPtr<CefListValue> list = message->GetArgumentList();
-		if (list->GetSize() >= 2) {
+		if (list->GetSize() >= 3) {
 			const int width = list->GetInt(0);
 			const int height = list->GetInt(1);
-			const size_t size = (size_t)width * (size_t)height * 3;
+			const std::string format = list->GetString(2).ToString();
+			const size_t bytes_per_pixel = (format == "rgba") ? 4 : ((format == "red") ? 1 : 3);
+			const size_t size = (size_t)width * (size_t)height * bytes_per_pixel;
 
-			if (list->GetSize() != 2) {
+			if (list->GetSize() != 3) {
 #if defined(_WIN32)
-				const std::wstring path = list->GetString(2).ToWString();
+				const std::wstring path = list->GetString(3).ToWString();
 				if (shm_inited) {
 					UnmapViewOfFile(shm_file);
 					CloseHandle(shm_handle);
@@ -217,8 +241,8 @@ bool Browser::App::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefRe
 				shm_handle = OpenFileMappingW(FILE_MAP_READ, TRUE, path.c_str());
 				shm_file = MapViewOfFile(shm_handle, FILE_MAP_READ, 0, 0, size);
 #else
-				if (list->GetType(2) == VTYPE_STRING) {
-					const std::string path = list->GetString(2).ToString();
+				if (list->GetType(3) == VTYPE_STRING) {
+					const std::string path = list->GetString(3).ToString();
 					if (shm_inited) {
 						munmap(shm_file, shm_length);
 						close(shm_fd);
@@ -236,22 +260,30 @@ bool Browser::App::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser, CefRe
 				shm_inited = true;
 			}
 
-			void* buffer = malloc(size);
-			memcpy(buffer, shm_file, size);
+			// the pixels get copied once, straight from the shm into memory owned by V8, reusing an ArrayBuffer
+			// that the page has given back via releaseCapture() if possible. the ArrayBuffer is then transferred
+			// by postMessage rather than cloned, so there are no further copies.
+			CefRefPtr<CefV8Context> context = frame->GetV8Context();
+			context->Enter();
+			CefRefPtr<CefV8Value> content = this->TakeCaptureBuffer(frame, size);
+			if (content) {
+				memcpy(content->GetArrayBufferData(), shm_file, size);
+			} else {
+				content = CefV8Value::CreateArrayBufferWithCopy(shm_file, size);
+			}
 
 			CefRefPtr<CefProcessMessage> response_message = CefProcessMessage::Create("__bolt_plugin_capture_done");
 			frame->SendProcessMessage(PID_BROWSER, response_message);
 
-			CefRefPtr<CefV8Context> context = frame->GetV8Context();
-			context->Enter();
-			CefRefPtr<CefV8Value> content = CefV8Value::CreateArrayBufferWithCopy(buffer, size);
-			free(buffer);
+			CefRefPtr<CefV8Value> transfer = CefV8Value::CreateArray(1);
+			transfer->SetValue(0, content);
 			CefRefPtr<CefV8Value> dict = CefV8Value::CreateObject(nullptr, nullptr);
 			dict->SetValue("type", CefV8Value::CreateString("screenCapture"), V8_PROPERTY_ATTRIBUTE_READONLY);
 			dict->SetValue("content", content, V8_PROPERTY_ATTRIBUTE_READONLY);
 			dict->SetValue("width", CefV8Value::CreateInt(width), V8_PROPERTY_ATTRIBUTE_READONLY);
 			dict->SetValue("height", CefV8Value::CreateInt(height), V8_PROPERTY_ATTRIBUTE_READONLY);
-			CefV8ValueList value_list = {dict, CefV8Value::CreateString("*")};
+			dict->SetValue("format", CefV8Value::CreateString(format), V8_PROPERTY_ATTRIBUTE_READONLY);
+			CefV8ValueList value_list = {dict, CefV8Value::CreateString("*"), transfer};
 			CefRefPtr<CefV8Value> post_message = context->GetGlobal()->GetValue("postMessage");
 			if (post_message->IsFunction()) {
 				post_message->ExecuteFunctionWithContext(context, nullptr, value_list);
@@ -286,7 +318,36 @@ void Browser::App::OnLoadError(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame
 	// TODO: this should probably be a fatal error for plugins? or at least inform them?
 }
 
-bool Browser::App::Execute(const CefString&, CefRefPtr<CefV8Value>, const CefV8ValueList&, CefRefPtr<CefV8Value>& retval, CefString&) {
+CefRefPtr<CefV8Value> Browser::App::TakeCaptureBuffer(CefRefPtr<CefFrame> frame, size_t size) {
+	auto it = this->capture_buffers.find(FrameKey(frame));
+	if (it == this->capture_buffers.end()) return nullptr;
+	// buffers of the wrong size are no use any more, since all captures for this browser are the same size
+	// until the capture settings change. detached buffers have a length of 0, so they get discarded too.
+	std::vector<CefRefPtr<CefV8Value>>& buffers = it->second;
+	while (buffers.size()) {
+		CefRefPtr<CefV8Value> buffer = buffers.back();
+		buffers.pop_back();
+		if (buffer->IsValid() && buffer->GetArrayBufferByteLength() == size && buffer->GetArrayBufferData()) return buffer;
+	}
+	return nullptr;
+}
+
+bool Browser::App::Execute(const CefString& name, CefRefPtr<CefV8Value>, const CefV8ValueList& arguments, CefRefPtr<CefV8Value>& retval, CefString&) {
+	if (name == "releaseCapture") {
+		// the page is done with a screen capture's content, so it can be overwritten by a later capture
+		retval = CefV8Value::CreateUndefined();
+		if (arguments.size() < 1 || !arguments[0]->IsArrayBuffer()) return true;
+		CefRefPtr<CefFrame> frame = CefV8Context::GetCurrentContext()->GetFrame();
+		if (!frame) return true;
+		std::vector<CefRefPtr<CefV8Value>>& buffers = this->capture_buffers[FrameKey(frame)];
+		if (buffers.size() >= CAPTURE_BUFFER_RING_SIZE) return true;
+		for (const CefRefPtr<CefV8Value>& buffer: buffers) {
+			if (buffer->IsSame(arguments[0])) return true;
+		}
+		buffers.push_back(arguments[0]);
+		return true;
+	}
+
 	retval = CefV8Value::CreateObject(nullptr, nullptr);
 	retval->SetValue("provider", CefV8Value::CreateString("cnVuZXNjYXBl"), V8_PROPERTY_ATTRIBUTE_READONLY);
 	retval->SetValue("origin", CefV8Value::CreateString("aHR0cHM6Ly9hY2NvdW50LmphZ2V4LmNvbQ"), V8_PROPERTY_ATTRIBUTE_READONLY);
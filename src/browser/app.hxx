@@ -4,6 +4,8 @@
 #include "include/cef_app.h"
 #include "include/cef_base.h"
 #include "include/cef_browser_process_handler.h"
+#include <map>
+#include <string>
 #include <vector>
 
 namespace Browser {
@@ -20,6 +22,7 @@ namespace Browser {
 		CefRefPtr<CefLoadHandler> GetLoadHandler() override;
 		void OnBrowserCreated(CefRefPtr<CefBrowser>, CefRefPtr<CefDictionaryValue>) override;
 		void OnContextCreated(CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, CefRefPtr<CefV8Context>) override;
+		void OnContextReleased(CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, CefRefPtr<CefV8Context>) override;
 		void OnUncaughtException(CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, CefRefPtr<CefV8Context>, CefRefPtr<CefV8Exception>, CefRefPtr<CefV8StackTrace>) override;
 		bool OnProcessMessageReceived(CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, CefProcessId, CefRefPtr<CefProcessMessage>) override;
 		void OnLoadEnd(CefRefPtr<CefBrowser>, CefRefPtr<CefFrame>, int) override;
@@ -27,6 +30,10 @@ namespace Browser {
 		bool Execute(const CefString&, CefRefPtr<CefV8Value>, const CefV8ValueList&, CefRefPtr<CefV8Value>&, CefString&) override;
 		void OnRegisterCustomSchemes(CefRawPtr<CefSchemeRegistrar>) override;
 
+		/// Returns a screen capture buffer previously given back by releaseCapture() in the given frame, if
+		/// there's one of the right size, otherwise null. Must be called with the frame's context entered.
+		CefRefPtr<CefV8Value> TakeCaptureBuffer(CefRefPtr<CefFrame>, size_t);
+
 		App(const App&) = delete;
 		App& operator=(const App&) = delete;
 		void AddRef() const override { this->ref_count.AddRef(); }
@@ -37,6 +44,8 @@ namespace Browser {
 			CefRefCount ref_count;
 			CefRefPtr<CefBrowserProcessHandler> browser_process_handler;
 			std::vector<CefRefPtr<CefProcessMessage>> pending_plugin_messages;
+			// released screen capture buffers, keyed by the identifier of the frame whose context they belong to
+			std::map<std::string, std::vector<CefRefPtr<CefV8Value>>> capture_buffers;
 			bool loaded;
 	};
 }
@@ -377,14 +377,14 @@ bool Browser::Client::IPCHandleMessage(int fd) {
 			BoltIPCCaptureNotifyHeader header;
 			_bolt_ipc_receive(fd, &header, sizeof(header));
 			CefRefPtr<Browser::PluginWindow> window = this->GetExternalWindowFromFDAndIDs(client, header.plugin_id, header.window_id);
-			if (window && !window->IsDeleted()) window->HandleCaptureNotify(header.pid, header.capture_id, header.width, header.height, header.needs_remap != 0);
+			if (window && !window->IsDeleted()) window->HandleCaptureNotify(header.pid, header.capture_id, header.width, header.height, header.format, header.needs_remap != 0);
 			break;
 		}
 		case IPC_MSG_CAPTURENOTIFY_OSR: {
 			BoltIPCCaptureNotifyHeader header;
 			_bolt_ipc_receive(fd, &header, sizeof(header));
 			CefRefPtr<Browser::WindowOSR> window = this->GetOsrWindowFromFDAndIDs(client, header.plugin_id, header.window_id);
-			if (window && !window->IsDeleted()) window->HandleCaptureNotify(header.pid, header.capture_id, header.width, header.height, header.needs_remap != 0);
+			if (window && !window->IsDeleted()) window->HandleCaptureNotify(header.pid, header.capture_id, header.width, header.height, header.format, header.needs_remap != 0);
 			break;
 		}
 
@@ -432,6 +432,18 @@ bool Browser::Client::IPCHandleMessage(int fd) {
 			if (window && !window->IsDeleted()) window->HandleShowDevtools();
 			break;
 		}
+		case IPC_MSG_PLUGINPROFILE: {
+			BoltIPCPluginProfileHeader header;
+			_bolt_ipc_receive(fd, &header, sizeof(header));
+			std::vector<BoltIPCPluginProfileEntry> entries(header.entry_count);
+			_bolt_ipc_receive(fd, entries.data(), entries.size() * sizeof(BoltIPCPluginProfileEntry));
+			CefRefPtr<ActivePlugin> plugin = this->GetPluginFromFDAndID(client, header.plugin_id);
+			if (plugin) {
+				plugin->profile = std::move(entries);
+				this->IPCHandleClientListUpdate(false);
+			}
+			break;
+		}
 		case IPC_MSG_SHOWDEVTOOLS_OSR: {
 			BoltIPCShowDevtoolsHeader header;
 			_bolt_ipc_receive(fd, &header, sizeof(header));
@@ -469,6 +481,21 @@ void Browser::Client::ListGameClients(CefRefPtr<CefListValue> list, bool need_lo
 			CefRefPtr<CefDictionaryValue> plugin_dict = CefDictionaryValue::Create();
 			plugin_dict->SetInt("uid", p->uid);
 			plugin_dict->SetString("id", CefString(p->id));
+			if (!p->profile.empty()) {
+				CefRefPtr<CefDictionaryValue> profile_dict = CefDictionaryValue::Create();
+				for (const BoltIPCPluginProfileEntry& e: p->profile) {
+					// times are sent in nanoseconds but reported to the frontend in microseconds
+					CefRefPtr<CefDictionaryValue> entry_dict = CefDictionaryValue::Create();
+					entry_dict->SetDouble("calls", static_cast<double>(e.calls));
+					entry_dict->SetDouble("frames", static_cast<double>(e.frames));
+					entry_dict->SetDouble("total", static_cast<double>(e.total_nanos) / 1000.0);
+					entry_dict->SetDouble("maxcall", static_cast<double>(e.max_call_nanos) / 1000.0);
+					entry_dict->SetDouble("maxframe", static_cast<double>(e.max_frame_nanos) / 1000.0);
+					entry_dict->SetDouble("p99frame", static_cast<double>(e.p99_frame_nanos) / 1000.0);
+					profile_dict->SetDictionary(CefString(std::string(e.event_name, strnlen(e.event_name, sizeof(e.event_name)))), entry_dict);
+				}
+				plugin_dict->SetDictionary("profile", profile_dict);
+			}
 			plugin_list->SetDictionary(plugin_list_index, plugin_dict);
 			plugin_list_index += 1;
 		}
@@ -567,6 +594,24 @@ void Browser::Client::StopPlugin(uint64_t client_id, uint64_t uid) {
 	this->game_clients_lock.unlock();
 }
 
+void Browser::Client::RequestPluginProfiles(uint64_t client_id) {
+	this->game_clients_lock.lock();
+	for (GameClient& g: this->game_clients) {
+		if (g.deleted || g.uid != client_id) continue;
+		const BoltIPCMessageTypeToClient msg_type = IPC_MSG_PLUGINPROFILEREQUEST;
+		this->send_lock.lock();
+		for (const CefRefPtr<ActivePlugin>& p: g.plugins) {
+			if (p->deleted) continue;
+			const BoltIPCPluginProfileRequestHeader header = { .plugin_id = p->uid };
+			_bolt_ipc_send(g.fd, &msg_type, sizeof(msg_type));
+			_bolt_ipc_send(g.fd, &header, sizeof(header));
+		}
+		this->send_lock.unlock();
+		break;
+	}
+	this->game_clients_lock.unlock();
+}
+
 void Browser::Client::CleanupClientPlugins(int fd) {
 	this->game_clients_lock.lock();
 	for (auto it = this->game_clients.begin(); it != this->game_clients.end(); it += 1) {
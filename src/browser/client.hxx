@@ -94,6 +94,10 @@ namespace Browser {
 		/// Sends an IPC message to the named client to stop the named instance of a plugin.
 		void StopPlugin(uint64_t client_id, uint64_t uid);
 
+		/// Sends an IPC message to the named client asking for the event handler profile of each of its plugins.
+		/// The replies arrive asynchronously, and the client list is updated as each one is received.
+		void RequestPluginProfiles(uint64_t client_id);
+
 		/// Filters the list of plugins and their associated browsers for the client identified by the given fd,
 		/// to remove deleted plugins and browsers. Usually called when a browser is closed.
 		void CleanupClientPlugins(int fd);
@@ -131,6 +135,7 @@ namespace Browser {
 				bool deleted;
 				std::vector<CefRefPtr<Browser::PluginWindow>> windows;
 				std::vector<CefRefPtr<Browser::WindowOSR>> windows_osr;
+				std::vector<BoltIPCPluginProfileEntry> profile; // most recent profile reported by the client, if any
 
 				private:
 					IMPLEMENT_REFCOUNTING(ActivePlugin);
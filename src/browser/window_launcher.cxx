@@ -278,6 +278,7 @@ CefRefPtr<CefResourceRequestHandler> Browser::Launcher::GetResourceRequestHandle
 		ROUTEIFPLUGINS("read-json-file", ReadJsonFile)
 		ROUTEIFPLUGINS("start-plugin", StartPlugin)
 		ROUTEIFPLUGINS("stop-plugin", StopPlugin)
+		ROUTEIFPLUGINS("request-plugin-profiles", RequestPluginProfiles)
 		ROUTEIFPLUGINS("install-plugin", InstallPlugin)
 		ROUTEIFPLUGINS("uninstall-plugin", UninstallPlugin)
 		ROUTEIFPLUGINS("get-plugindir-json", GetPluginDirJson)
@@ -571,6 +572,18 @@ CefRefPtr<CefResourceRequestHandler> Browser::Launcher::StopPlugin(CefRefPtr<Cef
 	QSENDOK();
 }
 
+CefRefPtr<CefResourceRequestHandler> Browser::Launcher::RequestPluginProfiles(CefRefPtr<CefRequest> request, CefRefPtr<CefBrowser> browser, std::string_view query) {
+	uint64_t client;
+	bool has_client = false;
+	bool client_valid = false;
+	ParseQuery(query, [&](const std::string_view& key, const std::string_view& val) {
+		PQINT(client)
+	});
+	QREQPARAMINT(client);
+	this->client->RequestPluginProfiles(client);
+	QSENDOK();
+}
+
 CefRefPtr<CefResourceRequestHandler> Browser::Launcher::InstallPlugin(CefRefPtr<CefRequest> request, CefRefPtr<CefBrowser> browser, std::string_view query) {
 #if defined(HAS_LIBARCHIVE)
 	CefRefPtr<CefPostData> post_data = request->GetPostData();
@@ -24,8 +24,8 @@ struct SendPluginMessageTask: public CefTask {
 };
 
 struct SendCaptureMessageTask: public CefTask {
-	SendCaptureMessageTask(CefRefPtr<Browser::PluginRequestHandler> self, uint64_t pid, uint64_t capture_id, int width, int height, bool needs_remap):
-		self(self), pid(pid), capture_id(capture_id), width(width), height(height), needs_remap(needs_remap) {}
+	SendCaptureMessageTask(CefRefPtr<Browser::PluginRequestHandler> self, uint64_t pid, uint64_t capture_id, int width, int height, uint8_t format, bool needs_remap):
+		self(self), pid(pid), capture_id(capture_id), width(width), height(height), format(format), needs_remap(needs_remap) {}
 	void Execute() override {
 		CefRefPtr<CefBrowser> browser = self->Browser();
 		if (!browser) {
@@ -38,22 +38,27 @@ struct SendCaptureMessageTask: public CefTask {
 		CefRefPtr<CefListValue> list = message->GetArgumentList();
 		const uint64_t current_capture_id = self->CurrentCaptureID();
 		if (needs_remap || capture_id != current_capture_id) {
-			list->SetSize(3);
+			list->SetSize(4);
 #if !defined(_WIN32)
 			if (capture_id != current_capture_id) {
 #endif
 			const CefString str = std::format("/bolt-{}-sc-{}", pid, capture_id);
-			list->SetString(2, str);
+			list->SetString(3, str);
 #if !defined(_WIN32)
 			} else {
-				list->SetNull(2);
+				list->SetNull(3);
 			}
 #endif
 		} else {
-			list->SetSize(2);
+			list->SetSize(3);
 		}
 		list->SetInt(0, width);
 		list->SetInt(1, height);
+		switch (format) {
+			case IPC_CAPTURE_RGBA: list->SetString(2, "rgba"); break;
+			case IPC_CAPTURE_RED: list->SetString(2, "red"); break;
+			default: list->SetString(2, "rgb"); break;
+		}
 		browser->GetMainFrame()->SendProcessMessage(PID_RENDERER, message);
 		self->SetCurrentCaptureID(capture_id);
 	}
@@ -63,6 +68,7 @@ struct SendCaptureMessageTask: public CefTask {
 		uint64_t capture_id;
 		int width;
 		int height;
+		uint8_t format;
 		bool needs_remap;
 		IMPLEMENT_REFCOUNTING(SendCaptureMessageTask);
 		DISALLOW_COPY_AND_ASSIGN(SendCaptureMessageTask);
@@ -88,8 +94,8 @@ void Browser::PluginRequestHandler::HandlePluginMessage(const uint8_t* data, siz
 	CefPostTask(TID_UI, new SendPluginMessageTask(this, message));
 }
 
-void Browser::PluginRequestHandler::HandleCaptureNotify(uint64_t pid, uint64_t capture_id, int width, int height, bool needs_remap) {
-	CefPostTask(TID_UI, new SendCaptureMessageTask(this, pid, capture_id, width, height, needs_remap));
+void Browser::PluginRequestHandler::HandleCaptureNotify(uint64_t pid, uint64_t capture_id, int width, int height, uint8_t format, bool needs_remap) {
+	CefPostTask(TID_UI, new SendCaptureMessageTask(this, pid, capture_id, width, height, format, needs_remap));
 }
 
 void Browser::PluginRequestHandler::NotifyBrowserCreated(CefRefPtr<CefBrowser> browser) {
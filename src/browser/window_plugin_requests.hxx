@@ -14,7 +14,7 @@ namespace Browser {
 			message_type(message_type), send_lock(send_lock), current_capture_id(-1) {}
 
 		void HandlePluginMessage(const uint8_t*, size_t);
-		void HandleCaptureNotify(uint64_t, uint64_t, int, int, bool);
+		void HandleCaptureNotify(uint64_t, uint64_t, int, int, uint8_t, bool);
 		void NotifyBrowserCreated(CefRefPtr<CefBrowser>);
 
 		CefRefPtr<CefResourceRequestHandler> GetResourceRequestHandler(
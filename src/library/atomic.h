@@ -0,0 +1,24 @@
+#ifndef _BOLT_LIBRARY_ATOMIC_H_
+#define _BOLT_LIBRARY_ATOMIC_H_
+
+// atomic loads and stores for data shared between threads without a lock. loads have acquire semantics
+// and stores have release semantics, so anything written before a pointer is stored is visible to a
+// thread that loads that pointer.
+#if defined(_MSC_VER)
+#include <windows.h>
+#define ATOMIC_LOAD_PTR(P) InterlockedCompareExchangePointer((void* volatile*)(P), NULL, NULL)
+#define ATOMIC_STORE_PTR(P, V) InterlockedExchangePointer((void* volatile*)(P), (V))
+#define ATOMIC_LOAD_U32(P) ((uint32_t)InterlockedCompareExchange((volatile LONG*)(P), 0, 0))
+#define ATOMIC_STORE_U32(P, V) InterlockedExchange((volatile LONG*)(P), (LONG)(V))
+#define ATOMIC_LOAD_U64(P) ((uint64_t)InterlockedCompareExchange64((volatile LONG64*)(P), 0, 0))
+#define ATOMIC_ADD_U64(P, V) InterlockedExchangeAdd64((volatile LONG64*)(P), (LONG64)(V))
+#else
+#define ATOMIC_LOAD_PTR(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE_PTR(P, V) __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#define ATOMIC_LOAD_U32(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE_U32(P, V) __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#define ATOMIC_LOAD_U64(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define ATOMIC_ADD_U64(P, V) __atomic_fetch_add((P), (V), __ATOMIC_RELEASE)
+#endif
+
+#endif
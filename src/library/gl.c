@@ -1,4 +1,5 @@
 #include "plugin/plugin.h"
+#include "atomic.h"
 #include "gl.h"
 #include "rwlock/rwlock.h"
 #include "../../modules/hashmap/hashmap.h"
@@ -8,6 +9,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+// SSE2 code paths are used where the compiler guarantees SSE2, i.e. any x86_64 target. every one has a scalar
+// fallback which gives identical results.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOLT_SSE2
+#endif
+
 // -D BOLT_LIBRARY_VERBOSE=1
 #if defined(VERBOSE)
 #if defined(WIN32)
@@ -27,18 +35,166 @@ void _bolt_gl_set_logfile(FILE* f) { logfile = f; }
 #define LOGF(...)
 #endif
 
+// -D BOLT_LIBRARY_PROFILE=1
+// measures the CPU time spent inside bolt's hooks, i.e. excluding the real GL call where there is
+// one, and prints a per-frame summary every PROFILE_REPORT_FRAMES frames. counters aren't atomic
+// since the game does all its rendering from one thread, so treat the numbers as approximate.
+#if defined(PROFILE)
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+enum ProfileHook {
+    PROFILE_DRAWELEMENTS,
+    PROFILE_DRAWARRAYS,
+    PROFILE_TEXSUBIMAGE2D,
+    PROFILE_COMPRESSEDTEXSUBIMAGE2D,
+    PROFILE_BUFFERDATA,
+    PROFILE_MAPBUFFER,
+    PROFILE_SWAPBUFFERS,
+    PROFILE_HOOK_COUNT, // last member of enum
+};
+static const char* const profile_hook_names[] = {
+    "DrawElements",
+    "DrawArrays",
+    "TexSubImage2D",
+    "CompressedTexSubImage2D",
+    "BufferData",
+    "MapBuffer",
+    "SwapBuffers",
+};
+
+struct ProfileCounter {
+    uint64_t calls;
+    uint64_t nanos;
+};
+
+#define PROFILE_REPORT_FRAMES 600
+static struct ProfileCounter profile_frame[PROFILE_HOOK_COUNT];
+static struct ProfileCounter profile_window[PROFILE_HOOK_COUNT];
+static uint64_t profile_window_frames = 0;
+static uint64_t profile_window_max_frame_nanos = 0;
+
+static uint64_t profile_now() {
+#if defined(_WIN32)
+    LARGE_INTEGER ticks, frequency;
+    QueryPerformanceCounter(&ticks);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((ticks.QuadPart * 1000000000.0) / frequency.QuadPart);
+#else
+    struct timespec s;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &s);
+    return ((uint64_t)s.tv_sec * 1000000000) + (uint64_t)s.tv_nsec;
+#endif
+}
+
+static void profile_record(enum ProfileHook hook, uint64_t start) {
+    profile_frame[hook].calls += 1;
+    profile_frame[hook].nanos += profile_now() - start;
+}
+
+// called once per frame, after SwapBuffers has been recorded
+static void profile_end_frame() {
+    uint64_t frame_nanos = 0;
+    for (size_t i = 0; i < PROFILE_HOOK_COUNT; i += 1) {
+        frame_nanos += profile_frame[i].nanos;
+        profile_window[i].calls += profile_frame[i].calls;
+        profile_window[i].nanos += profile_frame[i].nanos;
+    }
+    memset(profile_frame, 0, sizeof(profile_frame));
+    if (frame_nanos > profile_window_max_frame_nanos) profile_window_max_frame_nanos = frame_nanos;
+    profile_window_frames += 1;
+    if (profile_window_frames < PROFILE_REPORT_FRAMES) return;
+
+    uint64_t total_nanos = 0;
+    printf("[profile] bolt hook time over %llu frames:\n", (unsigned long long)profile_window_frames);
+    for (size_t i = 0; i < PROFILE_HOOK_COUNT; i += 1) {
+        const struct ProfileCounter* counter = &profile_window[i];
+        total_nanos += counter->nanos;
+        printf(
+            "[profile]   %-24s %8.1f calls/frame %9.1f us/frame\n", profile_hook_names[i],
+            (double)counter->calls / profile_window_frames, (double)counter->nanos / (profile_window_frames * 1000.0)
+        );
+    }
+    printf(
+        "[profile]   total: %.1f us/frame average, %.1f us worst frame\n",
+        (double)total_nanos / (profile_window_frames * 1000.0), (double)profile_window_max_frame_nanos / 1000.0
+    );
+    memset(profile_window, 0, sizeof(profile_window));
+    profile_window_frames = 0;
+    profile_window_max_frame_nanos = 0;
+}
+
+#define PROFILE_START() const uint64_t profile_start = profile_now();
+#define PROFILE_END(HOOK) profile_record(HOOK, profile_start);
+#define PROFILE_END_FRAME() profile_end_frame();
+#else
+#define PROFILE_START()
+#define PROFILE_END(...)
+#define PROFILE_END_FRAME()
+#endif
+
+#define PROGRAM_BLOCK_BINDINGS 16 // the game's shaders don't use anywhere near this many uniform blocks
+#define MAX_UNIFORM_BUFFER_BINDINGS 96 // anything past this is queried from the driver instead of being shadowed
+
 struct GLArrayBuffer {
     GLuint id;
     void* data;
-    uint8_t* mapping;
+    uint8_t* mapping; // for intercepted mappings this is bolt's copy, otherwise it's what GL returned
     GLintptr mapping_offset;
     GLsizeiptr mapping_len;
     GLbitfield mapping_access_type;
+    // `data` is only kept up-to-date once event handlers might read it, i.e. the buffer has been bound
+    // as an index or uniform buffer, or used for vertex attributes in a draw that bolt handles. until
+    // then, uploads and mappings go straight to GL, and the contents get read back if that ever happens.
+    GLsizeiptr size;
+    uint8_t is_mirrored;
+    uint8_t is_gl_mapped;
+    uint8_t mirror_after_unmap;
+    // an asynchronous read-back of part of the buffer, see buffer_read_back_start. when a buffer is first
+    // mirrored, its contents are put together in `readback_data` and `data` stays NULL until this lands.
+    // `readback_written` marks the bytes of the range which hooks have written since it started, since
+    // those are newer than what the read-back will return.
+    GLuint readback_buffer;
+    GLsync readback_fence;
+    GLintptr readback_offset;
+    GLsizeiptr readback_len;
+    uint8_t* readback_data;
+    uint8_t* readback_written;
+    uint64_t readback_frame;
+    // set from buffer_touch whenever the contents change. generations are never reused, even by
+    // other buffers, so a generation on its own is enough to tell whether some cached value is stale.
+    uint64_t generation;
+};
+
+/// State of each block of a texture's S3TC data, see GLTexture2D::compressed_state.
+enum CompressedBlockState {
+    COMPRESSED_BLOCK_EMPTY,   // never uploaded
+    COMPRESSED_BLOCK_DECODED, // uploaded and already decoded into `data`
+    COMPRESSED_BLOCK_PENDING, // uploaded but not decoded yet
 };
 
 struct GLTexture2D {
     GLuint id;
     uint8_t* data;
+    // S3TC blocks from glCompressedTexSubImage2D are kept here and only decoded into `data` when
+    // something reads that part of the texture. compressed_state has one CompressedBlockState per block,
+    // and compressed_pending is the number of pending blocks. unless the shadow is pinned, the blocks are
+    // kept after being decoded, since they're the only way to rebuild the shadow if it gets evicted.
+    uint8_t* compressed;
+    uint8_t* compressed_state;
+    size_t compressed_pending;
+    GLenum compressed_format;
+    // shadow memory budgeting, see struct TextureShadows. textures which have been given to a plugin
+    // event are pinned and never evicted. evicted textures have `data` set to NULL.
+    struct GLTexture2D* lru_prev;
+    struct GLTexture2D* lru_next;
+    uint8_t is_lru_listed;
+    uint8_t is_shadow_pinned;
+    uint8_t is_shadow_written;
+    uint8_t is_shadow_evicted;
     GLsizei width;
     GLsizei height;
     double minimap_center_x;
@@ -50,6 +206,9 @@ struct GLTexture2D {
     uint8_t is_minimap_tex_big;
     uint8_t is_minimap_tex_small;
     uint8_t is_multisample;
+    // set from texture_touch whenever the contents are changed by an upload or copy. like buffer
+    // generations, these are never reused. rendering to the texture doesn't change its generation.
+    uint64_t generation;
 };
 
 struct GLProgram {
@@ -101,6 +260,17 @@ struct GLProgram {
     GLint offset_uGridSize;
     GLint block_index_GUIConsts;
     GLint block_index_BilloardConsts; // not a mistake, the game engine spells it like that
+    // values of the sampler uniforms read at draw time, so they don't have to be queried from the driver.
+    // initialised after linking and kept up to date by the glUniform1i(v) hooks.
+    GLint val_uDiffuseMap;
+    GLint val_uTextureAtlas;
+    GLint val_uTextureAtlasSettings;
+    GLint val_sSceneHDRTex;
+    GLint val_sSourceTex;
+    GLint val_sTexture;
+    // binding point of each uniform block, indexed by block index. blocks past the end of this list
+    // are queried from the driver as needed.
+    GLint block_bindings[PROGRAM_BLOCK_BINDINGS];
     uint8_t is_minimap;
     uint8_t is_2d;
     uint8_t is_3d;
@@ -116,18 +286,56 @@ struct GLAttrBinding {
     uint32_t type;
     uint8_t normalise;
     uint8_t enabled;
+    // chosen by attr_resolve_decoders whenever the type or normalisation changes
+    void (*decode)(const uint8_t* ptr, size_t num_out, float* out);
+    void (*decode_int)(const uint8_t* ptr, size_t num_out, int32_t* out);
 };
 
 struct GLVertexArray {
     GLuint id;
+    GLuint element_buffer;
+    GLint attribute_count;
     struct GLAttrBinding* attributes;
 };
 
-struct HashMap {
-    struct hashmap* map;
+// map of GL object names to the structs bolt keeps for them. GL names are small integers which drivers
+// hand out more or less sequentially, so instead of being hashed, they index directly into a two-level
+// table whose pages are allocated as they're first needed. the rare name that's too big for the table
+// goes in `overflow` instead.
+//
+// lookups in the table don't take the lock: the page list is allocated once and never moves, and pages are
+// never freed until the whole map is. pages and slots are stored with ATOMIC_STORE_PTR and loaded with
+// ATOMIC_LOAD_PTR, so a reader always sees either the old or the new value of a slot, and sees the struct
+// a slot points to fully initialised. anything that modifies the map, or looks in `overflow`, must hold
+// the lock.
+struct NameMap {
+    void*** pages; // NAMEMAP_PAGE_COUNT entries, each NULL or NAMEMAP_PAGE_SIZE entries
+    struct hashmap* overflow;
     RWLock rwlock;
 };
 
+// CPU shadow memory of all the textures in a share group. textures whose shadows can be evicted are
+// kept in a list, most recently used first, and evicted from the back whenever `bytes` goes over
+// `budget`. the budget comes from the BOLT_TEXTURE_SHADOW_BUDGET_MB environment variable, and zero
+// (the default) means unlimited.
+struct TextureShadows {
+    RWLock rwlock;
+    struct GLTexture2D* lru_head;
+    struct GLTexture2D* lru_tail;
+    size_t bytes;
+    size_t budget;
+    uint64_t evictions;
+    uint64_t evicted_bytes;
+    uint64_t restores;
+};
+
+/// Cached attachments of a bound framebuffer. -1 means not yet known, in which case it will be queried
+/// from the driver when it's next needed.
+struct FramebufferAttachments {
+    GLint colour;
+    GLint depth;
+};
+
 struct TextureUnit {
     GLuint texture_2d;
     GLuint texture_2d_multisample;
@@ -141,16 +349,24 @@ struct TextureUnit {
 /// are actually safe assumptions in valid OpenGL usage.
 struct GLContext {
     uintptr_t id;
-    struct HashMap* programs;
-    struct HashMap* buffers;
-    struct HashMap* textures;
-    struct HashMap* vaos;
-    struct TextureUnit* texture_units;
+    struct NameMap* programs;
+    struct NameMap* buffers;
+    struct NameMap* textures;
+    struct NameMap* vaos;
+    struct TextureShadows* texture_shadows;
+    struct TextureUnit* texture_units; // allocated the first time this context is made current
+    GLint texture_unit_count;
     struct GLProgram* bound_program;
     struct GLVertexArray* bound_vao;
     GLenum active_texture;
     GLuint current_draw_framebuffer;
     GLuint current_read_framebuffer;
+    struct FramebufferAttachments draw_attachments;
+    struct FramebufferAttachments read_attachments;
+    GLuint bound_array_buffer;
+    GLuint bound_uniform_buffer;
+    GLuint bound_pixel_unpack_buffer;
+    GLuint uniform_buffer_bindings[MAX_UNIFORM_BUFFER_BINDINGS];
     GLuint game_view_part_framebuffer;
     GLint game_view_sSourceTex;
     GLint game_view_sSceneHDRTex;
@@ -221,6 +437,51 @@ static uint8_t gameview_overlay_inited = false;
 
 static size_t frames_without_3d = 0;
 
+// screen captures are read back asynchronously: ReadPixels goes into a pixel-pack buffer followed by a
+// fence, and the buffer is only mapped once the fence has signalled, usually a frame or two later, so the
+// game's frame never has to wait for the GPU. each browser doing captures has its own ScreenCapture, and
+// a slot with a NULL readback is free.
+//
+// readbacks are reference-counted so that browsers asking for exactly the same capture on the same frame
+// can share one, instead of reading the same pixels back twice. unreferenced ones are kept in a small pool
+// so that their buffers can be reused.
+#define SCREEN_CAPTURE_SLOTS 2
+#define SCREEN_READBACK_POOL_SIZE 8
+struct ScreenReadback {
+    GLuint buffer;
+    GLsizeiptr buffer_size;
+    GLsync fence;
+    uint64_t frame;
+    int16_t x;
+    int16_t y;
+    uint32_t src_width;
+    uint32_t src_height;
+    uint32_t width;
+    uint32_t height;
+    uint8_t format;
+    uint32_t refcount;
+};
+struct ScreenCaptureSlot {
+    struct ScreenReadback* readback;
+    uint64_t sequence;
+};
+struct ScreenCapture {
+    struct ScreenCaptureSlot slots[SCREEN_CAPTURE_SLOTS];
+    struct ScreenCaptureSlot* ready;
+};
+static uint64_t screen_capture_sequence = 0;
+static uint64_t screen_capture_frame = 0;
+static struct ScreenReadback* screen_readback_latest = NULL;
+static struct ScreenReadback* screen_readback_pool[SCREEN_READBACK_POOL_SIZE];
+static size_t screen_readback_pool_count = 0;
+
+// downscaled captures are blitted into this first, then read back from it. it's shared by all captures
+// and only ever grows.
+static GLuint screen_capture_scale_fb = 0;
+static GLuint screen_capture_scale_tex = 0;
+static uint32_t screen_capture_scale_width = 0;
+static uint32_t screen_capture_scale_height = 0;
+
 #define GLSLHEADER "#version 330 core\n"
 #define GLSLPLUGINEXTENSIONHEADER "#extension GL_ARB_explicit_uniform_location : require\n"
 
@@ -278,7 +539,7 @@ static const GLchar program_region_fs[] = GLSLHEADER
   "col = vec4(rgb, rgb, rgb, alpha);"
 "}";
 
-static void context_init(struct GLContext*, void*, void*);
+static void context_init(struct GLContext*, void*, struct GLContext*);
 static void context_free(struct GLContext*);
 
 static void glplugin_drawelements_vertex2d_xy(size_t index, void* userdata, int32_t* out);
@@ -305,6 +566,21 @@ static void glplugin_drawelements_vertexbillboard_uv(size_t index, void* userdat
 static size_t glplugin_drawelements_vertexbillboard_atlas_meta(size_t index, void* userdata);
 static void glplugin_drawelements_vertexbillboard_meta_xywh(size_t index, void* userdata, int32_t* out);
 static void glplugin_drawelements_vertexbillboard_colour(size_t index, void* userdata, double* out);
+static void glplugin_drawelements_vertex2d_xy_batch(size_t first, size_t count, void* userdata, int32_t* out);
+static void glplugin_drawelements_vertex2d_atlas_details_batch(size_t first, size_t count, void* userdata, int32_t* out, uint8_t* wrapx, uint8_t* wrapy);
+static void glplugin_drawelements_vertex2d_uv_batch(size_t first, size_t count, void* userdata, double* out, uint8_t* discard);
+static void glplugin_drawelements_vertex2d_colour_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertex3d_xyz_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertex3d_uv_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertex3d_colour_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertex3d_boneid_batch(size_t first, size_t count, void* userdata, uint8_t* out);
+static uint64_t glplugin_drawelements_vertex3d_modelhash(void* userdata);
+static void glplugin_drawelements_vertexparticles_xyz_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertexparticles_uv_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertexparticles_colour_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertexbillboard_xyz_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertexbillboard_uv_batch(size_t first, size_t count, void* userdata, double* out);
+static void glplugin_drawelements_vertexbillboard_colour_batch(size_t first, size_t count, void* userdata, double* out);
 static void glplugin_matrixparticles_viewmatrix(void* userdata, struct Transform3D* out);
 static void glplugin_matrixparticles_projectionmatrix(void* userdata, struct Transform3D* out);
 static void glplugin_matrixparticles_viewprojmatrix(void* userdata, struct Transform3D* out);
@@ -322,7 +598,8 @@ static void glplugin_matrix3d_inv_viewmatrix(void* userdata, struct Transform3D*
 static size_t glplugin_texture_id(void* userdata);
 static void glplugin_texture_size(void* userdata, size_t* out);
 static uint8_t glplugin_texture_compare(void* userdata, size_t x, size_t y, size_t len, const unsigned char* data);
-static uint8_t* glplugin_texture_data(void* userdata, size_t x, size_t y);
+static uint8_t* glplugin_texture_data(void* userdata, size_t x, size_t y, size_t len);
+static uint64_t glplugin_texture_generation(void* userdata);
 static void glplugin_camera_position(void* userdata, double* out);
 static void glplugin_gameview_size(void* userdata, int* w, int* h);
 static void glplugin_surface_init(struct SurfaceFunctions* out, unsigned int width, unsigned int height, const void* data);
@@ -337,9 +614,15 @@ static void glplugin_surface_set_tint(void* userdata, double r, double g, double
 static void glplugin_surface_set_alpha(void* userdata, double alpha);
 static void glplugin_draw_region_outline(void* userdata, int16_t x, int16_t y, uint16_t width, uint16_t height);
 static void glplugin_read_screen_pixels(int16_t x, int16_t y, uint32_t width, uint32_t height, void* data);
+static void* glplugin_capture_screen_init(void);
+static uint8_t glplugin_capture_screen_begin(void* userdata, int16_t x, int16_t y, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height, uint8_t format, uint8_t shared_only);
+static uint8_t glplugin_capture_screen_poll(void* userdata, uint32_t* width, uint32_t* height, uint8_t* format);
+static void glplugin_capture_screen_read(void* userdata, void* data);
+static void glplugin_capture_screen_destroy(void* userdata);
 static void glplugin_copy_screen(void* userdata, int sx, int sy, int sw, int sh, int dx, int dy, int dw, int dh);
 static void glplugin_game_view_rect(int* x, int* y, int* w, int* h);
 static void glplugin_player_position(int32_t* x, int32_t* y, int32_t* z);
+static void glplugin_texture_shadow_stats(struct TextureShadowStats* out);
 static uint8_t glplugin_vertex_shader_init(struct ShaderFunctions* out, const char* source, int len, char* output, int output_len);
 static uint8_t glplugin_fragment_shader_init(struct ShaderFunctions* out, const char* source, int len, char* output, int output_len);
 static uint8_t glplugin_shaderprogram_init(struct ShaderProgramFunctions* out, void* vertex, void* fragment, char* output, int output_len);
@@ -357,6 +640,8 @@ static void glplugin_shaderbuffer_init(struct ShaderBufferFunctions* out, const
 static void glplugin_shaderbuffer_destroy(void* userdata);
 
 /* forward-declared functions to be called from DrawElements */
+static void drawelements(GLenum mode, GLsizei count, GLenum type, const void* indices_offset);
+static void drawarrays(GLenum mode, GLint first, GLsizei count);
 static void drawelements_handle_2d(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes);
 static void drawelements_handle_3d(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes);
 static void drawelements_handle_particles(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes);
@@ -364,21 +649,31 @@ static void drawelements_handle_billboard(GLsizei count, const unsigned short* i
 static void drawelements_handle_2d_renderminimap(const struct GLTexture2D* tex, const GLfloat* projection_matrix, struct GLContext* c, const struct GLAttrBinding* attributes);
 static void drawelements_handle_2d_minimapterrain(const unsigned short* indices, const struct GLTexture2D* tex, const GLfloat* projection_matrix, struct GLContext* c, const struct GLAttrBinding* attributes);
 static void drawelements_handle_2d_bigicon(const unsigned short* indices, struct GLTexture2D* tex, const GLfloat* projection_matrix, struct GLContext* c, const struct GLAttrBinding* attributes);
+static void drawelements_handle_2d_bigicon_event(const unsigned short* indices, const struct GLTexture2D* tex, const GLfloat* projection_matrix, struct GLContext* c, const struct GLAttrBinding* attributes);
 static void drawelements_handle_2d_normal(GLsizei count, const unsigned short* indices, struct GLTexture2D* tex, const GLfloat* projection_matrix, struct GLContext* c, const struct GLAttrBinding* attributes, void (*handler_2d)(const struct RenderBatch2D*), void (*handler_icon)(const struct RenderIconEvent*));
 static void drawelements_handle_3d_silhouette(struct GLContext* c);
 static void drawelements_handle_3d_normal(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes);
 static void drawelements_handle_3d_iconrender(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes, GLint draw_tex);
 
-#define MAX_TEXTURE_UNITS 4096 // would be nice if there was a way to query this at runtime, but it would be awkward to set up
-#define BUFFER_LIST_CAPACITY 256 * 256
-#define TEXTURE_LIST_CAPACITY 256
-#define PROGRAM_LIST_CAPACITY 256 * 8
-#define VAO_LIST_CAPACITY 256 * 256
-#define CONTEXTS_CAPACITY 64 // not growable so we just have to hard-code a number and hope it's enough forever
+#define NAMEMAP_PAGE_BITS 10
+#define NAMEMAP_PAGE_SIZE (1 << NAMEMAP_PAGE_BITS)
+#define NAMEMAP_PAGE_COUNT 4096 // names below NAMEMAP_PAGE_SIZE * NAMEMAP_PAGE_COUNT are direct-indexed
+#define MAX_TEXTURE_UNITS 4096 // only used if the driver's actual limit can't be queried
 #define GAME_MINIMAP_BIG_SIZE 2048
 #define GAME_ITEM_ICON_SIZE 64
 #define GAME_ITEM_BIGICON_SIZE 512
-static struct GLContext contexts[CONTEXTS_CAPACITY];
+#define MODEL_HASH_CACHE_BITS 12 // the model hash cache is direct-mapped, with 2^this many entries
+
+// true if at least one running plugin has a handler for any of the given PLUGIN_EVENT_BITs. events
+// that fail this check don't need to be constructed at all, nor do their attributes need to be mirrored.
+#define EVENTS_SUBSCRIBED(BITS) (_bolt_plugin_subscribed_events() & (BITS))
+
+// every GLContext, keyed by native context handle. GLContexts are allocated individually, so pointers to
+// them (such as the ones in TLS) stay valid when the map grows.
+static struct {
+    struct hashmap* map;
+    RWLock lock;
+} contexts;
 
 // since GL contexts are bound only to the thread that binds them, we use thread-local storage (TLS)
 // to keep track of which context struct is relevant to each thread. One TLS slot can store exactly
@@ -407,7 +702,7 @@ struct GLPluginDrawElementsVertex3DUserData {
     struct GLContext* c;
     const unsigned short* indices;
     int atlas_scale;
-    const struct GLTexture2D* settings_atlas;
+    struct GLTexture2D* settings_atlas;
     const struct GLAttrBinding* xy_xz;
     const struct GLAttrBinding* xyz_bone;
     const struct GLAttrBinding* tex_uv;
@@ -415,13 +710,26 @@ struct GLPluginDrawElementsVertex3DUserData {
     const struct GLAttrBinding* skin_bones;
     const struct GLAttrBinding* skin_weights;
     const struct GLArrayBuffer* transforms_ubo;
+    uint32_t vertex_count;
 };
 
+// a previously-calculated render3d model hash, along with everything it was calculated from
+struct ModelHashCacheEntry {
+    uint64_t element_generation;
+    uint64_t vertex_generation;
+    uintptr_t index_offset;
+    uintptr_t attr_offset;
+    unsigned int attr_stride;
+    uint32_t vertex_count;
+    uint64_t hash;
+};
+static struct ModelHashCacheEntry model_hash_cache[1 << MODEL_HASH_CACHE_BITS];
+
 struct GLPluginDrawElementsVertexParticlesUserData {
     struct GLContext* c;
     const unsigned short* indices;
     int atlas_scale;
-    const struct GLTexture2D* settings_atlas;
+    struct GLTexture2D* settings_atlas;
     const struct GLAttrBinding* origin;
     const struct GLAttrBinding* offset;
     const struct GLAttrBinding* velocity;
@@ -440,7 +748,7 @@ struct GLPluginDrawElementsVertexBillboardUserData {
     struct GLContext* c;
     const unsigned short* indices;
     int atlas_scale;
-    const struct GLTexture2D* settings_atlas;
+    struct GLTexture2D* settings_atlas;
     const struct GLAttrBinding* vertex_position;
     const struct GLAttrBinding* billboard_size;
     const struct GLAttrBinding* vertex_colour;
@@ -596,42 +904,161 @@ static void set_context(struct GLContext* context) {
 #endif
 }
 
+// items in `contexts.map` are GLContext pointers, and a GLContext's first member is its id
+static int context_map_compare(const void* a, const void* b, void* udata) {
+    const uintptr_t x = **(const uintptr_t* const*)a;
+    const uintptr_t y = **(const uintptr_t* const*)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t context_map_hash(const void* item, uint64_t seed0, uint64_t seed1) {
+    const uintptr_t* const* const id = item;
+    return hashmap_murmur(*id, sizeof(uintptr_t), seed0, seed1);
+}
+
 static size_t context_count() {
-    size_t ret = 0;
-    for (size_t i = 0; i < CONTEXTS_CAPACITY; i += 1) {
-        if (contexts[i].id != 0) {
-            ret += 1;
-        }
-    }
+    _bolt_rwlock_lock_read(&contexts.lock);
+    const size_t ret = hashmap_count(contexts.map);
+    _bolt_rwlock_unlock_read(&contexts.lock);
+    return ret;
+}
+
+static struct GLContext* context_get_by_id(uintptr_t id) {
+    const uintptr_t* const id_ptr = &id;
+    _bolt_rwlock_lock_read(&contexts.lock);
+    struct GLContext* const* const ptr = hashmap_get(contexts.map, &id_ptr);
+    struct GLContext* const ret = ptr ? *ptr : NULL;
+    _bolt_rwlock_unlock_read(&contexts.lock);
     return ret;
 }
 
 static void context_create(void* egl_context, void* shared) {
-    for (size_t i = 0; i < CONTEXTS_CAPACITY; i += 1) {
-        struct GLContext* ptr = &contexts[i];
-        if (ptr->id == 0) {
-            context_init(ptr, egl_context, shared);
-            ptr->is_attached = 1;
-            return;
-        }
+    // the first context is always created before any of them can be made current, so nothing else
+    // can be using `contexts` at this point
+    if (!contexts.map) {
+        _bolt_rwlock_init(&contexts.lock);
+        contexts.map = hashmap_new(sizeof(struct GLContext*), 8, 0, 0, context_map_hash, context_map_compare, NULL, NULL);
     }
+    struct GLContext* context = malloc(sizeof(struct GLContext));
+    context_init(context, egl_context, shared ? context_get_by_id((uintptr_t)shared) : NULL);
+    context->is_attached = 1;
+    _bolt_rwlock_lock_write(&contexts.lock);
+    hashmap_set(contexts.map, &context);
+    _bolt_rwlock_unlock_write(&contexts.lock);
 }
 
 static void context_destroy(void* egl_context) {
-    for (size_t i = 0; i < CONTEXTS_CAPACITY; i += 1) {
-        struct GLContext* ptr = &contexts[i];
-        if (ptr->id == (uintptr_t)egl_context) {
-            if (ptr->is_attached) {
-                ptr->deferred_destroy = 1;
-            } else {
-                context_free(ptr);
-                ptr->id = 0;
-            }
-            break;
-        }
+    struct GLContext* const context = context_get_by_id((uintptr_t)egl_context);
+    if (!context) return;
+    if (context->is_attached) {
+        context->deferred_destroy = 1;
+        return;
+    }
+    _bolt_rwlock_lock_write(&contexts.lock);
+    hashmap_delete(contexts.map, &context);
+    _bolt_rwlock_unlock_write(&contexts.lock);
+    context_free(context);
+    free(context);
+}
+
+// sizes texture_units from the driver's limit. must be called with the context current.
+static void context_init_texture_units(struct GLContext* context) {
+    GLint count = 0;
+    if (lgl) lgl->GetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &count);
+    if (count <= 0) count = MAX_TEXTURE_UNITS;
+    context->texture_units = calloc(count, sizeof(struct TextureUnit));
+    context->texture_unit_count = count;
+}
+
+// -D BOLT_LIBRARY_TRACE=1
+// writes every call seen by the hooks, along with any data payload, to a binary trace file so that
+// real workloads can be studied offline, e.g. with test/replay.c. the path is taken from the
+// BOLT_GL_TRACE_PATH environment variable, falling back to "bolt-gl-trace.bin" in the working directory.
+// the file format is described in trace.h.
+#if defined(TRACE)
+#include "trace.h"
+
+static FILE* trace_file = NULL;
+static RWLock trace_lock;
+static uint8_t trace_lock_inited = false;
+
+static void trace_open() {
+    if (trace_file) return;
+    const char* path = getenv("BOLT_GL_TRACE_PATH");
+    if (!path || !*path) path = "bolt-gl-trace.bin";
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        printf("failed to open GL trace file '%s'\n", path);
+        return;
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+    const uint32_t version = TRACE_FORMAT_VERSION;
+    fwrite("BOLTTRCE", 1, 8, f);
+    fwrite(&version, sizeof(version), 1, f);
+    if (!trace_lock_inited) {
+        _bolt_rwlock_init(&trace_lock);
+        trace_lock_inited = true;
     }
+    trace_file = f;
+    printf("writing GL trace to '%s'\n", path);
 }
 
+static void trace_close() {
+    if (!trace_file) return;
+    _bolt_rwlock_lock_write(&trace_lock);
+    fclose(trace_file);
+    trace_file = NULL;
+    _bolt_rwlock_unlock_write(&trace_lock);
+}
+
+static void trace_write(enum TraceOp op, const uint64_t* args, size_t arg_count, const void* data, size_t data_len) {
+    if (!trace_file) return;
+    const struct GLContext* c = _bolt_context();
+    if (!data) data_len = 0;
+    struct TraceRecordHeader header = {
+        .op = (uint16_t)op,
+        .arg_count = (uint16_t)arg_count,
+        .data_len = (uint32_t)(data_len < TRACE_MAX_RECORD_DATA ? data_len : TRACE_MAX_RECORD_DATA),
+        .context = c ? (uint64_t)c->id : 0,
+        .timestamp_micros = 0,
+    };
+    _bolt_monotonic_microseconds(&header.timestamp_micros);
+    _bolt_rwlock_lock_write(&trace_lock);
+    if (!trace_file) {
+        // closed by another thread since the check above
+        _bolt_rwlock_unlock_write(&trace_lock);
+        return;
+    }
+    fwrite(&header, sizeof(header), 1, trace_file);
+    fwrite(args, sizeof(*args), arg_count, trace_file);
+    if (header.data_len) fwrite(data, 1, header.data_len, trace_file);
+    size_t written = header.data_len;
+    while (written < data_len) {
+        const size_t remaining = data_len - written;
+        header.op = TRACE_DATACONTINUATION;
+        header.arg_count = 0;
+        header.data_len = (uint32_t)(remaining < TRACE_MAX_RECORD_DATA ? remaining : TRACE_MAX_RECORD_DATA);
+        fwrite(&header, sizeof(header), 1, trace_file);
+        fwrite((const uint8_t*)data + written, 1, header.data_len, trace_file);
+        written += header.data_len;
+    }
+    if (op == TRACE_SWAPBUFFERS) fflush(trace_file);
+    _bolt_rwlock_unlock_write(&trace_lock);
+}
+
+// TRACE_CALL(OP, DATA, DATA_LEN, ARGS...) - every argument is widened to uint64 in the order given
+#define TRACE_CALL(OP, DATA, DATA_LEN, ...) { const uint64_t trace_args[] = {__VA_ARGS__}; trace_write(OP, trace_args, sizeof(trace_args) / sizeof(*trace_args), DATA, DATA_LEN); }
+// texture upload payloads are only client memory if no pixel unpack buffer is bound
+#define TRACE_UNPACK_DATA(C, PTR) ((C)->bound_pixel_unpack_buffer ? NULL : (PTR))
+#define TRACE_OPEN() trace_open();
+#define TRACE_CLOSE() trace_close();
+#else
+#define TRACE_CALL(...)
+#define TRACE_OPEN()
+#define TRACE_CLOSE()
+#endif
+
+#if !defined(BOLT_SSE2) || defined(BOLT_LIBRARY_TESTS)
 static float f16_to_f32(uint16_t bits) {
     const uint16_t bits_exp_component = (bits & 0b0111110000000000);
     if (bits_exp_component == 0) return 0.0f; // truncate subnormals to 0
@@ -641,143 +1068,249 @@ static float f16_to_f32(uint16_t bits) {
     const union { uint32_t b; float f; } u = {.b = sign_component | (exponent << 23) | (mantissa << 13)};
     return u.f;
 }
+#endif
 
-static uint8_t attr_get_binding(struct GLContext* c, const struct GLAttrBinding* binding, size_t index, size_t num_out, float* out) {
-    struct GLArrayBuffer* buffer = binding->buffer;
-    if (!buffer || !buffer->data) return 0;
-    uintptr_t buf_offset = binding->offset + (binding->stride * index);
+// converts `count` half-floats to floats, giving the same results as f16_to_f32. `in` doesn't need to be aligned.
+static void f16_to_f32_array(const uint8_t* in, size_t count, float* out) {
+#if defined(BOLT_SSE2)
+    // exponent and mantissa shift into place together, after which only the exponent bias needs adjusting
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sign_mask = _mm_set1_epi32(0x8000);
+    const __m128i exp_mask = _mm_set1_epi32(0x7C00);
+    const __m128i exp_mantissa_mask = _mm_set1_epi32(0x7FFF);
+    const __m128i bias = _mm_set1_epi32((127 - 15) << 23);
+    while (count) {
+        const size_t n = count < 4 ? count : 4;
+        uint16_t halves[4] = {0};
+        float floats[4];
+        memcpy(halves, in, n * sizeof(*halves));
+        const __m128i bits = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)halves), zero);
+        const __m128i is_subnormal = _mm_cmpeq_epi32(_mm_and_si128(bits, exp_mask), zero);
+        const __m128i sign = _mm_slli_epi32(_mm_and_si128(bits, sign_mask), 16);
+        const __m128i exp_mantissa = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(bits, exp_mantissa_mask), 13), bias);
+        _mm_storeu_ps(floats, _mm_castsi128_ps(_mm_andnot_si128(is_subnormal, _mm_or_si128(sign, exp_mantissa))));
+        memcpy(out, floats, n * sizeof(*out));
+        in += n * sizeof(*halves);
+        out += n;
+        count -= n;
+    }
+#else
+    for (size_t i = 0; i < count; i += 1) {
+        uint16_t bits;
+        memcpy(&bits, in + (i * sizeof(bits)), sizeof(bits));
+        out[i] = f16_to_f32(bits);
+    }
+#endif
+}
 
-    const uint8_t* ptr = (uint8_t*)buffer->data + buf_offset;
+// defines attr_decode_NAME, which reads `num_out` values of TYPE from `ptr` and converts each one `v` to a float with EXPR
+#define DEFATTRDECODER(NAME, TYPE, EXPR) \
+static void attr_decode_##NAME(const uint8_t* ptr, size_t num_out, float* out) { \
+    for (size_t i = 0; i < num_out; i += 1) { \
+        const TYPE v = *(TYPE*)(ptr + (i * sizeof(TYPE))); \
+        out[i] = EXPR; \
+    } \
+}
+
+// as above, but defines attr_decode_int_NAME, which converts to int32 instead
+#define DEFATTRDECODERINT(NAME, TYPE) \
+static void attr_decode_int_##NAME(const uint8_t* ptr, size_t num_out, int32_t* out) { \
+    for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(TYPE*)(ptr + (i * sizeof(TYPE))); \
+}
+
+static void attr_decode_float(const uint8_t* ptr, size_t num_out, float* out) {
+    memcpy(out, ptr, num_out * sizeof(float));
+}
+
+DEFATTRDECODER(ubyte, uint8_t, (float)v)
+DEFATTRDECODER(ushort, uint16_t, (float)v)
+DEFATTRDECODER(uint, uint32_t, (float)v)
+DEFATTRDECODER(byte, int8_t, (float)v)
+DEFATTRDECODER(short, int16_t, (float)v)
+DEFATTRDECODER(int, int32_t, (float)v)
+DEFATTRDECODER(ubyte_normalised, uint8_t, ((float)v) / 255.0)
+DEFATTRDECODER(ushort_normalised, uint16_t, ((float)v) / 65535.0)
+DEFATTRDECODER(uint_normalised, uint32_t, ((float)v) / 4294967295.0)
+DEFATTRDECODER(byte_normalised, int8_t, ((((float)v) + 128.0) * 2.0 / 255.0) - 1.0)
+DEFATTRDECODERINT(ubyte, uint8_t)
+DEFATTRDECODERINT(ushort, uint16_t)
+DEFATTRDECODERINT(uint, uint32_t)
+DEFATTRDECODERINT(byte, int8_t)
+DEFATTRDECODERINT(short, int16_t)
+DEFATTRDECODERINT(int, int32_t)
+
+#undef DEFATTRDECODER
+#undef DEFATTRDECODERINT
+
+// picks the decoders for a binding's type and normalisation, so that reading a vertex doesn't have to.
+// unsupported combinations get NULL decoders.
+static void attr_resolve_decoders(struct GLAttrBinding* binding) {
+    binding->decode = NULL;
+    binding->decode_int = NULL;
     if (!binding->normalise) {
         switch (binding->type) {
-            case GL_FLOAT:
-                memcpy(out, ptr, num_out * sizeof(float));
-                break;
-            case GL_HALF_FLOAT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = f16_to_f32(*(uint16_t*)(ptr + (i * 2)));
-                break;
-            case GL_UNSIGNED_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint8_t*)(ptr + i);
-                break;
-            case GL_UNSIGNED_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint16_t*)(ptr + (i * 2));
-                break;
-            case GL_UNSIGNED_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint32_t*)(ptr + (i * 4));
-                break;
-            case GL_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int8_t*)(ptr + i);
-                break;
-            case GL_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int16_t*)(ptr + (i * 2));
-                break;
-            case GL_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int32_t*)(ptr + (i * 4));
-                break;
-            default:
-                printf("warning: unsupported non-normalise type %u\n", binding->type);
-                memset(out, 0, num_out * sizeof(float));
-                break;
+            case GL_FLOAT: binding->decode = attr_decode_float; break;
+            case GL_HALF_FLOAT: binding->decode = f16_to_f32_array; break;
+            case GL_UNSIGNED_BYTE: binding->decode = attr_decode_ubyte; binding->decode_int = attr_decode_int_ubyte; break;
+            case GL_UNSIGNED_SHORT: binding->decode = attr_decode_ushort; binding->decode_int = attr_decode_int_ushort; break;
+            case GL_UNSIGNED_INT: binding->decode = attr_decode_uint; binding->decode_int = attr_decode_int_uint; break;
+            case GL_BYTE: binding->decode = attr_decode_byte; binding->decode_int = attr_decode_int_byte; break;
+            case GL_SHORT: binding->decode = attr_decode_short; binding->decode_int = attr_decode_int_short; break;
+            case GL_INT: binding->decode = attr_decode_int; binding->decode_int = attr_decode_int_int; break;
         }
     } else {
         switch (binding->type) {
-            case GL_FLOAT:
-                memcpy(out, ptr, num_out * sizeof(float));
-                break;
-            case GL_UNSIGNED_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint8_t*)(ptr + i)) / 255.0;
-                break;
-            case GL_UNSIGNED_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint16_t*)(ptr + (i * 2))) / 65535.0;
-                break;
-            case GL_UNSIGNED_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint32_t*)(ptr + (i * 4))) / 4294967295.0;
-                break;
-            case GL_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((((float)*(int8_t*)(ptr + i)) + 128.0) * 2.0 / 255.0) - 1.0;
-                break;
-            default:
-                printf("warning: unsupported normalise type %u\n", binding->type);
-                memset(out, 0, num_out * sizeof(float));
-                break;
+            case GL_FLOAT: binding->decode = attr_decode_float; break;
+            case GL_UNSIGNED_BYTE: binding->decode = attr_decode_ubyte_normalised; break;
+            case GL_UNSIGNED_SHORT: binding->decode = attr_decode_ushort_normalised; break;
+            case GL_UNSIGNED_INT: binding->decode = attr_decode_uint_normalised; break;
+            case GL_BYTE: binding->decode = attr_decode_byte_normalised; break;
         }
     }
-    return 1;
 }
 
-static uint8_t attr_get_binding_int(struct GLContext* c, const struct GLAttrBinding* binding, size_t index, size_t num_out, int32_t* out) {
+// decodes `num_out` values of a vertex attribute into `out`. if the binding's buffer can't be read, `out` is
+// zeroed and 0 is returned, so callers never see uninitialised values.
+static uint8_t attr_get_binding(struct GLContext* c, const struct GLAttrBinding* binding, size_t index, size_t num_out, float* out) {
     struct GLArrayBuffer* buffer = binding->buffer;
-    if (!buffer || !buffer->data) return 0;
+    if (!buffer || !buffer->data) {
+        memset(out, 0, num_out * sizeof(float));
+        return 0;
+    }
     uintptr_t buf_offset = binding->offset + (binding->stride * index);
 
     const uint8_t* ptr = (uint8_t*)buffer->data + buf_offset;
-    if (!binding->normalise) {
-        switch (binding->type) {
-            case GL_UNSIGNED_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(uint8_t*)(ptr + i);
-                break;
-            case GL_UNSIGNED_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(uint16_t*)(ptr + (i * 2));
-                break;
-            case GL_UNSIGNED_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(uint32_t*)(ptr + (i * 4));
-                break;
-            case GL_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(int8_t*)(ptr + i);
-                break;
-            case GL_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(int16_t*)(ptr + (i * 2));
-                break;
-            case GL_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(int32_t*)(ptr + (i * 4));
-                break;
-            default:
-                return 0;
-        }
+    if (binding->decode == attr_decode_float) {
+        // by far the most common type, and cheap enough that the indirect call would dominate
+        memcpy(out, ptr, num_out * sizeof(float));
+    } else if (binding->decode) {
+        binding->decode(ptr, num_out, out);
     } else {
+        printf("warning: unsupported %s type %u\n", binding->normalise ? "normalise" : "non-normalise", binding->type);
+        memset(out, 0, num_out * sizeof(float));
+    }
+    return 1;
+}
+
+static uint8_t attr_get_binding_int(struct GLContext* c, const struct GLAttrBinding* binding, size_t index, size_t num_out, int32_t* out) {
+    struct GLArrayBuffer* buffer = binding->buffer;
+    if (!buffer || !buffer->data || !binding->decode_int) return 0;
+    uintptr_t buf_offset = binding->offset + (binding->stride * index);
+    binding->decode_int((uint8_t*)buffer->data + buf_offset, num_out, out);
+    return 1;
+}
+
+// batch version of attr_get_binding: decodes `num_out` values for each of the `count` vertices listed in `indices`,
+// writing them one after another to `out`. the buffer and decoder are looked up once for the whole batch instead of
+// once per vertex. if the binding can't be read, `out` is zeroed and 0 is returned.
+static uint8_t attr_get_binding_batch(struct GLContext* c, const struct GLAttrBinding* binding, const unsigned short* indices, size_t count, size_t num_out, float* out) {
+    struct GLArrayBuffer* buffer = binding->buffer;
+    void (*decode)(const uint8_t*, size_t, float*) = binding->decode;
+    if (!buffer || !buffer->data || !decode) {
+        if (buffer && buffer->data) printf("warning: unsupported %s type %u\n", binding->normalise ? "normalise" : "non-normalise", binding->type);
+        memset(out, 0, count * num_out * sizeof(float));
         return 0;
     }
+    const uint8_t* base = (uint8_t*)buffer->data + binding->offset;
+    const uintptr_t stride = binding->stride;
+    if (decode == attr_decode_float) {
+        // as in attr_get_binding
+        const size_t size = num_out * sizeof(float);
+        for (size_t i = 0; i < count; i += 1) memcpy(out + (i * num_out), base + (stride * indices[i]), size);
+        return 1;
+    }
+    for (size_t i = 0; i < count; i += 1) {
+        decode(base + (stride * indices[i]), num_out, out + (i * num_out));
+    }
+    return 1;
+}
+
+// batch version of attr_get_binding_int. returns 0 without writing anything if the binding can't be read as integers.
+static uint8_t attr_get_binding_int_batch(struct GLContext* c, const struct GLAttrBinding* binding, const unsigned short* indices, size_t count, size_t num_out, int32_t* out) {
+    struct GLArrayBuffer* buffer = binding->buffer;
+    void (*decode_int)(const uint8_t*, size_t, int32_t*) = binding->decode_int;
+    if (!buffer || !buffer->data || !decode_int) return 0;
+    const uint8_t* base = (uint8_t*)buffer->data + binding->offset;
+    const uintptr_t stride = binding->stride;
+    for (size_t i = 0; i < count; i += 1) {
+        decode_int(base + (stride * indices[i]), num_out, out + (i * num_out));
+    }
     return 1;
 }
 
-static int glhashmap_compare(const void* a, const void* b, void* udata) {
+// items in a NameMap's overflow are pointers to structs whose first member is their GLuint name
+static int namemap_overflow_compare(const void* a, const void* b, void* udata) {
     return (**(GLuint**)a) - (**(GLuint**)b);
 }
 
-static uint64_t glhashmap_hash(const void* item, uint64_t seed0, uint64_t seed1) {
+static uint64_t namemap_overflow_hash(const void* item, uint64_t seed0, uint64_t seed1) {
     const GLuint* const* const id = item;
-    return hashmap_sip(*id, sizeof(GLuint), seed0, seed1);
+    return hashmap_murmur(*id, sizeof(GLuint), seed0, seed1);
 }
 
-static void glhashmap_init(struct HashMap* map, size_t cap) {
+static void namemap_init(struct NameMap* map) {
     _bolt_rwlock_init(&map->rwlock);
-    map->map = hashmap_new(sizeof(void*), cap, 0, 0, glhashmap_hash, glhashmap_compare, NULL, NULL);
+    map->pages = calloc(NAMEMAP_PAGE_COUNT, sizeof(*map->pages));
+    map->overflow = hashmap_new(sizeof(void*), 0, 0, 0, namemap_overflow_hash, namemap_overflow_compare, NULL, NULL);
 }
 
-static void glhashmap_destroy(struct HashMap* map) {
+static void namemap_destroy(struct NameMap* map) {
     _bolt_rwlock_destroy(&map->rwlock);
-    hashmap_free(map->map);
+    for (size_t i = 0; i < NAMEMAP_PAGE_COUNT; i += 1) {
+        free(map->pages[i]);
+    }
+    free(map->pages);
+    hashmap_free(map->overflow);
 }
 
-static void context_init(struct GLContext* context, void* egl_context, void* egl_shared) {
-    struct GLContext* shared = NULL;
-    if (egl_shared) {
-        for (size_t i = 0; i < CONTEXTS_CAPACITY; i += 1) {
-            struct GLContext* ptr = &contexts[i];
-            if (ptr->id == (uintptr_t)egl_shared) {
-                shared = ptr;
-                break;
-            }
-        }
+// `value` must point to a struct whose first member is its GLuint name, which must be `name`.
+// the caller must hold the map's write lock.
+static void namemap_set(struct NameMap* map, GLuint name, void* value) {
+    const size_t page_index = name >> NAMEMAP_PAGE_BITS;
+    if (page_index >= NAMEMAP_PAGE_COUNT) {
+        hashmap_set(map->overflow, &value);
+        return;
+    }
+    void** page = map->pages[page_index];
+    if (!page) {
+        page = calloc(NAMEMAP_PAGE_SIZE, sizeof(*page));
+        ATOMIC_STORE_PTR(&map->pages[page_index], page);
+    }
+    ATOMIC_STORE_PTR(&page[name & (NAMEMAP_PAGE_SIZE - 1)], value);
+}
+
+// removes a name from the map and returns what it was mapped to, or NULL if it wasn't in the map.
+// the caller must hold the map's write lock.
+static void* namemap_delete(struct NameMap* map, GLuint name) {
+    const size_t page_index = name >> NAMEMAP_PAGE_BITS;
+    if (page_index >= NAMEMAP_PAGE_COUNT) {
+        const GLuint* const name_ptr = &name;
+        void* const* const val = (void**)hashmap_delete(map->overflow, &name_ptr);
+        return val ? *val : NULL;
     }
+    void** const page = map->pages[page_index];
+    if (!page) return NULL;
+    void* const ret = page[name & (NAMEMAP_PAGE_SIZE - 1)];
+    ATOMIC_STORE_PTR(&page[name & (NAMEMAP_PAGE_SIZE - 1)], NULL);
+    return ret;
+}
+
+static void context_invalidate_attachments(struct GLContext* c) {
+    c->draw_attachments.colour = -1;
+    c->draw_attachments.depth = -1;
+    c->read_attachments.colour = -1;
+    c->read_attachments.depth = -1;
+}
+
+static void context_init(struct GLContext* context, void* egl_context, struct GLContext* shared) {
     memset(context, 0, sizeof(*context));
     context->id = (uintptr_t)egl_context;
-    context->texture_units = calloc(MAX_TEXTURE_UNITS, sizeof(struct TextureUnit));
     context->player_model_tex = -1;
     context->depth_tex = -1;
     context->game_view_part_framebuffer = -1;
     context->game_view_sSourceTex = -1;
     context->recalculate_depth_tex = true;
+    context_invalidate_attachments(context);
     context->blend_rgb_s = GL_ONE;
     //context->blend_rgb_d = GL_ZERO;
     context->blend_alpha_s = GL_ONE;
@@ -787,30 +1320,37 @@ static void context_init(struct GLContext* context, void* egl_context, void* egl
         context->buffers = shared->buffers;
         context->textures = shared->textures;
         context->vaos = shared->vaos;
+        context->texture_shadows = shared->texture_shadows;
     } else {
         context->is_shared_owner = 1;
-        context->programs = malloc(sizeof(struct HashMap));
-        glhashmap_init(context->programs, PROGRAM_LIST_CAPACITY);
-        context->buffers = malloc(sizeof(struct HashMap));
-        glhashmap_init(context->buffers, BUFFER_LIST_CAPACITY);
-        context->textures = malloc(sizeof(struct HashMap));
-        glhashmap_init(context->textures, TEXTURE_LIST_CAPACITY);
-        context->vaos = malloc(sizeof(struct HashMap));
-        glhashmap_init(context->vaos, VAO_LIST_CAPACITY);
+        context->programs = malloc(sizeof(struct NameMap));
+        namemap_init(context->programs);
+        context->buffers = malloc(sizeof(struct NameMap));
+        namemap_init(context->buffers);
+        context->textures = malloc(sizeof(struct NameMap));
+        namemap_init(context->textures);
+        context->vaos = malloc(sizeof(struct NameMap));
+        namemap_init(context->vaos);
+        context->texture_shadows = calloc(1, sizeof(struct TextureShadows));
+        _bolt_rwlock_init(&context->texture_shadows->rwlock);
+        const char* budget_mb = getenv("BOLT_TEXTURE_SHADOW_BUDGET_MB");
+        if (budget_mb) context->texture_shadows->budget = (size_t)strtoull(budget_mb, NULL, 10) * 1024 * 1024;
     }
 }
 
 static void context_free(struct GLContext* context) {
     free(context->texture_units);
     if (context->is_shared_owner) {
-        glhashmap_destroy(context->programs);
+        namemap_destroy(context->programs);
         free(context->programs);
-        glhashmap_destroy(context->buffers);
+        namemap_destroy(context->buffers);
         free(context->buffers);
-        glhashmap_destroy(context->textures);
+        namemap_destroy(context->textures);
         free(context->textures);
-        glhashmap_destroy(context->vaos);
+        namemap_destroy(context->vaos);
         free(context->vaos);
+        _bolt_rwlock_destroy(&context->texture_shadows->rwlock);
+        free(context->texture_shadows);
     }
 }
 
@@ -828,10 +1368,15 @@ static GLenum buffer_binding_enum(GLuint target) {
     }
 }
 
-static void* map_get(struct HashMap* map, GLuint index) {
+static void* map_get(struct NameMap* map, GLuint index) {
+    const size_t page_index = index >> NAMEMAP_PAGE_BITS;
+    if (page_index < NAMEMAP_PAGE_COUNT) {
+        void** const page = ATOMIC_LOAD_PTR(&map->pages[page_index]);
+        return page ? ATOMIC_LOAD_PTR(&page[index & (NAMEMAP_PAGE_SIZE - 1)]) : NULL;
+    }
     const GLuint* const index_ptr = &index;
     _bolt_rwlock_lock_read(&map->rwlock);
-    void* const* const val = (void**)hashmap_get(map->map, &index_ptr);
+    void* const* const val = (void**)hashmap_get(map->overflow, &index_ptr);
     void* const ret = val ? *val : NULL;
     _bolt_rwlock_unlock_read(&map->rwlock);
     return ret;
@@ -853,9 +1398,78 @@ static struct GLVertexArray* context_get_vao(const struct GLContext* c, GLuint i
     return map_get(c->vaos, index);
 }
 
-#define CONTEXT_GET_TEX_BINDING(C, INDEX, NAME) (context_get_texture(C, C->texture_units[INDEX].NAME))
+// returns the context's active texture unit, or NULL if it isn't one that this context tracks
+static struct TextureUnit* context_active_texture_unit(const struct GLContext* c) {
+    if ((GLuint)c->active_texture >= (GLuint)c->texture_unit_count) return NULL;
+    return &c->texture_units[c->active_texture];
+}
+
+#define CONTEXT_GET_TEX_BINDING(C, INDEX, NAME) ((GLuint)(INDEX) < (GLuint)C->texture_unit_count ? context_get_texture(C, C->texture_units[INDEX].NAME) : NULL)
 #define CONTEXT_GET_TEX_CURRENT(C, NAME) (CONTEXT_GET_TEX_BINDING(C, C->active_texture, NAME))
 
+// the functions below serve draw-time state lookups from what the hooks have already seen, since every
+// glGet* call is a potential round-trip to the driver. they only fall back to querying when the state
+// is outside of what we shadow.
+
+/// Gets the name of the buffer bound to one of the targets accepted by buffer_binding_enum.
+static GLuint context_bound_buffer(const struct GLContext* c, GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return c->bound_array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            // element array binding is VAO state
+            if (c->bound_vao) return c->bound_vao->element_buffer;
+            break;
+        case GL_UNIFORM_BUFFER:
+            return c->bound_uniform_buffer;
+    }
+    GLint ret = 0;
+    lgl->GetIntegerv(buffer_binding_enum(target), &ret);
+    return ret;
+}
+
+/// Gets the name of the uniform buffer backing a uniform block of the currently bound program.
+static GLuint context_uniform_block_buffer(const struct GLContext* c, GLuint block_index) {
+    const struct GLProgram* p = c->bound_program;
+    GLint binding;
+    if (block_index < PROGRAM_BLOCK_BINDINGS) {
+        binding = p->block_bindings[block_index];
+    } else {
+        gl.GetActiveUniformBlockiv(p->id, block_index, GL_UNIFORM_BLOCK_BINDING, &binding);
+    }
+    if (binding >= 0 && binding < MAX_UNIFORM_BUFFER_BINDINGS) return c->uniform_buffer_bindings[binding];
+    GLint ret = 0;
+    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, (GLuint)binding, &ret);
+    return ret;
+}
+
+/// Gets the name of the texture attached to the framebuffer bound to `target`, which must be either
+/// GL_DRAW_FRAMEBUFFER or GL_READ_FRAMEBUFFER. `attachment` must be either GL_COLOR_ATTACHMENT0 or
+/// GL_DEPTH_ATTACHMENT. Always returns 0 for the default framebuffer.
+static GLint context_framebuffer_attachment(struct GLContext* c, GLenum target, GLenum attachment) {
+    const uint8_t is_read = target == GL_READ_FRAMEBUFFER;
+    if ((is_read ? c->current_read_framebuffer : c->current_draw_framebuffer) == 0) return 0;
+    struct FramebufferAttachments* attachments = is_read ? &c->read_attachments : &c->draw_attachments;
+    GLint* value = attachment == GL_DEPTH_ATTACHMENT ? &attachments->depth : &attachments->colour;
+    if (*value == -1) {
+        *value = 0;
+        gl.GetFramebufferAttachmentParameteriv(target, attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, value);
+    }
+    return *value;
+}
+
+static void program_cache_uniform(struct GLProgram* p, GLint location, GLint value) {
+    if (location == -1) return;
+#define CACHE_UNIFORM(NAME) if (location == p->loc_##NAME) p->val_##NAME = value;
+    CACHE_UNIFORM(uDiffuseMap)
+    CACHE_UNIFORM(uTextureAtlas)
+    CACHE_UNIFORM(uTextureAtlasSettings)
+    CACHE_UNIFORM(sSceneHDRTex)
+    CACHE_UNIFORM(sSourceTex)
+    CACHE_UNIFORM(sTexture)
+#undef CACHE_UNIFORM
+}
+
 static void attr_set_binding(struct GLContext* c, struct GLAttrBinding* binding, unsigned int buffer, int size, const void* offset, unsigned int stride, uint32_t type, uint8_t normalise) {
     binding->buffer = context_get_buffer(c, buffer);
     binding->offset = (uintptr_t)offset;
@@ -863,15 +1477,197 @@ static void attr_set_binding(struct GLContext* c, struct GLAttrBinding* binding,
     binding->stride = stride;
     binding->normalise = normalise;
     binding->type = type;
+    attr_resolve_decoders(binding);
+}
+
+// shared by buffers and textures, which may be shared between contexts on different threads
+static uint64_t next_generation = 1;
+
+// counts calls to SwapBuffers, for things that should be done at most once per frame
+static uint64_t frame_number = 0;
+
+// should be called whenever a buffer's contents might have changed
+static void buffer_touch(struct GLArrayBuffer* buffer) {
+    buffer->generation = ATOMIC_ADD_U64(&next_generation, 1);
+}
+
+// should be called whenever a texture's contents might have changed, other than by rendering to it
+static void texture_touch(struct GLTexture2D* tex) {
+    tex->generation = ATOMIC_ADD_U64(&next_generation, 1);
+}
+
+// abandons a buffer's in-flight read-back, if any, along with whatever it was being put together with
+static void buffer_read_back_cancel(struct GLArrayBuffer* buffer) {
+    if (!buffer->readback_fence) return;
+    gl.DeleteSync(buffer->readback_fence);
+    buffer->readback_fence = NULL;
+    free(buffer->readback_data);
+    free(buffer->readback_written);
+    buffer->readback_data = NULL;
+    buffer->readback_written = NULL;
+}
+
+// handles a glBufferData or glBufferStorage call for a buffer
+static void buffer_set_storage(struct GLArrayBuffer* buffer, GLsizeiptr size, const void* data) {
+    buffer_touch(buffer);
+    buffer_read_back_cancel(buffer);
+    if (buffer->is_gl_mapped) {
+        // re-specifying a buffer's storage unmaps it
+        buffer->is_gl_mapped = false;
+        buffer->mapping = NULL;
+    }
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = size;
+    if (buffer->is_mirrored) {
+        buffer->data = malloc(size);
+        if (data) memcpy(buffer->data, data, size);
+    }
 }
 
-static void bone_index_transform(struct GLContext* c, const struct GLArrayBuffer** transforms_ubo, uint8_t bone_id, struct Transform3D* out) {
+// starts reading back part of a buffer without waiting for the GPU: the range is copied into a staging
+// buffer on the GPU, and buffer_read_back_poll reads that once a fence says the copy is done. anything
+// already in flight is superseded, since the new copy will include everything the old one would have.
+static void buffer_read_back_start(struct GLArrayBuffer* buffer, GLintptr offset, GLsizeiptr length) {
+    if (buffer->readback_fence) {
+        gl.DeleteSync(buffer->readback_fence);
+        free(buffer->readback_written);
+    }
+    GLint copy_read, copy_write;
+    lgl->GetIntegerv(GL_COPY_READ_BUFFER_BINDING, &copy_read);
+    lgl->GetIntegerv(GL_COPY_WRITE_BUFFER_BINDING, &copy_write);
+    if (!buffer->readback_buffer) gl.GenBuffers(1, &buffer->readback_buffer);
+    gl.BindBuffer(GL_COPY_READ_BUFFER, buffer->id);
+    gl.BindBuffer(GL_COPY_WRITE_BUFFER, buffer->readback_buffer);
+    gl.BufferData(GL_COPY_WRITE_BUFFER, length, NULL, GL_STREAM_READ);
+    gl.CopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, length);
+    gl.BindBuffer(GL_COPY_READ_BUFFER, copy_read);
+    gl.BindBuffer(GL_COPY_WRITE_BUFFER, copy_write);
+    buffer->readback_fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    buffer->readback_offset = offset;
+    buffer->readback_len = length;
+    buffer->readback_written = calloc(length, 1);
+    buffer->readback_frame = frame_number;
+}
+
+// finishes a buffer's in-flight read-back if the GPU is done with it, or regardless if `wait` is set, in
+// which case reading it stalls until it is. bytes that hooks have written since it started are kept.
+static void buffer_read_back_poll(struct GLArrayBuffer* buffer, uint8_t wait) {
+    if (!buffer->readback_fence) return;
+    if (!wait) {
+        const GLenum status = gl.ClientWaitSync(buffer->readback_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+    }
+    uint8_t* const landed = malloc(buffer->readback_len);
+    GLint copy_read;
+    lgl->GetIntegerv(GL_COPY_READ_BUFFER_BINDING, &copy_read);
+    gl.BindBuffer(GL_COPY_READ_BUFFER, buffer->readback_buffer);
+    gl.GetBufferSubData(GL_COPY_READ_BUFFER, 0, buffer->readback_len, landed);
+    gl.BindBuffer(GL_COPY_READ_BUFFER, copy_read);
+    uint8_t* const dest = (buffer->data ? (uint8_t*)buffer->data : buffer->readback_data) + buffer->readback_offset;
+    uint8_t changed = buffer->readback_data != NULL;
+    for (GLsizeiptr i = 0; i < buffer->readback_len; i += 1) {
+        if (buffer->readback_written[i] || dest[i] == landed[i]) continue;
+        dest[i] = landed[i];
+        changed = true;
+    }
+    free(landed);
+    gl.DeleteSync(buffer->readback_fence);
+    free(buffer->readback_written);
+    buffer->readback_fence = NULL;
+    buffer->readback_written = NULL;
+    if (buffer->readback_data) {
+        buffer->data = buffer->readback_data;
+        buffer->readback_data = NULL;
+    }
+    if (changed) buffer_touch(buffer);
+}
+
+// copies something written through the hooks into a mirrored buffer's contents, including into an
+// in-flight read-back's, and marks it so that the read-back won't overwrite it when it lands
+static void buffer_write(struct GLArrayBuffer* buffer, GLintptr offset, GLsizeiptr length, const void* src) {
+    uint8_t* const dest = buffer->data ? (uint8_t*)buffer->data : buffer->readback_data;
+    if (!dest) return;
+    memcpy(dest + offset, src, length);
+    if (!buffer->readback_written) return;
+    const GLintptr start = offset > buffer->readback_offset ? offset : buffer->readback_offset;
+    const GLintptr end = (offset + length) < (buffer->readback_offset + buffer->readback_len) ? (offset + length) : (buffer->readback_offset + buffer->readback_len);
+    if (start < end) memset(buffer->readback_written + (start - buffer->readback_offset), 1, end - start);
+}
+
+// picks up writes through a persistent mapping of a mirrored buffer, since those never pass through the
+// hooks. a readable mapping is just read through. otherwise the mapped range gets read back asynchronously,
+// which is done at most once per frame unless `force` is set, i.e. when the game has flushed or unmapped.
+static void buffer_refresh_persistent(struct GLArrayBuffer* buffer, uint8_t force) {
+    if (buffer->mapping_access_type & GL_MAP_READ_BIT) {
+        const uint8_t* const current = buffer->data ? (uint8_t*)buffer->data : buffer->readback_data;
+        if (!current || !memcmp(current + buffer->mapping_offset, buffer->mapping, buffer->mapping_len)) return;
+        buffer_write(buffer, buffer->mapping_offset, buffer->mapping_len, buffer->mapping);
+        buffer_touch(buffer);
+        return;
+    }
+    if (!force && (buffer->readback_fence || buffer->readback_frame == frame_number)) return;
+    // a first read-back can't be narrowed down to the mapped range, or the rest would never arrive
+    if (buffer->readback_data) buffer_read_back_start(buffer, 0, buffer->size);
+    else buffer_read_back_start(buffer, buffer->mapping_offset, buffer->mapping_len);
+}
+
+/// Starts keeping `buffer->data` in sync with the buffer's contents, if it wasn't already. If the buffer
+/// already has contents on the GPU, they're read back asynchronously, and `data` stays NULL until that's
+/// landed in a later call. Draw handlers must check `data` before using it, for that reason and because
+/// a buffer that's mapped without GL_MAP_PERSISTENT_BIT can't be mirrored until it's unmapped.
+static void buffer_mirror(struct GLContext* c, struct GLArrayBuffer* buffer) {
+    if (!buffer) return;
+    const uint8_t is_persistent = buffer->is_gl_mapped && (buffer->mapping_access_type & GL_MAP_PERSISTENT_BIT);
+    if (buffer->is_mirrored) {
+        buffer_read_back_poll(buffer, false);
+        if (is_persistent) buffer_refresh_persistent(buffer, false);
+        return;
+    }
+    if (buffer->is_gl_mapped && !is_persistent) {
+        // GL doesn't allow a buffer to be used while it has a non-persistent mapping, so it can't be drawn
+        // from before it's unmapped; it'll be mirrored then instead
+        buffer->mirror_after_unmap = true;
+        return;
+    }
+    // persistent mappings may never be unmapped, but GL allows copying from the buffer while they exist
+    buffer->is_mirrored = true;
+    buffer->mirror_after_unmap = false;
+    buffer_touch(buffer);
+    if (buffer->size <= 0) return;
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->readback_data = malloc(buffer->size);
+    buffer_read_back_start(buffer, 0, buffer->size);
+}
+
+// returns a buffer's mirrored contents, or NULL if there's no such buffer or its contents aren't known.
+// draw handlers must give up on a draw if this is NULL for any buffer they need.
+static const uint8_t* context_buffer_data(const struct GLContext* c, GLuint id) {
+    const struct GLArrayBuffer* buffer = context_get_buffer(c, id);
+    return buffer ? buffer->data : NULL;
+}
+
+// called before handling a draw, since the event handlers may read any of the bound VAO's attributes.
+// returns false if the contents of any enabled attribute's buffer aren't available, in which case the
+// draw can't be handled.
+static uint8_t vao_mirror_attributes(struct GLContext* c, struct GLVertexArray* vao) {
+    uint8_t ret = true;
+    for (GLint i = 0; i < vao->attribute_count; i += 1) {
+        if (!vao->attributes[i].enabled) continue;
+        struct GLArrayBuffer* buffer = vao->attributes[i].buffer;
+        buffer_mirror(c, buffer);
+        if (!buffer || (!buffer->data && buffer->size > 0)) ret = false;
+    }
+    return ret;
+}
+
+// returns false, leaving `out` unset, if the bone transforms buffer's contents aren't available
+static uint8_t bone_index_transform(struct GLContext* c, const struct GLArrayBuffer** transforms_ubo, uint8_t bone_id, struct Transform3D* out) {
     if (!*transforms_ubo) {
-        GLint ubo_binding, ubo_index;
-        gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_VertexTransformData, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-        gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_index);
-        *transforms_ubo = context_get_buffer(c, ubo_index);
+        *transforms_ubo = context_get_buffer(c, context_uniform_block_buffer(c, c->bound_program->block_index_VertexTransformData));
     }
+    if (!*transforms_ubo || !(*transforms_ubo)->data) return false;
     const uint8_t* ubo_transforms_buf = (uint8_t*)((*transforms_ubo)->data);
     const float* values = (float*)(ubo_transforms_buf + c->bound_program->offset_uBoneTransforms) + (bone_id * 12);
     out->matrix[0] = (double)values[0];
@@ -890,10 +1686,13 @@ static void bone_index_transform(struct GLContext* c, const struct GLArrayBuffer
     out->matrix[13] = (double)values[10];
     out->matrix[14] = (double)values[11];
     out->matrix[15] = 1.0;
+    return true;
 }
 
-// multiplies the rows of `left` with the columns of `right`
-static void multiply_transforms(const struct Transform3D* left, const struct Transform3D* right, struct Transform3D* out) {
+#if !defined(BOLT_SSE2) || defined(BOLT_LIBRARY_TESTS)
+// multiplies the rows of `left` with the columns of `right`. used where SSE2 isn't available, and by the tests
+// as the reference for multiply_transforms_sse2.
+static void multiply_transforms_scalar(const struct Transform3D* left, const struct Transform3D* right, struct Transform3D* out) {
     for (size_t row = 0; row < 4; row += 1) {
         for (size_t col = 0; col < 4; col += 1) {
             out->matrix[4 * row + col] =
@@ -905,26 +1704,497 @@ static void multiply_transforms(const struct Transform3D* left, const struct Tra
     }
 }
 
-static void unpack_rgb565(uint16_t packed, uint8_t out[3]) {
-    out[0] = (packed >> 11) & 0b00011111;
-    out[0] = (out[0] << 3) | (out[0] >> 2);
-    out[1] = (packed >> 5) & 0b00111111;
-    out[1] = (out[1] << 2) | (out[1] >> 4);
-    out[2] = packed & 0b00011111;
-    out[2] = (out[2] << 3) | (out[2] >> 2);
+// sums four transforms, each scaled by its weight, as done for smooth skinning
+static void blend_transforms_scalar(const struct Transform3D transforms[4], const float weights[4], struct Transform3D* out) {
+    for (size_t i = 0; i < 16; i += 1) {
+        out->matrix[i] =
+            transforms[0].matrix[i] * weights[0] +
+            transforms[1].matrix[i] * weights[1] +
+            transforms[2].matrix[i] * weights[2] +
+            transforms[3].matrix[i] * weights[3];
+    }
+}
+#endif
+
+#if defined(BOLT_SSE2)
+// SSE2 version of multiply_transforms_scalar. each output row is a sum of the rows of `right`, scaled by the
+// elements of the matching row of `left`. the products are added in the same order as the scalar version, so
+// the results are bit-identical.
+static void multiply_transforms_sse2(const struct Transform3D* left, const struct Transform3D* right, struct Transform3D* out) {
+    const __m128d right_lo[4] = {
+        _mm_loadu_pd(&right->matrix[0]), _mm_loadu_pd(&right->matrix[4]),
+        _mm_loadu_pd(&right->matrix[8]), _mm_loadu_pd(&right->matrix[12]),
+    };
+    const __m128d right_hi[4] = {
+        _mm_loadu_pd(&right->matrix[2]), _mm_loadu_pd(&right->matrix[6]),
+        _mm_loadu_pd(&right->matrix[10]), _mm_loadu_pd(&right->matrix[14]),
+    };
+    for (size_t row = 0; row < 4; row += 1) {
+        __m128d factor = _mm_set1_pd(left->matrix[row * 4]);
+        __m128d lo = _mm_mul_pd(factor, right_lo[0]);
+        __m128d hi = _mm_mul_pd(factor, right_hi[0]);
+        for (size_t i = 1; i < 4; i += 1) {
+            factor = _mm_set1_pd(left->matrix[row * 4 + i]);
+            lo = _mm_add_pd(lo, _mm_mul_pd(factor, right_lo[i]));
+            hi = _mm_add_pd(hi, _mm_mul_pd(factor, right_hi[i]));
+        }
+        _mm_storeu_pd(&out->matrix[row * 4], lo);
+        _mm_storeu_pd(&out->matrix[row * 4 + 2], hi);
+    }
+}
+
+// SSE2 version of blend_transforms_scalar, also bit-identical
+static void blend_transforms_sse2(const struct Transform3D transforms[4], const float weights[4], struct Transform3D* out) {
+    const __m128d w[4] = {
+        _mm_set1_pd((double)weights[0]), _mm_set1_pd((double)weights[1]),
+        _mm_set1_pd((double)weights[2]), _mm_set1_pd((double)weights[3]),
+    };
+    for (size_t i = 0; i < 16; i += 2) {
+        __m128d sum = _mm_mul_pd(_mm_loadu_pd(&transforms[0].matrix[i]), w[0]);
+        sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(&transforms[1].matrix[i]), w[1]));
+        sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(&transforms[2].matrix[i]), w[2]));
+        sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(&transforms[3].matrix[i]), w[3]));
+        _mm_storeu_pd(&out->matrix[i], sum);
+    }
+}
+#endif
+
+static void multiply_transforms(const struct Transform3D* left, const struct Transform3D* right, struct Transform3D* out) {
+#if defined(BOLT_SSE2)
+    multiply_transforms_sse2(left, right, out);
+#else
+    multiply_transforms_scalar(left, right, out);
+#endif
+}
+
+static void blend_transforms(const struct Transform3D transforms[4], const float weights[4], struct Transform3D* out) {
+#if defined(BOLT_SSE2)
+    blend_transforms_sse2(transforms, weights, out);
+#else
+    blend_transforms_scalar(transforms, weights, out);
+#endif
+}
+
+static void unpack_rgb565(uint16_t packed, uint8_t out[3]) {
+    out[0] = (packed >> 11) & 0b00011111;
+    out[0] = (out[0] << 3) | (out[0] >> 2);
+    out[1] = (packed >> 5) & 0b00111111;
+    out[1] = (out[1] << 2) | (out[1] >> 4);
+    out[2] = packed & 0b00011111;
+    out[2] = (out[2] << 3) | (out[2] >> 2);
+}
+
+// use a lookup table for each of the possible 5-bit and 6-bit values for consistency across platforms
+// `lut5 = [round(pow(((x << 3) | (x >> 2)) / 255.0, 2.2) * 255.0) for x in range(32)]`
+// `lut6 = [round(pow(((x << 2) | (x >> 4)) / 255.0, 2.2) * 255.0) for x in range(64)]`
+//const uint8_t lut5[] = {0, 0, 1, 1, 3, 5, 7, 9, 13, 17, 21, 26, 32, 38, 44, 51, 60, 68, 77, 87, 98, 109, 120, 132, 146, 159, 173, 188, 205, 221, 238, 255};
+//const uint8_t lut6[] = {0, 0, 0, 0, 1, 1, 1, 2, 3, 3, 4, 5, 6, 8, 9, 11, 13, 14, 16, 18, 20, 23, 25, 28, 30, 33, 36, 39, 43, 46, 49, 53, 58, 62, 66, 70, 75, 79, 84, 89, 94, 99, 105, 110, 116, 121, 127, 133, 141, 148, 154, 161, 168, 175, 182, 190, 197, 205, 213, 221, 229, 238, 246, 255};
+static void unpack_srgb565(uint16_t packed, uint8_t out[3]) {
+    // game seems to be giving us RGBA and telling us it's SRGB, so for now, just don't convert it
+    unpack_rgb565(packed, out);
+    //out[0] = lut5[(packed >> 11) & 0b00011111];
+    //out[1] = lut6[(packed >> 5) & 0b00111111];
+    //out[2] = lut5[packed & 0b00011111];
+}
+
+// S3TC/DXT block decoding for glCompressedTexSubImage2D. each block's colour (and alpha) palette is built
+// once, then every pixel just selects from it. where SSE2 is available the selection is done with mask
+// blends, one row of four pixels at a time; otherwise a scalar loop is used, which gives identical output.
+
+enum DXTAlphaMode {
+    DXT_ALPHA_NONE,         // DXT1 with no alpha channel, always opaque
+    DXT_ALPHA_PUNCHTHROUGH, // DXT1 with alpha, where colour code 3 is transparent if c0 <= c1
+    DXT_ALPHA_EXPLICIT,     // DXT3, 4 bits of alpha per pixel
+    DXT_ALPHA_INTERPOLATED, // DXT5, 3-bit codes into an 8-entry alpha palette
+};
+
+static void dxt_colour_palette(const uint8_t* cptr, void (*unpack565)(uint16_t, uint8_t*), enum DXTAlphaMode mode, uint8_t palette[4][4]) {
+    const uint16_t c0 = cptr[0] + (cptr[1] << 8);
+    const uint16_t c1 = cptr[2] + (cptr[3] << 8);
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    for (size_t i = 0; i < 3; i += 1) {
+        const uint16_t v0 = palette[0][i];
+        const uint16_t v1 = palette[1][i];
+        if (c0 > c1) {
+            palette[2][i] = ((2 * v0) + v1) / 3;
+            palette[3][i] = ((2 * v1) + v0) / 3;
+        } else {
+            palette[2][i] = (v0 + v1) / 2;
+            palette[3][i] = 0;
+        }
+    }
+    for (size_t i = 0; i < 4; i += 1) palette[i][3] = 0xFF;
+    // black means zero alpha
+    if (mode == DXT_ALPHA_PUNCHTHROUGH && c0 <= c1) palette[3][3] = 0;
+}
+
+static void dxt_alpha_palette(const uint8_t* ptr, uint8_t palette[8]) {
+    const uint16_t alpha0 = ptr[0];
+    const uint16_t alpha1 = ptr[1];
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    if (alpha0 > alpha1) {
+        for (uint16_t code = 2; code < 8; code += 1) {
+            palette[code] = (((8 - code) * alpha0) + ((code - 1) * alpha1)) / 7;
+        }
+    } else {
+        for (uint16_t code = 2; code < 6; code += 1) {
+            palette[code] = (((6 - code) * alpha0) + ((code - 1) * alpha1)) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 0xFF;
+    }
+}
+
+#if defined(BOLT_SSE2)
+// per-lane equivalent of `mask ? a : b`
+static __m128i dxt_select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// broadcasts `bits` to all four lanes and returns a mask of which lanes have their bit set in `lane_bits`
+static __m128i dxt_bit_mask(__m128i bits, __m128i lane_bits) {
+    return _mm_cmpeq_epi32(_mm_and_si128(bits, lane_bits), lane_bits);
+}
+#endif
+
+// everything about a block which its pixels select from, read once per block
+struct DXTBlock {
+    uint8_t colours[4][4];
+    uint8_t alphas[8];
+    uint32_t ctable;
+    uint64_t atable;
+};
+
+static void dxt_read_block(const uint8_t* block, enum DXTAlphaMode mode, void (*unpack565)(uint16_t, uint8_t*), struct DXTBlock* out) {
+    const uint8_t has_alpha_chunk = mode == DXT_ALPHA_EXPLICIT || mode == DXT_ALPHA_INTERPOLATED;
+    const uint8_t* cptr = has_alpha_chunk ? (block + 8) : block;
+    dxt_colour_palette(cptr, unpack565, mode, out->colours);
+    if (mode == DXT_ALPHA_INTERPOLATED) dxt_alpha_palette(block, out->alphas);
+    out->ctable = (uint32_t)cptr[4] + ((uint32_t)cptr[5] << 8) + ((uint32_t)cptr[6] << 16) + ((uint32_t)cptr[7] << 24);
+    out->atable = block[2] + ((uint64_t)block[3] << 8) + ((uint64_t)block[4] << 16) + ((uint64_t)block[5] << 24) + ((uint64_t)block[6] << 32) + ((uint64_t)block[7] << 40);
+}
+
+#if !defined(BOLT_SSE2) || defined(BOLT_LIBRARY_TESTS)
+/// Decodes one 4x4 S3TC block into 16 RGBA pixels, in row-major order, one pixel at a time.
+/// Used where SSE2 isn't available, and by the tests as the reference for dxt_decode_block_sse2.
+static void dxt_decode_block_scalar(const uint8_t* block, enum DXTAlphaMode mode, void (*unpack565)(uint16_t, uint8_t*), uint8_t out[64]) {
+    struct DXTBlock b;
+    dxt_read_block(block, mode, unpack565, &b);
+    for (size_t i = 0; i < 16; i += 1) {
+        uint8_t* pixel_ptr = out + (i * 4);
+        memcpy(pixel_ptr, b.colours[(b.ctable >> (i * 2)) & 0b11], 4);
+        if (mode == DXT_ALPHA_EXPLICIT) {
+            pixel_ptr[3] = ((block[i / 2] >> ((i & 1) ? 4 : 0)) & 0b1111) * 17;
+        } else if (mode == DXT_ALPHA_INTERPOLATED) {
+            pixel_ptr[3] = b.alphas[(b.atable >> (i * 3)) & 0b111];
+        }
+    }
+}
+#endif
+
+#if defined(BOLT_SSE2)
+/// SSE2 version of dxt_decode_block_scalar, which gives identical output.
+static void dxt_decode_block_sse2(const uint8_t* block, enum DXTAlphaMode mode, void (*unpack565)(uint16_t, uint8_t*), uint8_t out[64]) {
+    struct DXTBlock b;
+    dxt_read_block(block, mode, unpack565, &b);
+    // one pixel per 32-bit lane. a row's codes are broadcast to every lane, then each lane tests its own
+    // bits of the code to build the masks used to pick from the palette. x86 is little-endian, so a
+    // palette entry loaded as uint32_t is already in RGBA byte order.
+    uint32_t cpal[4];
+    memcpy(cpal, b.colours, sizeof(cpal));
+    const __m128i colour0 = _mm_set1_epi32(cpal[0]);
+    const __m128i colour1 = _mm_set1_epi32(cpal[1]);
+    const __m128i colour2 = _mm_set1_epi32(cpal[2]);
+    const __m128i colour3 = _mm_set1_epi32(cpal[3]);
+    const __m128i cbit0 = _mm_setr_epi32(1 << 0, 1 << 2, 1 << 4, 1 << 6);
+    const __m128i cbit1 = _mm_setr_epi32(1 << 1, 1 << 3, 1 << 5, 1 << 7);
+    const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+
+    for (size_t j = 0; j < 4; j += 1) {
+        const __m128i cbits = _mm_set1_epi32((b.ctable >> (j * 8)) & 0xFF);
+        const __m128i cm0 = dxt_bit_mask(cbits, cbit0);
+        const __m128i cm1 = dxt_bit_mask(cbits, cbit1);
+        __m128i row = dxt_select(cm1, dxt_select(cm0, colour3, colour2), dxt_select(cm0, colour1, colour0));
+        if (mode == DXT_ALPHA_EXPLICIT) {
+            const uint32_t abits = block[j * 2] + ((uint32_t)block[(j * 2) + 1] << 8);
+            const __m128i alpha = _mm_setr_epi32(
+                (abits & 0b1111) * 17, ((abits >> 4) & 0b1111) * 17,
+                ((abits >> 8) & 0b1111) * 17, ((abits >> 12) & 0b1111) * 17
+            );
+            row = _mm_or_si128(_mm_and_si128(row, rgb_mask), _mm_slli_epi32(alpha, 24));
+        } else if (mode == DXT_ALPHA_INTERPOLATED) {
+            // an 8-way select costs more than looking the four codes up directly
+            const uint32_t abits = (uint32_t)((b.atable >> (j * 12)) & 0xFFF);
+            const __m128i alpha = _mm_setr_epi32(
+                b.alphas[abits & 0b111], b.alphas[(abits >> 3) & 0b111],
+                b.alphas[(abits >> 6) & 0b111], b.alphas[(abits >> 9) & 0b111]
+            );
+            row = _mm_or_si128(_mm_and_si128(row, rgb_mask), _mm_slli_epi32(alpha, 24));
+        }
+        _mm_storeu_si128((__m128i*)(out + (j * 16)), row);
+    }
+}
+#endif
+
+/// Decodes one 4x4 S3TC block into 16 RGBA pixels, in row-major order.
+static void dxt_decode_block(const uint8_t* block, enum DXTAlphaMode mode, void (*unpack565)(uint16_t, uint8_t*), uint8_t out[64]) {
+#if defined(BOLT_SSE2)
+    dxt_decode_block_sse2(block, mode, unpack565, out);
+#else
+    dxt_decode_block_scalar(block, mode, unpack565, out);
+#endif
+}
+
+// gets the block layout for an S3TC format, returning false if it isn't one
+static uint8_t dxt_format_info(GLenum format, enum DXTAlphaMode* mode, uint8_t* is_srgb) {
+    switch (format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            *mode = DXT_ALPHA_NONE;
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            *mode = DXT_ALPHA_PUNCHTHROUGH;
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+            *mode = DXT_ALPHA_EXPLICIT;
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            *mode = DXT_ALPHA_INTERPOLATED;
+            break;
+        default:
+            return false;
+    }
+    *is_srgb = (format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT);
+    return true;
+}
+
+static size_t dxt_block_size(enum DXTAlphaMode mode) {
+    return (mode == DXT_ALPHA_NONE || mode == DXT_ALPHA_PUNCHTHROUGH) ? 8 : 16;
+}
+
+static void texture_free_compressed(struct GLTexture2D* tex) {
+    free(tex->compressed);
+    free(tex->compressed_state);
+    tex->compressed = NULL;
+    tex->compressed_state = NULL;
+    tex->compressed_pending = 0;
+}
+
+/// Makes sure the given region of `tex->data` is up-to-date by decoding any compressed blocks which
+/// overlap it and haven't been decoded yet. If `overwrite` is true, the caller is about to replace
+/// the whole region, so blocks lying entirely inside it get discarded instead of decoded. The region
+/// is clipped to the texture.
+static void texture_decode_region(struct GLTexture2D* tex, GLint x, GLint y, GLint w, GLint h, uint8_t overwrite) {
+    if (!tex || !tex->compressed_pending || !tex->data) return;
+    enum DXTAlphaMode mode;
+    uint8_t is_srgb;
+    if (!dxt_format_info(tex->compressed_format, &mode, &is_srgb)) return;
+    const GLint x_end = (x + w) > tex->width ? tex->width : (x + w);
+    const GLint y_end = (y + h) > tex->height ? tex->height : (y + h);
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x >= x_end || y >= y_end) return;
+    const size_t input_stride = dxt_block_size(mode);
+    void (*const unpack565)(uint16_t, uint8_t*) = is_srgb ? unpack_srgb565 : unpack_rgb565;
+    const GLint blocks_x = (tex->width + 3) / 4;
+    uint8_t pixels[64];
+    for (GLint by = y / 4; by < (y_end + 3) / 4; by += 1) {
+        for (GLint bx = x / 4; bx < (x_end + 3) / 4; bx += 1) {
+            const size_t index = ((size_t)by * blocks_x) + bx;
+            if (tex->compressed_state[index] != COMPRESSED_BLOCK_PENDING) continue;
+            tex->compressed_state[index] = COMPRESSED_BLOCK_DECODED;
+            tex->compressed_pending -= 1;
+            const GLint block_x = bx * 4;
+            const GLint block_y = by * 4;
+            const GLint block_w = (block_x + 4) > tex->width ? (tex->width - block_x) : 4;
+            const GLint block_h = (block_y + 4) > tex->height ? (tex->height - block_y) : 4;
+            if (overwrite && block_x >= x && block_y >= y && block_x + block_w <= x_end && block_y + block_h <= y_end) continue;
+            dxt_decode_block(tex->compressed + (index * input_stride), mode, unpack565, pixels);
+            for (GLint j = 0; j < block_h; j += 1) {
+                memcpy(tex->data + (((size_t)(block_y + j) * tex->width) + block_x) * 4, pixels + (j * 16), block_w * 4);
+            }
+        }
+    }
+    // once everything has been decoded, a pinned shadow has no reason to keep the block data around
+    if (!tex->compressed_pending && tex->is_shadow_pinned) texture_free_compressed(tex);
+}
+
+// like texture_decode_region, but for a byte range of `data`, which may span multiple rows
+static void texture_decode_bytes(struct GLTexture2D* tex, size_t offset, size_t len) {
+    if (!tex || !tex->compressed_pending || !len || !tex->width) return;
+    const size_t row_len = (size_t)tex->width * 4;
+    const size_t first_row = offset / row_len;
+    const size_t last_row = (offset + len - 1) / row_len;
+    if (first_row == last_row) {
+        const size_t first_x = (offset % row_len) / 4;
+        const size_t last_x = ((offset + len - 1) % row_len) / 4;
+        texture_decode_region(tex, first_x, first_row, (last_x - first_x) + 1, 1, false);
+    } else {
+        texture_decode_region(tex, 0, first_row, tex->width, (last_row - first_row) + 1, false);
+    }
+}
+
+static size_t texture_shadow_size(const struct GLTexture2D* tex) {
+    return (size_t)tex->width * (size_t)tex->height * 4;
+}
+
+static void texture_shadow_unlist(struct TextureShadows* s, struct GLTexture2D* tex) {
+    if (!tex->is_lru_listed) return;
+    if (tex->lru_prev) tex->lru_prev->lru_next = tex->lru_next;
+    else s->lru_head = tex->lru_next;
+    if (tex->lru_next) tex->lru_next->lru_prev = tex->lru_prev;
+    else s->lru_tail = tex->lru_prev;
+    tex->lru_prev = NULL;
+    tex->lru_next = NULL;
+    tex->is_lru_listed = false;
+}
+
+static void texture_shadow_list(struct TextureShadows* s, struct GLTexture2D* tex) {
+    tex->lru_prev = NULL;
+    tex->lru_next = s->lru_head;
+    if (s->lru_head) s->lru_head->lru_prev = tex;
+    else s->lru_tail = tex;
+    s->lru_head = tex;
+    tex->is_lru_listed = true;
+}
+
+// evicts shadows from the least-recently-used end of the list until the share group is within budget
+static void texture_shadow_enforce_budget(struct TextureShadows* s) {
+    if (!s->budget || s->bytes <= s->budget) return;
+    uint64_t evictions = 0;
+    size_t evicted_bytes = 0;
+    while (s->bytes > s->budget && s->lru_tail) {
+        struct GLTexture2D* tex = s->lru_tail;
+        const size_t size = texture_shadow_size(tex);
+        texture_shadow_unlist(s, tex);
+        free(tex->data);
+        tex->data = NULL;
+        tex->is_shadow_evicted = true;
+        s->bytes -= size;
+        evictions += 1;
+        evicted_bytes += size;
+    }
+    s->evictions += evictions;
+    s->evicted_bytes += evicted_bytes;
+    if (evictions) LOGF("texture shadows: evicted %llu (%llu bytes)\n", (unsigned long long)evictions, (unsigned long long)evicted_bytes);
+}
+
+/// Allocates a fresh, zeroed shadow for a texture after glTexStorage2D or similar, replacing any
+/// previous one, and evicts other shadows if that takes the share group over its budget.
+static void texture_shadow_alloc(struct GLContext* c, struct GLTexture2D* tex, GLsizei width, GLsizei height) {
+    struct TextureShadows* s = c->texture_shadows;
+    _bolt_rwlock_lock_write(&s->rwlock);
+    if (tex->data) s->bytes -= texture_shadow_size(tex);
+    free(tex->data);
+    texture_free_compressed(tex);
+    tex->width = width;
+    tex->height = height;
+    tex->data = calloc(texture_shadow_size(tex), sizeof(*tex->data));
+    tex->is_shadow_written = false;
+    tex->is_shadow_evicted = false;
+    s->bytes += texture_shadow_size(tex);
+    texture_shadow_unlist(s, tex);
+    if (!tex->is_shadow_pinned) texture_shadow_list(s, tex);
+    texture_shadow_enforce_budget(s);
+    _bolt_rwlock_unlock_write(&s->rwlock);
+}
+
+/// Frees a texture's shadow, for when the texture is being deleted.
+static void texture_shadow_free(struct GLContext* c, struct GLTexture2D* tex) {
+    struct TextureShadows* s = c->texture_shadows;
+    _bolt_rwlock_lock_write(&s->rwlock);
+    if (tex->data) s->bytes -= texture_shadow_size(tex);
+    texture_shadow_unlist(s, tex);
+    _bolt_rwlock_unlock_write(&s->rwlock);
+    free(tex->data);
+    tex->data = NULL;
+    texture_free_compressed(tex);
+}
+
+// reads a region of a texture's level 0 back from the GPU, through a temporary framebuffer, into `out`,
+// which is tightly packed. this waits for the GPU to finish writing to the texture, so it's only done
+// when a shadow is needed and can't be had any other way.
+static void texture_read_region(const struct GLContext* c, const struct GLTexture2D* tex, GLint x, GLint y, GLsizei w, GLsizei h, uint8_t* out) {
+    GLint pack_buffer;
+    GLuint framebuffer;
+    lgl->GetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack_buffer);
+    if (pack_buffer) gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    gl.GenFramebuffers(1, &framebuffer);
+    gl.BindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    gl.FramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex->id, 0);
+    lgl->ReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, out);
+    gl.BindFramebuffer(GL_READ_FRAMEBUFFER, c->current_read_framebuffer);
+    gl.DeleteFramebuffers(1, &framebuffer);
+    if (pack_buffer) gl.BindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffer);
+}
+
+// re-creates an evicted shadow. S3TC textures can't be read back from the GPU, so their blocks are just
+// marked as pending again, to be decoded when needed. otherwise, if anything was ever written to the
+// texture, the contents are read back from the GPU. must be called with the shadows lock held.
+static void texture_shadow_restore(struct GLContext* c, struct GLTexture2D* tex) {
+    struct TextureShadows* s = c->texture_shadows;
+    tex->data = calloc(texture_shadow_size(tex), sizeof(*tex->data));
+    tex->is_shadow_evicted = false;
+    s->bytes += texture_shadow_size(tex);
+    s->restores += 1;
+    if (tex->compressed) {
+        const size_t blocks = (size_t)((tex->width + 3) / 4) * (size_t)((tex->height + 3) / 4);
+        tex->compressed_pending = 0;
+        for (size_t i = 0; i < blocks; i += 1) {
+            if (tex->compressed_state[i] == COMPRESSED_BLOCK_EMPTY) continue;
+            tex->compressed_state[i] = COMPRESSED_BLOCK_PENDING;
+            tex->compressed_pending += 1;
+        }
+        return;
+    }
+    if (!tex->is_shadow_written || tex->is_multisample) return;
+    texture_read_region(c, tex, 0, 0, tex->width, tex->height, tex->data);
 }
 
-// use a lookup table for each of the possible 5-bit and 6-bit values for consistency across platforms
-// `lut5 = [round(pow(((x << 3) | (x >> 2)) / 255.0, 2.2) * 255.0) for x in range(32)]`
-// `lut6 = [round(pow(((x << 2) | (x >> 4)) / 255.0, 2.2) * 255.0) for x in range(64)]`
-//const uint8_t lut5[] = {0, 0, 1, 1, 3, 5, 7, 9, 13, 17, 21, 26, 32, 38, 44, 51, 60, 68, 77, 87, 98, 109, 120, 132, 146, 159, 173, 188, 205, 221, 238, 255};
-//const uint8_t lut6[] = {0, 0, 0, 0, 1, 1, 1, 2, 3, 3, 4, 5, 6, 8, 9, 11, 13, 14, 16, 18, 20, 23, 25, 28, 30, 33, 36, 39, 43, 46, 49, 53, 58, 62, 66, 70, 75, 79, 84, 89, 94, 99, 105, 110, 116, 121, 127, 133, 141, 148, 154, 161, 168, 175, 182, 190, 197, 205, 213, 221, 229, 238, 246, 255};
-static void unpack_srgb565(uint16_t packed, uint8_t out[3]) {
-    // game seems to be giving us RGBA and telling us it's SRGB, so for now, just don't convert it
-    unpack_rgb565(packed, out);
-    //out[0] = lut5[(packed >> 11) & 0b00011111];
-    //out[1] = lut6[(packed >> 5) & 0b00111111];
-    //out[2] = lut5[packed & 0b00011111];
+/// Takes the shadows lock. Any thread touching a shadow can evict any other unpinned one, so this must
+/// be held for as long as `data` of an unpinned texture is being used, not just while touching it.
+static void texture_shadow_lock(struct GLContext* c) {
+    _bolt_rwlock_lock_write(&c->texture_shadows->rwlock);
+}
+
+/// Releases the shadows lock, first evicting shadows if anything done under it went over the budget.
+static void texture_shadow_unlock(struct GLContext* c) {
+    texture_shadow_enforce_budget(c->texture_shadows);
+    _bolt_rwlock_unlock_write(&c->texture_shadows->rwlock);
+}
+
+/// Marks a texture's shadow as recently used, restoring it first if it was evicted and `restore` is
+/// true. Returns whether the shadow is present, i.e. whether `tex->data` can be used until the lock is
+/// released. Must be called with the shadows lock held.
+static uint8_t texture_shadow_touch(struct GLContext* c, struct GLTexture2D* tex, uint8_t restore) {
+    if (!tex->is_shadow_evicted && !tex->is_lru_listed) return tex->data != NULL;
+    if (tex->is_shadow_evicted && !restore) return false;
+    struct TextureShadows* s = c->texture_shadows;
+    texture_shadow_unlist(s, tex);
+    if (tex->is_shadow_evicted) texture_shadow_restore(c, tex);
+    if (!tex->is_shadow_pinned) texture_shadow_list(s, tex);
+    return tex->data != NULL;
+}
+
+// like texture_shadow_pin, but must be called with the shadows lock held
+static void texture_shadow_pin_locked(struct GLContext* c, struct GLTexture2D* tex) {
+    if (tex->is_shadow_pinned) return;
+    tex->is_shadow_pinned = true;
+    texture_shadow_touch(c, tex, true);
+}
+
+/// Stops a texture's shadow from ever being evicted, restoring it if it already was. This is done for
+/// any texture which is given to a plugin event, or which could be read by one later on.
+static void texture_shadow_pin(struct GLContext* c, struct GLTexture2D* tex) {
+    if (!tex) return;
+    texture_shadow_lock(c);
+    texture_shadow_pin_locked(c, tex);
+    texture_shadow_unlock(c);
 }
 
 static void update_gameview_overlay(const struct GLContext* c) {
@@ -950,8 +2220,8 @@ static void update_gameview_overlay(const struct GLContext* c) {
     lgl->TexParameteri(GL_TEXTURE_2D,  GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     gl.FramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, gameview_overlay_tex, 0);
 
-    const struct TextureUnit* unit = &c->texture_units[c->active_texture];
-    lgl->BindTexture(unit->target, unit->recent);
+    const struct TextureUnit* unit = context_active_texture_unit(c);
+    if (unit) lgl->BindTexture(unit->target, unit->recent);
     gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, c->current_draw_framebuffer);
 }
 
@@ -986,8 +2256,8 @@ static void draw_gameview_overlay(const struct GLContext* c) {
     if (cull_face) lgl->Enable(GL_CULL_FACE);
     if (!blend) lgl->Disable(GL_BLEND);
     lgl->Viewport(c->viewport_x, c->viewport_y, c->viewport_w, c->viewport_h);
-    const struct TextureUnit* unit = &c->texture_units[c->active_texture];
-    lgl->BindTexture(unit->target, unit->recent);
+    const struct TextureUnit* unit = context_active_texture_unit(c);
+    if (unit) lgl->BindTexture(unit->target, unit->recent);
     gl.BindVertexArray(c->bound_vao->id);
     gl.UseProgram(c->bound_program ? c->bound_program->id : 0);
 }
@@ -1004,6 +2274,8 @@ static void gl_load(void* (*GetProcAddress)(const char*)) {
     INIT_GL_FUNC(AttachShader)
     INIT_GL_FUNC(BindAttribLocation)
     INIT_GL_FUNC(BindBuffer)
+    INIT_GL_FUNC(BindBufferBase)
+    INIT_GL_FUNC(BindBufferRange)
     INIT_GL_FUNC(BindFramebuffer)
     INIT_GL_FUNC(BindVertexArray)
     INIT_GL_FUNC(BlendFuncSeparate)
@@ -1011,8 +2283,10 @@ static void gl_load(void* (*GetProcAddress)(const char*)) {
     INIT_GL_FUNC(BufferData)
     INIT_GL_FUNC(BufferStorage)
     INIT_GL_FUNC(BufferSubData)
+    INIT_GL_FUNC(ClientWaitSync)
     INIT_GL_FUNC(CompileShader)
     INIT_GL_FUNC(CompressedTexSubImage2D)
+    INIT_GL_FUNC(CopyBufferSubData)
     INIT_GL_FUNC(CopyImageSubData)
     INIT_GL_FUNC(CreateProgram)
     INIT_GL_FUNC(CreateShader)
@@ -1020,17 +2294,22 @@ static void gl_load(void* (*GetProcAddress)(const char*)) {
     INIT_GL_FUNC(DeleteFramebuffers)
     INIT_GL_FUNC(DeleteProgram)
     INIT_GL_FUNC(DeleteShader)
+    INIT_GL_FUNC(DeleteSync)
     INIT_GL_FUNC(DeleteVertexArrays)
     INIT_GL_FUNC(DetachShader)
     INIT_GL_FUNC(DisableVertexAttribArray)
     INIT_GL_FUNC(EnableVertexAttribArray)
+    INIT_GL_FUNC(FenceSync)
     INIT_GL_FUNC(FlushMappedBufferRange)
+    INIT_GL_FUNC(FramebufferRenderbuffer)
     INIT_GL_FUNC(FramebufferTexture)
+    INIT_GL_FUNC(FramebufferTexture2D)
     INIT_GL_FUNC(FramebufferTextureLayer)
     INIT_GL_FUNC(GenBuffers)
     INIT_GL_FUNC(GenFramebuffers)
     INIT_GL_FUNC(GenVertexArrays)
     INIT_GL_FUNC(GetActiveUniformBlockiv)
+    INIT_GL_FUNC(GetBufferSubData)
     INIT_GL_FUNC(GetActiveUniformsiv)
     INIT_GL_FUNC(GetFramebufferAttachmentParameteriv)
     INIT_GL_FUNC(GetIntegeri_v)
@@ -1065,6 +2344,7 @@ static void gl_load(void* (*GetProcAddress)(const char*)) {
     INIT_GL_FUNC(Uniform2iv)
     INIT_GL_FUNC(Uniform3iv)
     INIT_GL_FUNC(Uniform4iv)
+    INIT_GL_FUNC(UniformBlockBinding)
     INIT_GL_FUNC(UniformMatrix2fv)
     INIT_GL_FUNC(UniformMatrix3fv)
     INIT_GL_FUNC(UniformMatrix4fv)
@@ -1158,14 +2438,29 @@ static void gl_init() {
     gl.EnableVertexAttribArray(0);
     gl.VertexAttribPointer(0, 2, GL_FLOAT, 0, 2 * sizeof(float), NULL);
     gl.BindVertexArray(0);
+    gl.BindBuffer(GL_ARRAY_BUFFER, _bolt_context()->bound_array_buffer);
 }
 
 void _bolt_gl_close() {
+    for (size_t i = 0; i < screen_readback_pool_count; i += 1) {
+        gl.DeleteBuffers(1, &screen_readback_pool[i]->buffer);
+        free(screen_readback_pool[i]);
+    }
+    screen_readback_pool_count = 0;
+    if (screen_capture_scale_fb) {
+        gl.DeleteFramebuffers(1, &screen_capture_scale_fb);
+        lgl->DeleteTextures(1, &screen_capture_scale_tex);
+        screen_capture_scale_fb = 0;
+        screen_capture_scale_tex = 0;
+        screen_capture_scale_width = 0;
+        screen_capture_scale_height = 0;
+    }
     gl.DeleteBuffers(1, &buffer_vertices_square);
     gl.DeleteProgram(program_direct_screen.id);
     gl.DeleteProgram(program_direct_surface.id);
     gl.DeleteVertexArrays(1, &program_direct_vao);
     context_destroy((void*)egl_main_context);
+    TRACE_CLOSE()
 }
 
 /* glproc function hooks */
@@ -1173,6 +2468,7 @@ void _bolt_gl_close() {
 static GLuint glCreateProgram() {
     LOG("glCreateProgram\n");
     GLuint id = gl.CreateProgram();
+    TRACE_CALL(TRACE_CREATEPROGRAM, NULL, 0, id)
     struct GLContext* c = _bolt_context();
     struct GLProgram* program = malloc(sizeof(struct GLProgram));
     program->id = id;
@@ -1225,8 +2521,15 @@ static GLuint glCreateProgram() {
     program->is_minimap = 0;
     program->is_particle = 0;
     program->is_billboard = 0;
+    program->val_uDiffuseMap = 0;
+    program->val_uTextureAtlas = 0;
+    program->val_uTextureAtlasSettings = 0;
+    program->val_sSceneHDRTex = 0;
+    program->val_sSourceTex = 0;
+    program->val_sTexture = 0;
+    memset(program->block_bindings, 0, sizeof(program->block_bindings));
     _bolt_rwlock_lock_write(&c->programs->rwlock);
-    hashmap_set(c->programs->map, &program);
+    namemap_set(c->programs, id, program);
     _bolt_rwlock_unlock_write(&c->programs->rwlock);
     LOG("glCreateProgram end\n");
     return id;
@@ -1234,11 +2537,10 @@ static GLuint glCreateProgram() {
 
 static void glDeleteProgram(GLuint program) {
     LOG("glDeleteProgram\n");
+    TRACE_CALL(TRACE_DELETEPROGRAM, NULL, 0, program)
     struct GLContext* c = _bolt_context();
-    unsigned int* ptr = &program;
     _bolt_rwlock_lock_write(&c->programs->rwlock);
-    struct GLProgram* const* p = hashmap_delete(c->programs->map, &ptr);
-    free(*p);
+    free(namemap_delete(c->programs, program));
     _bolt_rwlock_unlock_write(&c->programs->rwlock);
     gl.DeleteProgram(program);
     LOG("glDeleteProgram end\n");
@@ -1247,6 +2549,7 @@ static void glDeleteProgram(GLuint program) {
 static void glBindAttribLocation(GLuint program, GLuint index, const GLchar* name) {
     LOG("glBindAttribLocation\n");
     gl.BindAttribLocation(program, index, name);
+    TRACE_CALL(TRACE_BINDATTRIBLOCATION, name, strlen(name), program, index)
     struct GLContext* c = _bolt_context();
     struct GLProgram* p = context_get_program(c, program);
 #define ATTRIB_MAP(NAME) if (!strcmp(name, #NAME)) p->loc_##NAME = index;
@@ -1274,6 +2577,7 @@ static void glBindAttribLocation(GLuint program, GLuint index, const GLchar* nam
 
 static void glLinkProgram(GLuint program) {
     LOG("glLinkProgram\n");
+    TRACE_CALL(TRACE_LINKPROGRAM, NULL, 0, program)
     gl.LinkProgram(program);
     struct GLContext* c = _bolt_context();
     struct GLProgram* p = context_get_program(c, program);
@@ -1314,6 +2618,21 @@ static void glLinkProgram(GLuint program) {
         p->loc_sSourceTex = gl.GetUniformLocation(program, "sSourceTex");
         p->loc_sBlurFarTex = gl.GetUniformLocation(program, "sBlurFarTex");
         p->loc_sTexture = gl.GetUniformLocation(program, "sTexture");
+        // linking resets uniforms to their initial values, which may have been set in the shader source
+#define INIT_UNIFORM(NAME) p->val_##NAME = 0; if (p->loc_##NAME != -1) gl.GetUniformiv(program, p->loc_##NAME, &p->val_##NAME);
+        INIT_UNIFORM(uDiffuseMap)
+        INIT_UNIFORM(uTextureAtlas)
+        INIT_UNIFORM(uTextureAtlasSettings)
+        INIT_UNIFORM(sSceneHDRTex)
+        INIT_UNIFORM(sSourceTex)
+        INIT_UNIFORM(sTexture)
+#undef INIT_UNIFORM
+        GLint block_count = 0;
+        gl.GetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &block_count);
+        for (GLint i = 0; i < PROGRAM_BLOCK_BINDINGS; i += 1) {
+            p->block_bindings[i] = 0;
+            if (i < block_count) gl.GetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_BINDING, &p->block_bindings[i]);
+        }
         if (block_index_ViewTransforms != -1 && block_index_TerrainConsts != -1) {
             p->block_index_ViewTransforms = block_index_ViewTransforms;
             p->offset_uCameraPosition = ViewTransforms_offsets[0];
@@ -1380,6 +2699,7 @@ static void glLinkProgram(GLuint program) {
 static void glUseProgram(GLuint program) {
     LOG("glUseProgram\n");
     gl.UseProgram(program);
+    TRACE_CALL(TRACE_USEPROGRAM, NULL, 0, program)
     struct GLContext* c = _bolt_context();
     c->bound_program = context_get_program(c, program);
     LOG("glUseProgram end\n");
@@ -1388,16 +2708,15 @@ static void glUseProgram(GLuint program) {
 static void glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
     LOG("glTexStorage2D\n");
     gl.TexStorage2D(target, levels, internalformat, width, height);
+    TRACE_CALL(TRACE_TEXSTORAGE2D, NULL, 0, target, levels, internalformat, width, height)
     struct GLContext* c = _bolt_context();
     if (target == GL_TEXTURE_2D) {
         struct GLTexture2D* tex = CONTEXT_GET_TEX_CURRENT(c, texture_2d);
         if (tex) {
-            free(tex->data);
-            tex->data = calloc(width * height * 4, sizeof(*tex->data));
+            texture_shadow_alloc(c, tex, width, height);
             tex->internalformat = internalformat;
-            tex->width = width;
-            tex->height = height;
             tex->icon.model_count = 0;
+            texture_touch(tex);
         }
     }
     LOG("glTexStorage2D end\n");
@@ -1406,17 +2725,16 @@ static void glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat,
 static void glTexStorage2DMultisample(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations) {
     LOG("glTexStorage2DMultisample\n");
     gl.TexStorage2DMultisample(target, levels, internalformat, width, height, fixedsamplelocations);
+    TRACE_CALL(TRACE_TEXSTORAGE2DMULTISAMPLE, NULL, 0, target, levels, internalformat, width, height, fixedsamplelocations)
     struct GLContext* c = _bolt_context();
     if (target == GL_TEXTURE_2D_MULTISAMPLE) {
         struct GLTexture2D* tex = CONTEXT_GET_TEX_CURRENT(c, texture_2d_multisample);
         if (tex) {
-            free(tex->data);
-            tex->data = calloc(width * height * 4, sizeof(*tex->data));
+            tex->is_multisample = true;
+            texture_shadow_alloc(c, tex, width, height);
             tex->internalformat = internalformat;
-            tex->width = width;
-            tex->height = height;
             tex->icon.model_count = 0;
-            tex->is_multisample = true;
+            texture_touch(tex);
         }
     }
     LOG("glTexStorage2DMultisample end\n");
@@ -1425,22 +2743,22 @@ static void glTexStorage2DMultisample(GLenum target, GLsizei levels, GLenum inte
 static void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalised, GLsizei stride, const void* pointer) {
     LOG("glVertexAttribPointer\n");
     gl.VertexAttribPointer(index, size, type, normalised, stride, pointer);
+    TRACE_CALL(TRACE_VERTEXATTRIBPOINTER, NULL, 0, index, size, type, normalised, stride, (uintptr_t)pointer)
     struct GLContext* c = _bolt_context();
-    GLint array_binding;
-    lgl->GetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_binding);
-    attr_set_binding(c, &c->bound_vao->attributes[index], array_binding, size, pointer, stride, type, normalised);
+    attr_set_binding(c, &c->bound_vao->attributes[index], c->bound_array_buffer, size, pointer, stride, type, normalised);
     LOG("glVertexAttribPointer end\n");
 }
 
 static void glGenBuffers(GLsizei n, GLuint* buffers) {
     LOG("glGenBuffers\n");
     gl.GenBuffers(n, buffers);
+    TRACE_CALL(TRACE_GENBUFFERS, buffers, n * sizeof(*buffers), n)
     struct GLContext* c = _bolt_context();
     _bolt_rwlock_lock_write(&c->buffers->rwlock);
     for (GLsizei i = 0; i < n; i += 1) {
         struct GLArrayBuffer* buffer = calloc(1, sizeof(struct GLArrayBuffer));
         buffer->id = buffers[i];
-        hashmap_set(c->buffers->map, &buffer);
+        namemap_set(c->buffers, buffer->id, buffer);
     }
     _bolt_rwlock_unlock_write(&c->buffers->rwlock);
     LOG("glGenBuffers end\n");
@@ -1449,30 +2767,40 @@ static void glGenBuffers(GLsizei n, GLuint* buffers) {
 static void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
     LOG("glBufferData\n");
     gl.BufferData(target, size, data, usage);
+    TRACE_CALL(TRACE_BUFFERDATA, data, size, target, size, usage)
+    PROFILE_START()
     struct GLContext* c = _bolt_context();
     GLenum binding_type = buffer_binding_enum(target);
     if (binding_type != -1) {
-        GLint buffer_id;
-        lgl->GetIntegerv(binding_type, &buffer_id);
-        void* buffer_content = malloc(size);
-        if (data) memcpy(buffer_content, data, size);
+        const GLuint buffer_id = context_bound_buffer(c, target);
         struct GLArrayBuffer* buffer = context_get_buffer(c, buffer_id);
-        free(buffer->data);
-        buffer->data = buffer_content;
+        buffer_set_storage(buffer, size, data);
     }
+    PROFILE_END(PROFILE_BUFFERDATA)
     LOG("glBufferData end\n");
 }
 
 static void glDeleteBuffers(GLsizei n, const GLuint* buffers) {
     LOG("glDeleteBuffers\n");
+    TRACE_CALL(TRACE_DELETEBUFFERS, buffers, n * sizeof(*buffers), n)
     struct GLContext* c = _bolt_context();
     _bolt_rwlock_lock_write(&c->buffers->rwlock);
     for (GLsizei i = 0; i < n; i += 1) {
-        const GLuint* ptr = &buffers[i];
-        struct GLArrayBuffer* const* buffer = hashmap_delete(c->buffers->map, &ptr);
-        free((*buffer)->data);
-        free((*buffer)->mapping);
-        free(*buffer);
+        // deleting a buffer unbinds it from everywhere it's bound in the current context
+        if (c->bound_array_buffer == buffers[i]) c->bound_array_buffer = 0;
+        if (c->bound_uniform_buffer == buffers[i]) c->bound_uniform_buffer = 0;
+        if (c->bound_pixel_unpack_buffer == buffers[i]) c->bound_pixel_unpack_buffer = 0;
+        if (c->bound_vao && c->bound_vao->element_buffer == buffers[i]) c->bound_vao->element_buffer = 0;
+        for (size_t j = 0; j < MAX_UNIFORM_BUFFER_BINDINGS; j += 1) {
+            if (c->uniform_buffer_bindings[j] == buffers[i]) c->uniform_buffer_bindings[j] = 0;
+        }
+        struct GLArrayBuffer* buffer = namemap_delete(c->buffers, buffers[i]);
+        if (!buffer) continue;
+        buffer_read_back_cancel(buffer);
+        if (buffer->readback_buffer) gl.DeleteBuffers(1, &buffer->readback_buffer);
+        free(buffer->data);
+        if (!buffer->is_gl_mapped) free(buffer->mapping);
+        free(buffer);
     }
     _bolt_rwlock_unlock_write(&c->buffers->rwlock);
     gl.DeleteBuffers(n, buffers);
@@ -1483,145 +2811,79 @@ static void glBindFramebuffer(GLenum target, GLuint framebuffer) {
     LOG("glBindFramebuffer\n");
     gl.BindFramebuffer(target, framebuffer);
     struct GLContext* c = _bolt_context();
-    switch (target) {
-        case GL_READ_FRAMEBUFFER:
-            c->current_read_framebuffer = framebuffer;
-            break;
-        case GL_DRAW_FRAMEBUFFER:
-            c->current_draw_framebuffer = framebuffer;
-            break;
-        case GL_FRAMEBUFFER:
-            c->current_read_framebuffer = framebuffer;
-            c->current_draw_framebuffer = framebuffer;
-            break;
+    TRACE_CALL(TRACE_BINDFRAMEBUFFER, NULL, 0, target, framebuffer)
+    if ((target == GL_READ_FRAMEBUFFER || target == GL_FRAMEBUFFER) && c->current_read_framebuffer != framebuffer) {
+        c->current_read_framebuffer = framebuffer;
+        c->read_attachments.colour = -1;
+        c->read_attachments.depth = -1;
+    }
+    if ((target == GL_DRAW_FRAMEBUFFER || target == GL_FRAMEBUFFER) && c->current_draw_framebuffer != framebuffer) {
+        c->current_draw_framebuffer = framebuffer;
+        c->draw_attachments.colour = -1;
+        c->draw_attachments.depth = -1;
     }
     LOG("glBindFramebuffer end\n");
 }
 
-// https://www.khronos.org/opengl/wiki/S3_Texture_Compression
-static void glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data) {
-    LOG("glCompressedTexSubImage2D\n");
-    gl.CompressedTexSubImage2D(target, level, xoffset, yoffset, width, height, format, imageSize, data);
-    if (target != GL_TEXTURE_2D || level != 0 || width <= 0 || height <= 0) return;
-    const uint8_t is_dxt1 = (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT);
-    const uint8_t is_srgb = (format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT);
-    const size_t input_stride = is_dxt1 ? 8 : 16;
-    void (*const unpack565)(uint16_t, uint8_t*) = is_srgb ? unpack_srgb565 : unpack_rgb565;
-    struct GLContext* c = _bolt_context();
+// records an S3TC upload to level 0 of the bound GL_TEXTURE_2D, for glCompressedTexSubImage2D
+static void texture_compressed_sub_image(struct GLContext* c, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data) {
+    if (width <= 0 || height <= 0) return;
+    enum DXTAlphaMode mode;
+    uint8_t is_srgb;
+    if (!dxt_format_info(format, &mode, &is_srgb)) return;
     struct GLTexture2D* tex = CONTEXT_GET_TEX_CURRENT(c, texture_2d);
     if (!tex) return;
-    GLint out_xoffset = xoffset;
-    GLint out_yoffset = yoffset;
-    for (size_t ii = 0; ii < ((size_t)width * (size_t)height); ii += input_stride) {
-        const uint8_t* ptr = (uint8_t*)data + ii;
-        const uint8_t* cptr = is_dxt1 ? ptr : (ptr + 8);
-        uint8_t* out_ptr = tex->data + (out_yoffset * tex->width * 4) + (out_xoffset * 4);
-        uint16_t c0 = cptr[0] + (cptr[1] << 8);
-        uint16_t c1 = cptr[2] + (cptr[3] << 8);
-        uint8_t c0_rgb[3];
-        uint8_t c1_rgb[3];
-        unpack565(c0, c0_rgb);
-        unpack565(c1, c1_rgb);
-        const uint8_t c0_greater = c0 > c1;
-        const uint32_t ctable = (uint32_t)cptr[4] + ((uint32_t)cptr[5] << 8) + ((uint32_t)cptr[6] << 16) + ((uint32_t)cptr[7] << 24);
-        const uint8_t alpha0 = ptr[0];
-        const uint8_t alpha1 = ptr[1];
-        const uint8_t a0_greater = alpha0 > alpha1;
-        const uint64_t atable = ptr[2] + ((uint64_t)ptr[3] << 8) + ((uint64_t)ptr[4] << 16) + ((uint64_t)ptr[5] << 24) + ((uint64_t)ptr[6] << 32) + ((uint64_t)ptr[7] << 40);
-
-        for (size_t j = 0; j < 4; j += 1) {
-            for (size_t i = 0; i < 4; i += 1) {
-                if (out_xoffset + i >= 0 && out_yoffset + j >= 0 && out_xoffset + i < tex->width && out_yoffset + j < tex->height) {
-                    uint8_t* pixel_ptr = out_ptr + (tex->width * j * 4) + (i * 4);
-                    uint8_t pixel_index = (4 * j) + i;
-                    const uint8_t code = (ctable >> (pixel_index * 2)) & 0b11;
-
-                    // parse colour table and set R, G and B bytes for this pixel
-                    switch(code) {
-                        case 0:
-                            memcpy(pixel_ptr, c0_rgb, 3);
-                            break;
-                        case 1:
-                            memcpy(pixel_ptr, c1_rgb, 3);
-                            break;
-                        case 2:
-                            if (c0_greater) {
-                                pixel_ptr[0] = (2*c0_rgb[0]+c1_rgb[0])/3;
-                                pixel_ptr[1] = (2*c0_rgb[1]+c1_rgb[1])/3;
-                                pixel_ptr[2] = (2*c0_rgb[2]+c1_rgb[2])/3;
-                            } else {
-                                pixel_ptr[0] = (c0_rgb[0]+c1_rgb[0])/2;
-                                pixel_ptr[1] = (c0_rgb[1]+c1_rgb[1])/2;
-                                pixel_ptr[2] = (c0_rgb[2]+c1_rgb[2])/2;
-                            }
-                            break;
-                        case 3:
-                            if (c0_greater) {
-                                pixel_ptr[0] = (2*c1_rgb[0]+c0_rgb[0])/3;
-                                pixel_ptr[1] = (2*c1_rgb[1]+c0_rgb[1])/3;
-                                pixel_ptr[2] = (2*c1_rgb[2]+c0_rgb[2])/3;
-                            } else {
-                                memset(pixel_ptr, 0, 3);
-                            }
-                            break;
-                    }
-
-                    // parse alpha table (if any) and set alpha byte for this pixel
-                    switch (format) {
-                        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
-                        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: {
-                            // no alpha channel at all
-                            pixel_ptr[3] = 0xFF;
-                            break;
-                        }
-                        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-                        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT: {
-                            // black means zero alpha
-                            pixel_ptr[3] = (code == 3 && !c0_greater) ? 0 : 0xFF;
-                            break;
-                        }
-                        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-                        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT: {
-                            // 4-bit alpha value from the alpha chunk
-                            pixel_ptr[3] = ((ptr[pixel_index / 2] >> ((i & 1) ? 4 : 0)) & 0b1111) * 17;
-                            break;
-                        }
-                        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-                        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: {
-                            // 3-bit instruction value from atable
-                            const uint8_t code = (atable >> (pixel_index * 3)) & 0b111;
-                            switch (code) {
-                                case 0:
-                                    pixel_ptr[3] = alpha0;
-                                    break;
-                                case 1:
-                                    pixel_ptr[3] = alpha1;
-                                    break;
-                                case 6:
-                                case 7:
-                                    if (!a0_greater) {
-                                        pixel_ptr[3] = code == 6 ? 0 : 0xFF;
-                                        break;
-                                    }
-                                    // fall through is intentional
-                                default:
-                                    if (a0_greater) pixel_ptr[3] = (((8 - code) * (uint16_t)alpha0) + ((code - 1) * (uint16_t)alpha1)) / 7;
-                                    else pixel_ptr[3] = (((6 - code) * (uint16_t)alpha0) + ((code - 1) * (uint16_t)alpha1)) / 5;
-                                    break;
-                            }
-                            break;
-                        }
-                    }
-                }
+    texture_touch(tex);
+    // GL rejects S3TC uploads which aren't aligned to the block grid or don't fit in the texture, so
+    // anything like that didn't actually change the texture
+    if (xoffset < 0 || yoffset < 0 || (xoffset % 4) || (yoffset % 4) || xoffset + width > tex->width || yoffset + height > tex->height) return;
+    if (((width % 4) && xoffset + width != tex->width) || ((height % 4) && yoffset + height != tex->height)) return;
+    const size_t input_stride = dxt_block_size(mode);
+    const GLint region_blocks_x = (width + 3) / 4;
+    const GLint region_blocks_y = (height + 3) / 4;
+    if (imageSize < 0 || (size_t)imageSize < (size_t)region_blocks_x * (size_t)region_blocks_y * input_stride) return;
+
+    // just keep a copy of the blocks; they get decoded by texture_decode_region when needed, and if the
+    // shadow gets evicted, they're what it gets rebuilt from. that only works if they're the only thing
+    // that's ever been written to the texture, so if anything else has, the shadow is pinned instead.
+    texture_shadow_lock(c);
+    if (tex->is_shadow_written) texture_shadow_pin_locked(c, tex);
+    if (tex->compressed && tex->compressed_format != format) {
+        // blocks of different sizes can't share the same array, so decode the old ones first
+        texture_shadow_pin_locked(c, tex);
+        texture_decode_region(tex, 0, 0, tex->width, tex->height, false);
+        texture_free_compressed(tex);
+    }
+    const GLint blocks_x = (tex->width + 3) / 4;
+    const GLint blocks_y = (tex->height + 3) / 4;
+    if (!tex->compressed) {
+        tex->compressed = malloc((size_t)blocks_x * (size_t)blocks_y * input_stride);
+        tex->compressed_state = calloc((size_t)blocks_x * (size_t)blocks_y, sizeof(*tex->compressed_state));
+        tex->compressed_pending = 0;
+        tex->compressed_format = format;
+    }
+    for (GLint j = 0; j < region_blocks_y; j += 1) {
+        const size_t index = ((size_t)((yoffset / 4) + j) * blocks_x) + (xoffset / 4);
+        memcpy(tex->compressed + (index * input_stride), (const uint8_t*)data + ((size_t)j * region_blocks_x * input_stride), region_blocks_x * input_stride);
+        for (GLint i = 0; i < region_blocks_x; i += 1) {
+            if (tex->compressed_state[index + i] != COMPRESSED_BLOCK_PENDING) {
+                tex->compressed_state[index + i] = COMPRESSED_BLOCK_PENDING;
+                tex->compressed_pending += 1;
             }
         }
-
-        out_xoffset += 4;
-        if (out_xoffset >= xoffset + width) {
-            out_xoffset = xoffset;
-            out_yoffset += 4;
-        }
     }
+    texture_shadow_unlock(c);
+}
+
+// https://www.khronos.org/opengl/wiki/S3_Texture_Compression
+static void glCompressedTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data) {
+    LOG("glCompressedTexSubImage2D\n");
+    gl.CompressedTexSubImage2D(target, level, xoffset, yoffset, width, height, format, imageSize, data);
+    struct GLContext* c = _bolt_context();
+    TRACE_CALL(TRACE_COMPRESSEDTEXSUBIMAGE2D, TRACE_UNPACK_DATA(c, data), imageSize, target, level, xoffset, yoffset, width, height, format, imageSize, c->bound_pixel_unpack_buffer, (uintptr_t)data)
+    PROFILE_START()
+    if (target == GL_TEXTURE_2D && level == 0) texture_compressed_sub_image(c, xoffset, yoffset, width, height, format, imageSize, data);
+    PROFILE_END(PROFILE_COMPRESSEDTEXSUBIMAGE2D)
     LOG("glCompressedTexSubImage2D end\n");
 }
 
@@ -1632,10 +2894,12 @@ static void glCopyImageSubData(
 ) {
     LOG("glCopyImageSubData\n");
     gl.CopyImageSubData(srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth);
+    TRACE_CALL(TRACE_COPYIMAGESUBDATA, NULL, 0, srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth)
     struct GLContext* c = _bolt_context();
     if (srcTarget == GL_TEXTURE_2D && dstTarget == GL_TEXTURE_2D && srcLevel == 0 && dstLevel == 0) {
         struct GLTexture2D* src = context_get_texture(c, srcName);
         struct GLTexture2D* dst = context_get_texture(c, dstName);
+        if (dst) texture_touch(dst);
         if (!c->does_blit_3d_target && c->depth_of_field_enabled && dst->id == c->depth_of_field_sSourceTex) {
             if (srcX == 0 && srcY == 0 && dstX == 0 && dstY == 0 && src->width == dst->width && src->height == dst->height && src->width == srcWidth && src->height == srcHeight) {
                 printf("copy to depth-of-field tex from tex %i\n", src->id);
@@ -1644,6 +2908,7 @@ static void glCopyImageSubData(
             }
         } else if (!src->icon.is_big_icon && src->icon.model_count && dst->width > GAME_ITEM_ICON_SIZE && dst->height > GAME_ITEM_ICON_SIZE) {
             if (!dst->icons) {
+                texture_shadow_pin(c, dst);
                 dst->icons = hashmap_new(sizeof(struct Icon), 256, 0, 0, _bolt_plugin_itemicon_hash, _bolt_plugin_itemicon_compare, NULL, NULL);
             }
             src->icon.x = dstX;
@@ -1658,9 +2923,30 @@ static void glCopyImageSubData(
             }
             src->icon.model_count = 0;
         } else if (src->id != c->target_3d_tex) {
-            for (GLsizei i = 0; i < srcHeight; i += 1) {
-                memcpy(dst->data + (dstY * dst->width * 4) + (dstX * 4), src->data + (srcY * src->width * 4) + (srcX * 4), srcWidth * 4);
+            // the destination has been written on the GPU whether or not its shadow is present, so an
+            // evicted destination will be read back if it's ever restored
+            texture_shadow_lock(c);
+            // S3TC shadows are rebuilt from their blocks, which this copy won't be part of
+            if (dst->compressed) texture_shadow_pin_locked(c, dst);
+            dst->is_shadow_written = true;
+            if (texture_shadow_touch(c, dst, false)) {
+                texture_decode_region(dst, dstX, dstY, srcWidth, srcHeight, false);
+                if (texture_shadow_touch(c, src, src->compressed != NULL)) {
+                    texture_decode_region(src, srcX, srcY, srcWidth, srcHeight, false);
+                    for (GLsizei i = 0; i < srcHeight; i += 1) {
+                        memcpy(dst->data + ((dstY + i) * dst->width * 4) + (dstX * 4), src->data + ((srcY + i) * src->width * 4) + (srcX * 4), srcWidth * 4);
+                    }
+                } else if (src->is_shadow_evicted && !src->is_multisample) {
+                    // rather than restoring the whole of an evicted source, read back only the part that was copied
+                    uint8_t* region = malloc((size_t)srcWidth * (size_t)srcHeight * 4);
+                    texture_read_region(c, src, srcX, srcY, srcWidth, srcHeight, region);
+                    for (GLsizei i = 0; i < srcHeight; i += 1) {
+                        memcpy(dst->data + ((dstY + i) * dst->width * 4) + (dstX * 4), region + ((size_t)i * srcWidth * 4), srcWidth * 4);
+                    }
+                    free(region);
+                }
             }
+            texture_shadow_unlock(c);
         }
     }
     LOG("glCopyImageSubData end\n");
@@ -1669,6 +2955,7 @@ static void glCopyImageSubData(
 static void glEnableVertexAttribArray(GLuint index) {
     LOG("glEnableVertexAttribArray\n");
     gl.EnableVertexAttribArray(index);
+    TRACE_CALL(TRACE_ENABLEVERTEXATTRIBARRAY, NULL, 0, index)
     struct GLContext* c = _bolt_context();
     c->bound_vao->attributes[index].enabled = 1;
     LOG("glEnableVertexAttribArray end\n");
@@ -1677,6 +2964,7 @@ static void glEnableVertexAttribArray(GLuint index) {
 static void glDisableVertexAttribArray(GLuint index) {
     LOG("glDisableVertexAttribArray\n");
     gl.DisableVertexAttribArray(index);
+    TRACE_CALL(TRACE_DISABLEVERTEXATTRIBARRAY, NULL, 0, index)
     struct GLContext* c = _bolt_context();
     c->bound_vao->attributes[index].enabled = 0;
     LOG("glDisableVertexAttribArray end\n");
@@ -1684,19 +2972,37 @@ static void glDisableVertexAttribArray(GLuint index) {
 
 static void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
     LOG("glMapBufferRange\n");
+    TRACE_CALL(TRACE_MAPBUFFERRANGE, NULL, 0, target, offset, length, access)
+    PROFILE_START()
     struct GLContext* c = _bolt_context();
     GLenum binding_type = buffer_binding_enum(target);
     if (binding_type != -1) {
-        GLint buffer_id;
-        lgl->GetIntegerv(binding_type, &buffer_id);
+        const GLuint buffer_id = context_bound_buffer(c, target);
         struct GLArrayBuffer* buffer = context_get_buffer(c, buffer_id);
+        if (!buffer->is_mirrored) {
+            // nothing needs to see what gets written, so let the game map it for real. the explicit-flush
+            // bit gets dropped so that unmapping flushes the whole range, same as in the intercepted case
+            if (!(access & GL_MAP_PERSISTENT_BIT)) access &= ~GL_MAP_FLUSH_EXPLICIT_BIT;
+            void* ret = gl.MapBufferRange(target, offset, length, access);
+            buffer->is_gl_mapped = ret != NULL;
+            buffer->mapping = ret;
+            buffer->mapping_offset = offset;
+            buffer->mapping_len = length;
+            buffer->mapping_access_type = access;
+            PROFILE_END(PROFILE_MAPBUFFER)
+            LOG("glMapBufferRange end (not mirrored)\n");
+            return ret;
+        }
         buffer->mapping = malloc(length);
         buffer->mapping_offset = offset;
         buffer->mapping_len = length;
         buffer->mapping_access_type = access;
         if ((access & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)) == 0) {
-            memcpy(buffer->mapping, (uint8_t*)buffer->data + offset, length);
+            // the game gets to read what it maps, so a read-back that hasn't landed yet has to be waited for
+            if (!buffer->data) buffer_read_back_poll(buffer, true);
+            if (buffer->data) memcpy(buffer->mapping, (uint8_t*)buffer->data + offset, length);
         }
+        PROFILE_END(PROFILE_MAPBUFFER)
         LOG("glMapBufferRange end (intercepted)\n");
         return buffer->mapping;
     } else {
@@ -1708,24 +3014,41 @@ static void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
 
 static GLboolean glUnmapBuffer(GLuint target) {
     LOG("glUnmapBuffer\n");
+    PROFILE_START()
     struct GLContext* c = _bolt_context();
     GLenum binding_type = buffer_binding_enum(target);
     if (binding_type != -1) {
-        GLint buffer_id;
-        lgl->GetIntegerv(binding_type, &buffer_id);
+        const GLuint buffer_id = context_bound_buffer(c, target);
         struct GLArrayBuffer* buffer = context_get_buffer(c, buffer_id);
+        if (buffer->is_gl_mapped) {
+            // pick up the last writes through a persistent mapping that got mirrored while it was mapped
+            if (buffer->is_mirrored) buffer_refresh_persistent(buffer, true);
+            GLboolean ret = gl.UnmapBuffer(target);
+            TRACE_CALL(TRACE_UNMAPBUFFER, NULL, 0, target)
+            buffer->is_gl_mapped = false;
+            buffer->mapping = NULL;
+            buffer_touch(buffer);
+            if (buffer->mirror_after_unmap) buffer_mirror(c, buffer);
+            PROFILE_END(PROFILE_MAPBUFFER)
+            LOG("glUnmapBuffer end (not mirrored)\n");
+            return ret;
+        }
         // technically it's wrong to do an implicit flush here unless GL_MAP_FLUSH_EXPLICIT_BIT is unset,
         // but it seems to happen all the time on some hardware and that behaviour is depended on by the game
         // engine, so that's what we have to do too. in mitigation, at least it's probably safe to assume that
         // there are no cases where they write something and *don't* expect it to be uploaded at some point.
         gl.BufferSubData(target, buffer->mapping_offset, buffer->mapping_len, buffer->mapping);
-        memcpy((uint8_t*)buffer->data + buffer->mapping_offset, buffer->mapping, buffer->mapping_len);
+        TRACE_CALL(TRACE_UNMAPBUFFER, buffer->mapping, buffer->mapping_len, target)
+        buffer_write(buffer, buffer->mapping_offset, buffer->mapping_len, buffer->mapping);
+        buffer_touch(buffer);
         free(buffer->mapping);
         buffer->mapping = NULL;
+        PROFILE_END(PROFILE_MAPBUFFER)
         LOG("glUnmapBuffer end (intercepted)\n");
         return 1;
     } else {
         GLboolean ret = gl.UnmapBuffer(target);
+        TRACE_CALL(TRACE_UNMAPBUFFER, NULL, 0, target)
         LOG("glUnmapBuffer end (not intercepted)\n");
         return ret;
     }
@@ -1734,32 +3057,46 @@ static GLboolean glUnmapBuffer(GLuint target) {
 static void glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
     LOG("glBufferStorage\n");
     gl.BufferStorage(target, size, data, flags);
+    TRACE_CALL(TRACE_BUFFERSTORAGE, data, size, target, size, flags)
+    PROFILE_START()
     struct GLContext* c = _bolt_context();
     GLenum binding_type = buffer_binding_enum(target);
     if (binding_type != -1) {
-        GLint buffer_id;
-        lgl->GetIntegerv(binding_type, &buffer_id);
-        void* buffer_content = malloc(size);
-        if (data) memcpy(buffer_content, data, size);
+        const GLuint buffer_id = context_bound_buffer(c, target);
         struct GLArrayBuffer* buffer = context_get_buffer(c, buffer_id);
-        free(buffer->data);
-        buffer->data = buffer_content;
+        // immutable buffers can't be read back later unless they were created readable
+        if (!(flags & GL_MAP_READ_BIT)) buffer->is_mirrored = true;
+        buffer_set_storage(buffer, size, data);
     }
+    PROFILE_END(PROFILE_BUFFERDATA)
     LOGF("glBufferStorage end (%s)\n", binding_type == -1 ? "not intercepted" : "intercepted");
 }
 
 static void glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
     LOG("glFlushMappedBufferRange\n");
+    PROFILE_START()
     struct GLContext* c = _bolt_context();
     GLenum binding_type = buffer_binding_enum(target);
     if (binding_type != -1) {
-        GLint buffer_id;
-        lgl->GetIntegerv(binding_type, &buffer_id);
+        const GLuint buffer_id = context_bound_buffer(c, target);
         struct GLArrayBuffer* buffer = context_get_buffer(c, buffer_id);
+        if (buffer->is_gl_mapped) {
+            if (buffer->mapping_access_type & GL_MAP_FLUSH_EXPLICIT_BIT) gl.FlushMappedBufferRange(target, offset, length);
+            if (buffer->is_mirrored) buffer_refresh_persistent(buffer, true);
+            buffer_touch(buffer);
+            TRACE_CALL(TRACE_FLUSHMAPPEDBUFFERRANGE, NULL, 0, target, offset, length)
+            PROFILE_END(PROFILE_MAPBUFFER)
+            LOG("glFlushMappedBufferRange end (not mirrored)\n");
+            return;
+        }
         gl.BufferSubData(target, buffer->mapping_offset + offset, length, buffer->mapping + offset);
-        memcpy((uint8_t*)buffer->data + buffer->mapping_offset + offset, buffer->mapping + offset, length);
+        TRACE_CALL(TRACE_FLUSHMAPPEDBUFFERRANGE, buffer->mapping + offset, length, target, offset, length)
+        buffer_write(buffer, buffer->mapping_offset + offset, length, buffer->mapping + offset);
+        buffer_touch(buffer);
+        PROFILE_END(PROFILE_MAPBUFFER)
     } else {
         gl.FlushMappedBufferRange(target, offset, length);
+        TRACE_CALL(TRACE_FLUSHMAPPEDBUFFERRANGE, NULL, 0, target, offset, length)
     }
     LOGF("glFlushMappedBufferRange end (%s)\n", binding_type == -1 ? "not intercepted" : "intercepted");
 }
@@ -1767,8 +3104,12 @@ static void glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr
 static void glActiveTexture(GLenum texture) {
     LOG("glActiveTexture\n");
     gl.ActiveTexture(texture);
+    TRACE_CALL(TRACE_ACTIVETEXTURE, NULL, 0, texture)
     struct GLContext* c = _bolt_context();
-    c->active_texture = texture - GL_TEXTURE0;
+    // GL rejects units past its limit with GL_INVALID_ENUM and leaves the active unit unchanged, so do the same
+    if (texture >= GL_TEXTURE0 && texture - GL_TEXTURE0 < (GLuint)c->texture_unit_count) {
+        c->active_texture = texture - GL_TEXTURE0;
+    }
     LOG("glActiveTexture end\n");
 }
 
@@ -1784,6 +3125,7 @@ static void glMultiDrawElements(GLenum mode, const GLsizei* count, GLenum type,
 static void glGenVertexArrays(GLsizei n, GLuint* arrays) {
     LOG("glGenVertexArrays\n");
     gl.GenVertexArrays(n, arrays);
+    TRACE_CALL(TRACE_GENVERTEXARRAYS, arrays, n * sizeof(*arrays), n)
     struct GLContext* c = _bolt_context();
     GLint attrib_count;
     lgl->GetIntegerv(GL_MAX_VERTEX_ATTRIBS, &attrib_count);
@@ -1791,8 +3133,10 @@ static void glGenVertexArrays(GLsizei n, GLuint* arrays) {
     for (GLsizei i = 0; i < n; i += 1) {
         struct GLVertexArray* array = malloc(sizeof(struct GLVertexArray));
         array->id = arrays[i];
+        array->element_buffer = 0;
+        array->attribute_count = attrib_count;
         array->attributes = calloc(attrib_count, sizeof(struct GLAttrBinding));
-        hashmap_set(c->vaos->map, &array);
+        namemap_set(c->vaos, array->id, array);
     }
     _bolt_rwlock_unlock_write(&c->vaos->rwlock);
     LOG("glGenVertexArrays end\n");
@@ -1800,13 +3144,14 @@ static void glGenVertexArrays(GLsizei n, GLuint* arrays) {
 
 static void glDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
     LOG("glDeleteVertexArrays\n");
+    TRACE_CALL(TRACE_DELETEVERTEXARRAYS, arrays, n * sizeof(*arrays), n)
     struct GLContext* c = _bolt_context();
     _bolt_rwlock_lock_write(&c->vaos->rwlock);
     for (GLsizei i = 0; i < n; i += 1) {
-        const GLuint* ptr = &arrays[i];
-        struct GLVertexArray* const* vao = hashmap_delete(c->vaos->map, &ptr);
-        free((*vao)->attributes);
-        free(*vao);
+        struct GLVertexArray* vao = namemap_delete(c->vaos, arrays[i]);
+        if (!vao) continue;
+        free(vao->attributes);
+        free(vao);
     }
     _bolt_rwlock_unlock_write(&c->vaos->rwlock);
     gl.DeleteVertexArrays(n, arrays);
@@ -1816,6 +3161,7 @@ static void glDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
 static void glBindVertexArray(GLuint array) {
     LOG("glBindVertexArray\n");
     gl.BindVertexArray(array);
+    TRACE_CALL(TRACE_BINDVERTEXARRAY, NULL, 0, array)
     struct GLContext* c = _bolt_context();
     c->bound_vao = context_get_vao(c, array);
     LOG("glBindVertexArray end\n");
@@ -1824,22 +3170,20 @@ static void glBindVertexArray(GLuint array) {
 static void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
     LOG("glBlitFramebuffer\n");
     gl.BlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+    TRACE_CALL(TRACE_BLITFRAMEBUFFER, NULL, 0, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter)
     struct GLContext* c = _bolt_context();
 
     if ((mask & GL_DEPTH_BUFFER_BIT) && c->depth_tex > 0) {
-        GLint read_tex_id = 0;
-        gl.GetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &read_tex_id);
-        if (c->depth_tex == read_tex_id) {
-            gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &c->depth_tex);
+        const GLint read_tex_id = context_framebuffer_attachment(c, GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT);
+        if (c->depth_tex == read_tex_id && c->current_draw_framebuffer) {
+            c->depth_tex = context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT);
         }
     }
 
     if (!(mask & GL_COLOR_BUFFER_BIT)) return;
 
-    GLint draw_tex_id = 0;
-    GLint read_tex_id = 0;
-    gl.GetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &read_tex_id);
-    gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &draw_tex_id);
+    const GLint draw_tex_id = context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0);
+    const GLint read_tex_id = context_framebuffer_attachment(c, GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0);
 
     if (c->current_draw_framebuffer == 0 && c->game_view_part_framebuffer != c->current_read_framebuffer) {
         c->game_view_part_framebuffer = c->current_read_framebuffer;
@@ -1882,6 +3226,7 @@ static void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1
 
 static void glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
     gl.BlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+    TRACE_CALL(TRACE_BLENDFUNCSEPARATE, NULL, 0, srcRGB, dstRGB, srcAlpha, dstAlpha)
     struct GLContext* c = _bolt_context();
     c->blend_rgb_s = srcRGB;
     c->blend_rgb_d = dstRGB;
@@ -1892,17 +3237,151 @@ static void glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, G
 static void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
     LOG("glBufferSubData\n");
     gl.BufferSubData(target, offset, size, data);
+    PROFILE_START()
+    TRACE_CALL(TRACE_BUFFERSUBDATA, data, size, target, offset, size)
     struct GLContext* c = _bolt_context();
     GLenum binding_type = buffer_binding_enum(target);
     if (binding_type != -1) {
-        GLint buffer_id;
-        lgl->GetIntegerv(binding_type, &buffer_id);
+        const GLuint buffer_id = context_bound_buffer(c, target);
         struct GLArrayBuffer* buffer = context_get_buffer(c, buffer_id);
-        memcpy((uint8_t*)buffer->data + offset, data, size);
+        buffer_write(buffer, offset, size, data);
+        buffer_touch(buffer);
     }
+    PROFILE_END(PROFILE_BUFFERDATA)
     LOG("glBufferSubData end\n");
 }
 
+static void glBindBuffer(GLenum target, GLuint buffer) {
+    LOG("glBindBuffer\n");
+    gl.BindBuffer(target, buffer);
+    TRACE_CALL(TRACE_BINDBUFFER, NULL, 0, target, buffer)
+    struct GLContext* c = _bolt_context();
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            c->bound_array_buffer = buffer;
+            break;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            if (c->bound_vao) c->bound_vao->element_buffer = buffer;
+            buffer_mirror(c, context_get_buffer(c, buffer));
+            break;
+        case GL_UNIFORM_BUFFER:
+            c->bound_uniform_buffer = buffer;
+            buffer_mirror(c, context_get_buffer(c, buffer));
+            break;
+        case GL_PIXEL_UNPACK_BUFFER:
+            c->bound_pixel_unpack_buffer = buffer;
+            break;
+    }
+    LOG("glBindBuffer end\n");
+}
+
+static void glBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    LOG("glBindBufferBase\n");
+    gl.BindBufferBase(target, index, buffer);
+    TRACE_CALL(TRACE_BINDBUFFERBASE, NULL, 0, target, index, buffer)
+    struct GLContext* c = _bolt_context();
+    if (target == GL_UNIFORM_BUFFER) {
+        // indexed binds also bind to the generic binding point
+        c->bound_uniform_buffer = buffer;
+        if (index < MAX_UNIFORM_BUFFER_BINDINGS) c->uniform_buffer_bindings[index] = buffer;
+        buffer_mirror(c, context_get_buffer(c, buffer));
+    }
+    LOG("glBindBufferBase end\n");
+}
+
+static void glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    LOG("glBindBufferRange\n");
+    gl.BindBufferRange(target, index, buffer, offset, size);
+    TRACE_CALL(TRACE_BINDBUFFERRANGE, NULL, 0, target, index, buffer, offset, size)
+    struct GLContext* c = _bolt_context();
+    if (target == GL_UNIFORM_BUFFER) {
+        c->bound_uniform_buffer = buffer;
+        if (index < MAX_UNIFORM_BUFFER_BINDINGS) c->uniform_buffer_bindings[index] = buffer;
+        buffer_mirror(c, context_get_buffer(c, buffer));
+    }
+    LOG("glBindBufferRange end\n");
+}
+
+static void glUniform1i(GLint location, GLint v0) {
+    LOG("glUniform1i\n");
+    gl.Uniform1i(location, v0);
+    TRACE_CALL(TRACE_UNIFORM1I, NULL, 0, location, v0)
+    struct GLContext* c = _bolt_context();
+    if (c->bound_program) program_cache_uniform(c->bound_program, location, v0);
+    LOG("glUniform1i end\n");
+}
+
+static void glUniform1iv(GLint location, GLsizei count, const GLint* value) {
+    LOG("glUniform1iv\n");
+    gl.Uniform1iv(location, count, value);
+    TRACE_CALL(TRACE_UNIFORM1IV, value, count * sizeof(*value), location, count)
+    struct GLContext* c = _bolt_context();
+    if (c->bound_program && location != -1) {
+        for (GLsizei i = 0; i < count; i += 1) {
+            program_cache_uniform(c->bound_program, location + i, value[i]);
+        }
+    }
+    LOG("glUniform1iv end\n");
+}
+
+static void glUniformBlockBinding(GLuint program, GLuint index, GLuint binding) {
+    LOG("glUniformBlockBinding\n");
+    gl.UniformBlockBinding(program, index, binding);
+    TRACE_CALL(TRACE_UNIFORMBLOCKBINDING, NULL, 0, program, index, binding)
+    struct GLContext* c = _bolt_context();
+    struct GLProgram* p = context_get_program(c, program);
+    if (p && index < PROGRAM_BLOCK_BINDINGS) p->block_bindings[index] = binding;
+    LOG("glUniformBlockBinding end\n");
+}
+
+// any change to a framebuffer's attachments could affect either bound framebuffer, since the same one may
+// be bound to both targets, so these just drop both caches. they're rare compared to draw calls anyway.
+static void glFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level) {
+    LOG("glFramebufferTexture\n");
+    gl.FramebufferTexture(target, attachment, texture, level);
+    TRACE_CALL(TRACE_FRAMEBUFFERTEXTURE, NULL, 0, target, attachment, texture, level)
+    context_invalidate_attachments(_bolt_context());
+    LOG("glFramebufferTexture end\n");
+}
+
+static void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+    LOG("glFramebufferTexture2D\n");
+    gl.FramebufferTexture2D(target, attachment, textarget, texture, level);
+    TRACE_CALL(TRACE_FRAMEBUFFERTEXTURE2D, NULL, 0, target, attachment, textarget, texture, level)
+    context_invalidate_attachments(_bolt_context());
+    LOG("glFramebufferTexture2D end\n");
+}
+
+static void glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) {
+    LOG("glFramebufferTextureLayer\n");
+    gl.FramebufferTextureLayer(target, attachment, texture, level, layer);
+    TRACE_CALL(TRACE_FRAMEBUFFERTEXTURELAYER, NULL, 0, target, attachment, texture, level, layer)
+    context_invalidate_attachments(_bolt_context());
+    LOG("glFramebufferTextureLayer end\n");
+}
+
+static void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
+    LOG("glFramebufferRenderbuffer\n");
+    gl.FramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
+    TRACE_CALL(TRACE_FRAMEBUFFERRENDERBUFFER, NULL, 0, target, attachment, renderbuffertarget, renderbuffer)
+    context_invalidate_attachments(_bolt_context());
+    LOG("glFramebufferRenderbuffer end\n");
+}
+
+static void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+    LOG("glDeleteFramebuffers\n");
+    gl.DeleteFramebuffers(n, framebuffers);
+    TRACE_CALL(TRACE_DELETEFRAMEBUFFERS, framebuffers, n * sizeof(*framebuffers), n)
+    struct GLContext* c = _bolt_context();
+    for (GLsizei i = 0; i < n; i += 1) {
+        // deleting a bound framebuffer reverts that binding to the default framebuffer
+        if (c->current_read_framebuffer == framebuffers[i]) c->current_read_framebuffer = 0;
+        if (c->current_draw_framebuffer == framebuffers[i]) c->current_draw_framebuffer = 0;
+    }
+    context_invalidate_attachments(c);
+    LOG("glDeleteFramebuffers end\n");
+}
+
 void* _bolt_gl_GetProcAddress(const char* name) {
 #define PROC_ADDRESS_MAP(FUNC) if (!strcmp(name, "gl"#FUNC)) { return gl.FUNC ? gl##FUNC : NULL; }
     PROC_ADDRESS_MAP(CreateProgram)
@@ -1933,6 +3412,17 @@ void* _bolt_gl_GetProcAddress(const char* name) {
     PROC_ADDRESS_MAP(BlitFramebuffer)
     PROC_ADDRESS_MAP(BlendFuncSeparate)
     PROC_ADDRESS_MAP(BufferSubData)
+    PROC_ADDRESS_MAP(BindBuffer)
+    PROC_ADDRESS_MAP(BindBufferBase)
+    PROC_ADDRESS_MAP(BindBufferRange)
+    PROC_ADDRESS_MAP(Uniform1i)
+    PROC_ADDRESS_MAP(Uniform1iv)
+    PROC_ADDRESS_MAP(UniformBlockBinding)
+    PROC_ADDRESS_MAP(FramebufferTexture)
+    PROC_ADDRESS_MAP(FramebufferTexture2D)
+    PROC_ADDRESS_MAP(FramebufferTextureLayer)
+    PROC_ADDRESS_MAP(FramebufferRenderbuffer)
+    PROC_ADDRESS_MAP(DeleteFramebuffers)
 #undef PROC_ADDRESS_MAP
     return NULL;
 }
@@ -1940,8 +3430,12 @@ void* _bolt_gl_GetProcAddress(const char* name) {
 /* libgl function hooks (called from os-specific main.c) */
 
 void _bolt_gl_onSwapBuffers(uint32_t window_width, uint32_t window_height) {
+    PROFILE_START()
+    TRACE_CALL(TRACE_SWAPBUFFERS, NULL, 0, window_width, window_height)
     gl_width = window_width;
     gl_height = window_height;
+    screen_capture_frame += 1;
+    frame_number += 1;
     player_model_tex_seen = false;
     pending_gameview_overlay_tex = 0;
     if (_bolt_plugin_is_inited()) _bolt_plugin_end_frame(window_width, window_height);
@@ -1958,9 +3452,13 @@ void _bolt_gl_onSwapBuffers(uint32_t window_width, uint32_t window_height) {
         c->depth_of_field_enabled = false;
         frames_without_3d = 0;
     }
+    PROFILE_END(PROFILE_SWAPBUFFERS)
+    PROFILE_END_FRAME()
 }
 
 void _bolt_gl_onCreateContext(void* context, void* shared_context, const struct GLLibFunctions* libgl, void* (*GetProcAddress)(const char*), bool is_important) {
+    TRACE_OPEN()
+    TRACE_CALL(TRACE_CREATECONTEXT, NULL, 0, (uintptr_t)context, (uintptr_t)shared_context, is_important)
     if (!shared_context && is_important) {
         lgl = libgl;
         if (egl_init_count == 0) {
@@ -1978,19 +3476,20 @@ void _bolt_gl_onMakeCurrent(void* context) {
     struct GLContext* const current_context = _bolt_context();
     if (current_context) {
         current_context->is_attached = 0;
-        if (current_context->deferred_destroy) context_destroy(current_context);
+        if (current_context->deferred_destroy) context_destroy((void*)current_context->id);
     }
     if (!context) {
         set_context(NULL);
+        TRACE_CALL(TRACE_MAKECURRENT, NULL, 0, 0)
         return;
     }
-    for (size_t i = 0; i < CONTEXTS_CAPACITY; i += 1) {
-        struct GLContext* const ptr = &contexts[i];
-        if (ptr->id == (uintptr_t)context) {
-            set_context(ptr);
-            break;
-        }
+    struct GLContext* const new_context = context_get_by_id((uintptr_t)context);
+    if (new_context) {
+        new_context->is_attached = 1;
+        set_context(new_context);
+        if (!new_context->texture_units) context_init_texture_units(new_context);
     }
+    TRACE_CALL(TRACE_MAKECURRENT, NULL, 0, (uintptr_t)context)
     if (egl_main_context_makecurrent_pending && (uintptr_t)context == egl_main_context) {
         egl_main_context_makecurrent_pending = 0;
         gl_init();
@@ -2002,9 +3501,15 @@ void _bolt_gl_onMakeCurrent(void* context) {
             .surface_resize_and_clear = glplugin_surface_resize,
             .draw_region_outline = glplugin_draw_region_outline,
             .read_screen_pixels = glplugin_read_screen_pixels,
+            .capture_screen_init = glplugin_capture_screen_init,
+            .capture_screen_begin = glplugin_capture_screen_begin,
+            .capture_screen_poll = glplugin_capture_screen_poll,
+            .capture_screen_read = glplugin_capture_screen_read,
+            .capture_screen_destroy = glplugin_capture_screen_destroy,
             .copy_screen = glplugin_copy_screen,
             .game_view_rect = glplugin_game_view_rect,
             .player_position = glplugin_player_position,
+            .texture_shadow_stats = glplugin_texture_shadow_stats,
             .vertex_shader_init = glplugin_vertex_shader_init,
             .fragment_shader_init = glplugin_fragment_shader_init,
             .shader_program_init = glplugin_shaderprogram_init,
@@ -2019,6 +3524,7 @@ void _bolt_gl_onMakeCurrent(void* context) {
 
 void* _bolt_gl_onDestroyContext(void* context) {
     uint8_t do_destroy_main = 0;
+    TRACE_CALL(TRACE_DESTROYCONTEXT, NULL, 0, (uintptr_t)context)
     if ((uintptr_t)context != egl_main_context) {
         context_destroy(context);
     } else {
@@ -2032,6 +3538,7 @@ void* _bolt_gl_onDestroyContext(void* context) {
 }
 
 void _bolt_gl_onGenTextures(GLsizei n, GLuint* textures) {
+    TRACE_CALL(TRACE_GENTEXTURES, textures, n * sizeof(*textures), n)
     struct GLContext* c = _bolt_context();
     _bolt_rwlock_lock_write(&c->textures->rwlock);
     for (GLsizei i = 0; i < n; i += 1) {
@@ -2040,22 +3547,31 @@ void _bolt_gl_onGenTextures(GLsizei n, GLuint* textures) {
         tex->internalformat = -1;
         tex->compare_mode = -1;
         tex->icons = NULL;
+        tex->compressed = NULL;
+        tex->compressed_state = NULL;
         tex->is_minimap_tex_big = false;
         tex->is_minimap_tex_small = false;
         tex->is_multisample = false;
-        hashmap_set(c->textures->map, &tex);
+        namemap_set(c->textures, tex->id, tex);
     }
     _bolt_rwlock_unlock_write(&c->textures->rwlock);
 }
 
 void _bolt_gl_onDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices_offset) {
+    TRACE_CALL(TRACE_DRAWELEMENTS, NULL, 0, mode, count, type, (uintptr_t)indices_offset)
+    PROFILE_START()
+    drawelements(mode, count, type, indices_offset);
+    PROFILE_END(PROFILE_DRAWELEMENTS)
+}
+
+static void drawelements(GLenum mode, GLsizei count, GLenum type, const void* indices_offset) {
     struct GLContext* c = _bolt_context();
     struct GLAttrBinding* attributes = c->bound_vao->attributes;
-    GLint element_binding;
-    lgl->GetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_binding);
-    struct GLArrayBuffer* element_buffer = context_get_buffer(c, element_binding);
-    const unsigned short* indices = (unsigned short*)((uint8_t*)element_buffer->data + (uintptr_t)indices_offset);
+    const uint8_t* element_data = context_buffer_data(c, context_bound_buffer(c, GL_ELEMENT_ARRAY_BUFFER));
+    if (!element_data) return;
+    const unsigned short* indices = (unsigned short*)(element_data + (uintptr_t)indices_offset);
     if (type == GL_UNSIGNED_SHORT && mode == GL_TRIANGLES && count > 0) {
+        // each handler calls vao_mirror_attributes itself, once it knows some plugin wants the event
         if (c->bound_program->is_2d && !c->bound_program->is_minimap) {
             return drawelements_handle_2d(count, indices, c, attributes);
         }
@@ -2063,10 +3579,7 @@ void _bolt_gl_onDrawElements(GLenum mode, GLsizei count, GLenum type, const void
             return drawelements_handle_3d(count, indices, c, attributes);
         }
         if (c->bound_program->is_particle) {
-            GLint draw_tex = 0;
-            if (c->current_draw_framebuffer) {
-                gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &draw_tex);
-            }
+            const GLint draw_tex = context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0);
             if (draw_tex == c->target_3d_tex) {
                 return drawelements_handle_particles(count, indices, c, attributes);
             }
@@ -2110,22 +3623,29 @@ hunt strategy is as follows:
 5b. if a full-blit or full-glCopyImageSubData occurs targeting depth_of_field_sSourceTex, take that as the render target
 */
 void _bolt_gl_onDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    TRACE_CALL(TRACE_DRAWARRAYS, NULL, 0, mode, first, count)
+    PROFILE_START()
+    drawarrays(mode, first, count);
+    PROFILE_END(PROFILE_DRAWARRAYS)
+}
+
+static void drawarrays(GLenum mode, GLint first, GLsizei count) {
     struct GLContext* c = _bolt_context();
-    GLint target_tex_id, source_tex_unit;
-    gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &target_tex_id);
+    GLint source_tex_unit;
+    const GLint target_tex_id = context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0);
     struct GLTexture2D* target_tex = context_get_texture(c, target_tex_id);
 
     if (c->current_draw_framebuffer && c->bound_program->is_minimap && target_tex->width == GAME_MINIMAP_BIG_SIZE && target_tex->height == GAME_MINIMAP_BIG_SIZE) {
-        GLint ubo_binding, ubo_view_index;
-        gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ViewTransforms, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-        gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, (GLuint)ubo_binding, &ubo_view_index);
-        const float* camera_position = (float*)((uint8_t*)(context_get_buffer(c, ubo_view_index)->data) + c->bound_program->offset_uCameraPosition);
+        const GLuint ubo_view_index = context_uniform_block_buffer(c, c->bound_program->block_index_ViewTransforms);
+        const uint8_t* ubo_view_buf = context_buffer_data(c, ubo_view_index);
+        if (!ubo_view_buf) return;
+        const float* camera_position = (float*)(ubo_view_buf + c->bound_program->offset_uCameraPosition);
         target_tex->is_minimap_tex_big = 1;
         target_tex->minimap_center_x = camera_position[0];
         target_tex->minimap_center_y = camera_position[2];
     } else if (mode == GL_TRIANGLE_STRIP && count == 4) {
         if (c->bound_program->loc_sSceneHDRTex != -1) {
-            gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_sSceneHDRTex, &source_tex_unit);
+            source_tex_unit = c->bound_program->val_sSceneHDRTex;
             struct GLTexture2D* source_tex = CONTEXT_GET_TEX_BINDING(c, source_tex_unit, texture_2d);
             if (source_tex) {
                 if (c->current_draw_framebuffer == 0 && c->game_view_sSceneHDRTex != source_tex->id) {
@@ -2151,7 +3671,7 @@ void _bolt_gl_onDrawArrays(GLenum mode, GLint first, GLsizei count) {
                     source_tex->icon.model_count = 0;
                 }
 
-                if (c->game_view_sSceneHDRTex == source_tex->id && c->depth_tex > 0 && !c->recalculate_depth_tex) {
+                if (c->game_view_sSceneHDRTex == source_tex->id && c->depth_tex > 0 && !c->recalculate_depth_tex && EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERGAMEVIEW))) {
                     update_gameview_overlay(c);
                     gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, gameview_overlay_fb);
                     lgl->ClearColor(0.0, 0.0, 0.0, 0.0);
@@ -2179,7 +3699,7 @@ void _bolt_gl_onDrawArrays(GLenum mode, GLint first, GLsizei count) {
                 }
             }
         } else if (c->bound_program->loc_sSourceTex != -1) {
-            gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_sSourceTex, &source_tex_unit);
+            source_tex_unit = c->bound_program->val_sSourceTex;
             struct GLTexture2D* source_tex = CONTEXT_GET_TEX_BINDING(c, source_tex_unit, texture_2d);
             if (source_tex) {
                 if (c->current_draw_framebuffer && c->bound_program->loc_sBlurFarTex != -1) {
@@ -2205,7 +3725,7 @@ void _bolt_gl_onDrawArrays(GLenum mode, GLint first, GLsizei count) {
                 }
             }
         } else if (!player_model_tex_seen && c->bound_program->loc_sTexture != -1 && c->current_draw_framebuffer == 0) {
-            gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_sTexture, &source_tex_unit);
+            source_tex_unit = c->bound_program->val_sTexture;
             struct GLTexture2D* source_tex = CONTEXT_GET_TEX_BINDING(c, source_tex_unit, recent);
             if (source_tex && source_tex->width == c->game_view_w && source_tex->height == c->game_view_h) {
                 c->player_model_tex = source_tex->id;
@@ -2216,8 +3736,10 @@ void _bolt_gl_onDrawArrays(GLenum mode, GLint first, GLsizei count) {
 }
 
 void _bolt_gl_onBindTexture(GLenum target, GLuint texture) {
+    TRACE_CALL(TRACE_BINDTEXTURE, NULL, 0, target, texture)
     struct GLContext* c = _bolt_context();
-    struct TextureUnit* unit = &c->texture_units[c->active_texture];
+    struct TextureUnit* unit = context_active_texture_unit(c);
+    if (!unit) return;
     unit->recent = texture;
     switch (target) {
         case GL_TEXTURE_2D:
@@ -2232,50 +3754,67 @@ void _bolt_gl_onBindTexture(GLenum target, GLuint texture) {
 
 void _bolt_gl_onTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
     struct GLContext* c = _bolt_context();
+    // only RGBA8 payloads are recorded since that's the only layout the hook itself understands
+    TRACE_CALL(TRACE_TEXSUBIMAGE2D, (format == GL_RGBA && type == GL_UNSIGNED_BYTE) ? TRACE_UNPACK_DATA(c, pixels) : NULL, (size_t)width * (size_t)height * 4, target, level, xoffset, yoffset, width, height, format, type, c->bound_pixel_unpack_buffer, (uintptr_t)pixels)
+    PROFILE_START()
     if (target == GL_TEXTURE_2D && level == 0 && format == GL_RGBA) {
         struct GLTexture2D* tex = CONTEXT_GET_TEX_CURRENT(c, texture_2d);
+        if (tex) texture_touch(tex);
         if (tex && !(xoffset < 0 || yoffset < 0 || xoffset + width > tex->width || yoffset + height > tex->height)) {
-            for (GLsizei y = 0; y < height; y += 1) {
-                uint8_t* dest_ptr = tex->data + ((tex->width * (y + yoffset)) + xoffset) * 4;
-                const uint8_t* src_ptr = (uint8_t*)pixels + (width * y * 4);
-                memcpy(dest_ptr, src_ptr, width * 4);
+            // uploads to evicted shadows are dropped, but marking the texture as written means it'll be read
+            // back from the GPU if it's restored
+            texture_shadow_lock(c);
+            // S3TC shadows are rebuilt from their blocks, which this upload won't be part of
+            if (tex->compressed) texture_shadow_pin_locked(c, tex);
+            tex->is_shadow_written = true;
+            if (texture_shadow_touch(c, tex, false)) {
+                texture_decode_region(tex, xoffset, yoffset, width, height, true);
+                for (GLsizei y = 0; y < height; y += 1) {
+                    uint8_t* dest_ptr = tex->data + ((tex->width * (y + yoffset)) + xoffset) * 4;
+                    const uint8_t* src_ptr = (uint8_t*)pixels + (width * y * 4);
+                    memcpy(dest_ptr, src_ptr, width * 4);
+                }
             }
+            texture_shadow_unlock(c);
         }
     }
+    PROFILE_END(PROFILE_TEXSUBIMAGE2D)
 }
 
 void _bolt_gl_onDeleteTextures(GLsizei n, const GLuint* textures) {
+    TRACE_CALL(TRACE_DELETETEXTURES, textures, n * sizeof(*textures), n)
     struct GLContext* c = _bolt_context();
+    // deleted textures get detached from the bound framebuffers
+    context_invalidate_attachments(c);
     _bolt_rwlock_lock_write(&c->textures->rwlock);
     for (GLsizei i = 0; i < n; i += 1) {
-        const GLuint* ptr = &textures[i];
-        struct GLTexture2D* const* texture = hashmap_delete(c->textures->map, &ptr);
-        free((*texture)->data);
-        if ((*texture)->icons) {
+        struct GLTexture2D* texture = namemap_delete(c->textures, textures[i]);
+        if (!texture) continue;
+        texture_shadow_free(c, texture);
+        if (texture->icons) {
             size_t iter = 0;
             void* item;
-            while (hashmap_iter((*texture)->icons, &iter, &item)) {
+            while (hashmap_iter(texture->icons, &iter, &item)) {
                 const struct Icon* icon = (struct Icon*)item;
                 for (size_t i = 0; i < icon->model_count; i += 1) {
                     free(icon->models[i].vertices);
                 }
             }
-            hashmap_free((*texture)->icons);
+            hashmap_free(texture->icons);
         }
-        for (size_t i = 0; i < (*texture)->icon.model_count; i += 1) {
-            free((*texture)->icon.models[i].vertices);
+        for (size_t i = 0; i < texture->icon.model_count; i += 1) {
+            free(texture->icon.models[i].vertices);
         }
-        free(*texture);
+        free(texture);
     }
     _bolt_rwlock_unlock_write(&c->textures->rwlock);
 }
 
 void _bolt_gl_onClear(GLbitfield mask) {
+    TRACE_CALL(TRACE_CLEAR, NULL, 0, mask)
     struct GLContext* c = _bolt_context();
     if ((mask & GL_COLOR_BUFFER_BIT) && c->current_draw_framebuffer != 0) {
-        GLint draw_tex;
-        gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &draw_tex);
-        struct GLTexture2D* tex = context_get_texture(c, draw_tex);
+        struct GLTexture2D* tex = context_get_texture(c, context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0));
         tex->is_minimap_tex_big = 0;
         for (size_t i = 0; i < tex->icon.model_count; i += 1) {
             free(tex->icon.models[i].vertices);
@@ -2285,6 +3824,7 @@ void _bolt_gl_onClear(GLbitfield mask) {
 }
 
 void _bolt_gl_onViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    TRACE_CALL(TRACE_VIEWPORT, NULL, 0, x, y, width, height)
     struct GLContext* c = _bolt_context();
     c->viewport_x = x;
     c->viewport_y = y;
@@ -2293,6 +3833,7 @@ void _bolt_gl_onViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
 }
 
 void _bolt_gl_onTexParameteri(GLenum target, GLenum pname, GLint param) {
+    TRACE_CALL(TRACE_TEXPARAMETERI, NULL, 0, target, pname, param)
     if (target == GL_TEXTURE_2D && pname == GL_TEXTURE_COMPARE_MODE) {
         struct GLContext* c = _bolt_context();
         struct GLTexture2D* tex = CONTEXT_GET_TEX_CURRENT(c, texture_2d);
@@ -2301,6 +3842,7 @@ void _bolt_gl_onTexParameteri(GLenum target, GLenum pname, GLint param) {
 }
 
 void _bolt_gl_onBlendFunc(GLenum sfactor, GLenum dfactor) {
+    TRACE_CALL(TRACE_BLENDFUNC, NULL, 0, sfactor, dfactor)
     struct GLContext* c = _bolt_context();
     c->blend_rgb_s = sfactor;
     c->blend_rgb_d = dfactor;
@@ -2312,8 +3854,7 @@ void _bolt_gl_onBlendFunc(GLenum sfactor, GLenum dfactor) {
 
 static void drawelements_update_depth_tex(struct GLContext* c) {
     if (c->recalculate_depth_tex) {
-        GLint depth_tex = 0;
-        gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &depth_tex);
+        const GLint depth_tex = context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT);
         if (depth_tex) {
             c->depth_tex = depth_tex;
             c->recalculate_depth_tex = false;
@@ -2323,31 +3864,32 @@ static void drawelements_update_depth_tex(struct GLContext* c) {
 
 static void drawelements_handle_2d(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes) {
     GLint diffuse_map, ubo_gui_index;
-    gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uDiffuseMap, &diffuse_map);
-    GLint ubo_binding;
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_GUIConsts, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_gui_index);
-    const uint8_t* gui_consts_buf = (uint8_t*)context_get_buffer(c, ubo_gui_index)->data;
+    diffuse_map = c->bound_program->val_uDiffuseMap;
+    ubo_gui_index = context_uniform_block_buffer(c, c->bound_program->block_index_GUIConsts);
+    const uint8_t* gui_consts_buf = context_buffer_data(c, ubo_gui_index);
+    if (!gui_consts_buf) return;
     const GLfloat* projection_matrix = (float*)(gui_consts_buf + c->bound_program->offset_uProjectionMatrix);
-    GLint draw_tex = 0;
-    if (c->current_draw_framebuffer) {
-        gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &draw_tex);
-    }
+    const GLint draw_tex = context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0);
     struct GLTexture2D* tex = CONTEXT_GET_TEX_BINDING(c, diffuse_map, texture_2d);
     struct GLTexture2D* tex_target = context_get_texture(c, draw_tex);
     const uint8_t is_minimap2d_target = tex_target && tex_target->is_minimap_tex_small;
     if (!tex) return;
 
     if (tex->is_minimap_tex_small && count == 6) {
+        if (!EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERMINIMAP))) return;
+        if (!vao_mirror_attributes(c, c->bound_vao)) return;
         drawelements_handle_2d_renderminimap(tex, projection_matrix, c, attributes);
     } else if (tex->is_minimap_tex_big) {
         tex_target->is_minimap_tex_small = 1;
-        if (count == 6) {
-            drawelements_handle_2d_minimapterrain(indices, tex, projection_matrix, c, attributes);
+        if (count == 6 && EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_MINIMAPTERRAIN))) {
+            if (vao_mirror_attributes(c, c->bound_vao)) drawelements_handle_2d_minimapterrain(indices, tex, projection_matrix, c, attributes);
         }
     } else if (tex->icon.model_count && tex->icon.is_big_icon && count == 6) {
         drawelements_handle_2d_bigicon(indices, tex, projection_matrix, c, attributes);
     } else {
+        const enum PluginEventType type_2d = is_minimap2d_target ? PLUGIN_EVENT_MINIMAPRENDER2D : PLUGIN_EVENT_RENDER2D;
+        if (!EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(type_2d) | PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERICON))) return;
+        if (!vao_mirror_attributes(c, c->bound_vao)) return;
         void (*handler_2d)(const struct RenderBatch2D*) = is_minimap2d_target ? _bolt_plugin_handle_minimaprender2d : _bolt_plugin_handle_render2d;
         void (*handler_icon)(const struct RenderIconEvent*) = _bolt_plugin_handle_rendericon;
         drawelements_handle_2d_normal(count, indices, tex, projection_matrix, c, attributes, handler_2d, handler_icon);
@@ -2355,10 +3897,7 @@ static void drawelements_handle_2d(GLsizei count, const unsigned short* indices,
 }
 
 static void drawelements_handle_3d(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes) {
-    GLint draw_tex = 0;
-    if (c->current_draw_framebuffer) {
-        gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &draw_tex);
-    }
+    const GLint draw_tex = context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0);
 
     if (c->current_draw_framebuffer && draw_tex == c->player_model_tex) {
         drawelements_handle_3d_silhouette(c);
@@ -2372,20 +3911,22 @@ static void drawelements_handle_3d(GLsizei count, const unsigned short* indices,
 static void drawelements_handle_particles(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes) {
     frames_without_3d = 0;
     drawelements_update_depth_tex(c);
+    if (!EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERPARTICLES))) return;
+    if (!vao_mirror_attributes(c, c->bound_vao)) return;
 
-    GLint atlas, settings_atlas, seconds, ubo_binding, ubo_view_index, ubo_particle_index;
-    gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uTextureAtlas, &atlas);
-    gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uTextureAtlasSettings, &settings_atlas);
+    GLint atlas, settings_atlas, seconds;
+    GLuint ubo_view_index, ubo_particle_index;
+    atlas = c->bound_program->val_uTextureAtlas;
+    settings_atlas = c->bound_program->val_uTextureAtlasSettings;
     gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uSecondsSinceStart, &seconds);
     struct GLTexture2D* tex = CONTEXT_GET_TEX_BINDING(c, atlas, texture_2d);
     struct GLTexture2D* tex_settings = CONTEXT_GET_TEX_BINDING(c, settings_atlas, texture_2d);
     if (!tex || !tex_settings) return;
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ViewTransforms, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_view_index);
-    const uint8_t* ubo_view_buf = (uint8_t*)context_get_buffer(c, ubo_view_index)->data;
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ParticleConsts, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_particle_index);
-    const uint8_t* particle_buf_data = (uint8_t*)context_get_buffer(c, ubo_particle_index)->data;
+    ubo_view_index = context_uniform_block_buffer(c, c->bound_program->block_index_ViewTransforms);
+    const uint8_t* ubo_view_buf = context_buffer_data(c, ubo_view_index);
+    ubo_particle_index = context_uniform_block_buffer(c, c->bound_program->block_index_ParticleConsts);
+    const uint8_t* particle_buf_data = context_buffer_data(c, ubo_particle_index);
+    if (!ubo_view_buf || !particle_buf_data) return;
     const GLfloat* transforms = (GLfloat*)(particle_buf_data + c->bound_program->offset_uParticleEmitterTransforms);
     const uint32_t* ranges = (uint32_t*)(particle_buf_data + c->bound_program->offset_uParticleEmitterTransformRanges);
     const GLfloat atlas_scale = *((GLfloat*)(particle_buf_data + c->bound_program->offset_uAtlasMeta) + 1);
@@ -2395,6 +3936,7 @@ static void drawelements_handle_particles(GLsizei count, const unsigned short* i
     vertex_userdata.indices = indices;
     vertex_userdata.atlas_scale = roundf(atlas_scale);
     vertex_userdata.settings_atlas = tex_settings;
+    texture_shadow_pin(c, tex_settings);
     vertex_userdata.origin = &attributes[c->bound_program->loc_aParticleOrigin_CreationTime];
     vertex_userdata.offset = &attributes[c->bound_program->loc_aParticleOffset];
     vertex_userdata.velocity = &attributes[c->bound_program->loc_aParticleVelocityAndUVScrollOffset];
@@ -2421,6 +3963,7 @@ static void drawelements_handle_particles(GLsizei count, const unsigned short* i
 
     struct GLPluginTextureUserData tex_userdata;
     tex_userdata.tex = tex;
+    texture_shadow_pin(c, tex);
 
     struct GLPluginCameraUserData camera_userdata;
     camera_userdata.camera_position = (GLfloat*)(ubo_view_buf + c->bound_program->offset_uCameraPosition);
@@ -2435,6 +3978,9 @@ static void drawelements_handle_particles(GLsizei count, const unsigned short* i
     render.vertex_functions.atlas_meta = glplugin_drawelements_vertexparticles_atlas_meta;
     render.vertex_functions.atlas_xywh = glplugin_drawelements_vertexparticles_meta_xywh;
     render.vertex_functions.colour = glplugin_drawelements_vertexparticles_colour;
+    render.vertex_functions.xyz_batch = glplugin_drawelements_vertexparticles_xyz_batch;
+    render.vertex_functions.uv_batch = glplugin_drawelements_vertexparticles_uv_batch;
+    render.vertex_functions.colour_batch = glplugin_drawelements_vertexparticles_colour_batch;
     render.matrix_functions.userdata = &matrix_userdata;
     render.matrix_functions.model_matrix = NULL;
     render.matrix_functions.view_matrix = glplugin_matrixparticles_viewmatrix;
@@ -2446,6 +3992,7 @@ static void drawelements_handle_particles(GLsizei count, const unsigned short* i
     render.texture_functions.size = glplugin_texture_size;
     render.texture_functions.compare = glplugin_texture_compare;
     render.texture_functions.data = glplugin_texture_data;
+    render.texture_functions.generation = glplugin_texture_generation;
     render.camera_functions.userdata = &camera_userdata;
     render.camera_functions.position = glplugin_camera_position;
 
@@ -2453,23 +4000,23 @@ static void drawelements_handle_particles(GLsizei count, const unsigned short* i
 }
 
 static void drawelements_handle_billboard(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes) {
-    GLint draw_tex = 0;
     if (!c->current_draw_framebuffer) return;
-    gl.GetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &draw_tex);
-    if (draw_tex != c->target_3d_tex) return;
-
-    GLint atlas, settings_atlas, ubo_binding, ubo_view_index, ubo_billboard_index;
-    gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uTextureAtlas, &atlas);
-    gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uTextureAtlasSettings, &settings_atlas);
+    if (context_framebuffer_attachment(c, GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0) != c->target_3d_tex) return;
+    if (!EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERBILLBOARD))) return;
+    if (!vao_mirror_attributes(c, c->bound_vao)) return;
+
+    GLint atlas, settings_atlas;
+    GLuint ubo_view_index, ubo_billboard_index;
+    atlas = c->bound_program->val_uTextureAtlas;
+    settings_atlas = c->bound_program->val_uTextureAtlasSettings;
     struct GLTexture2D* tex = CONTEXT_GET_TEX_BINDING(c, atlas, texture_2d);
     struct GLTexture2D* tex_settings = CONTEXT_GET_TEX_BINDING(c, settings_atlas, texture_2d);
     if (!tex || !tex_settings) return;
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ViewTransforms, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_view_index);
-    const uint8_t* ubo_view_buf = (uint8_t*)context_get_buffer(c, ubo_view_index)->data;
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_BilloardConsts, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_billboard_index);
-    const uint8_t* billboard_buf_data = (uint8_t*)context_get_buffer(c, ubo_billboard_index)->data;
+    ubo_view_index = context_uniform_block_buffer(c, c->bound_program->block_index_ViewTransforms);
+    const uint8_t* ubo_view_buf = context_buffer_data(c, ubo_view_index);
+    ubo_billboard_index = context_uniform_block_buffer(c, c->bound_program->block_index_BilloardConsts);
+    const uint8_t* billboard_buf_data = context_buffer_data(c, ubo_billboard_index);
+    if (!ubo_view_buf || !billboard_buf_data) return;
     const GLfloat atlas_scale = *((GLfloat*)(billboard_buf_data + c->bound_program->offset_uAtlasMeta) + 1);
 
     struct GLPluginDrawElementsVertexBillboardUserData vertex_userdata;
@@ -2477,6 +4024,7 @@ static void drawelements_handle_billboard(GLsizei count, const unsigned short* i
     vertex_userdata.indices = indices;
     vertex_userdata.atlas_scale = roundf(atlas_scale);
     vertex_userdata.settings_atlas = tex_settings;
+    texture_shadow_pin(c, tex_settings);
     vertex_userdata.vertex_position = &attributes[c->bound_program->loc_aVertexPositionDepthOffset];
     vertex_userdata.billboard_size = &attributes[c->bound_program->loc_aBillboardSize];
     vertex_userdata.vertex_colour = &attributes[c->bound_program->loc_aVertexColour];
@@ -2491,6 +4039,7 @@ static void drawelements_handle_billboard(GLsizei count, const unsigned short* i
 
     struct GLPluginTextureUserData tex_userdata;
     tex_userdata.tex = tex;
+    texture_shadow_pin(c, tex);
 
     struct GLPluginCameraUserData camera_userdata;
     camera_userdata.camera_position = (GLfloat*)(ubo_view_buf + c->bound_program->offset_uCameraPosition);
@@ -2505,6 +4054,9 @@ static void drawelements_handle_billboard(GLsizei count, const unsigned short* i
     render.vertex_functions.atlas_meta = glplugin_drawelements_vertexbillboard_atlas_meta;
     render.vertex_functions.atlas_xywh = glplugin_drawelements_vertexbillboard_meta_xywh;
     render.vertex_functions.colour = glplugin_drawelements_vertexbillboard_colour;
+    render.vertex_functions.xyz_batch = glplugin_drawelements_vertexbillboard_xyz_batch;
+    render.vertex_functions.uv_batch = glplugin_drawelements_vertexbillboard_uv_batch;
+    render.vertex_functions.colour_batch = glplugin_drawelements_vertexbillboard_colour_batch;
     render.matrix_functions.userdata = &matrix_userdata;
     render.matrix_functions.model_matrix = glplugin_matrixbillboard_modelmatrix;
     render.matrix_functions.view_matrix = glplugin_matrixbillboard_viewmatrix;
@@ -2516,6 +4068,7 @@ static void drawelements_handle_billboard(GLsizei count, const unsigned short* i
     render.texture_functions.size = glplugin_texture_size;
     render.texture_functions.compare = glplugin_texture_compare;
     render.texture_functions.data = glplugin_texture_data;
+    render.texture_functions.generation = glplugin_texture_generation;
     render.camera_functions.userdata = &camera_userdata;
     render.camera_functions.position = glplugin_camera_position;
 
@@ -2620,6 +4173,17 @@ static void drawelements_handle_2d_minimapterrain(const unsigned short* indices,
 
 // assumes count is 6
 static void drawelements_handle_2d_bigicon(const unsigned short* indices, struct GLTexture2D* tex, const GLfloat* projection_matrix, struct GLContext* c, const struct GLAttrBinding* attributes) {
+    if (EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERBIGICON)) && vao_mirror_attributes(c, c->bound_vao)) {
+        drawelements_handle_2d_bigicon_event(indices, tex, projection_matrix, c, attributes);
+    }
+    for (size_t i = 0; i < tex->icon.model_count; i += 1) {
+        free(tex->icon.models[i].vertices);
+    }
+    tex->icon.model_count = 0;
+}
+
+// assumes count is 6
+static void drawelements_handle_2d_bigicon_event(const unsigned short* indices, const struct GLTexture2D* tex, const GLfloat* projection_matrix, struct GLContext* c, const struct GLAttrBinding* attributes) {
     int32_t xy0[2];
     int32_t xy2[2];
     float abgr[4];
@@ -2639,10 +4203,6 @@ static void drawelements_handle_2d_bigicon(const unsigned short* indices, struct
         event.rgba[i] = abgr[3 - i];
     }
     _bolt_plugin_handle_renderbigicon(&event);
-    for (size_t i = 0; i < tex->icon.model_count; i += 1) {
-        free(tex->icon.models[i].vertices);
-    }
-    tex->icon.model_count = 0;
 }
 
 // takes a plugin-level handler for render2d and a handler for rendericon, and may call each of them one or more times
@@ -2660,6 +4220,7 @@ static void drawelements_handle_2d_normal(GLsizei count, const unsigned short* i
 
     struct GLPluginTextureUserData tex_userdata;
     tex_userdata.tex = tex;
+    texture_shadow_pin(c, tex);
 
     struct RenderBatch2D batch;
     batch.screen_width = roundf(2.0 / projection_matrix[0]);
@@ -2671,11 +4232,16 @@ static void drawelements_handle_2d_normal(GLsizei count, const unsigned short* i
     batch.vertex_functions.atlas_details = glplugin_drawelements_vertex2d_atlas_details;
     batch.vertex_functions.uv = glplugin_drawelements_vertex2d_uv;
     batch.vertex_functions.colour = glplugin_drawelements_vertex2d_colour;
+    batch.vertex_functions.xy_batch = glplugin_drawelements_vertex2d_xy_batch;
+    batch.vertex_functions.atlas_details_batch = glplugin_drawelements_vertex2d_atlas_details_batch;
+    batch.vertex_functions.uv_batch = glplugin_drawelements_vertex2d_uv_batch;
+    batch.vertex_functions.colour_batch = glplugin_drawelements_vertex2d_colour_batch;
     batch.texture_functions.userdata = &tex_userdata;
     batch.texture_functions.id = glplugin_texture_id;
     batch.texture_functions.size = glplugin_texture_size;
     batch.texture_functions.compare = glplugin_texture_compare;
     batch.texture_functions.data = glplugin_texture_data;
+    batch.texture_functions.generation = glplugin_texture_generation;
 
     if (tex->icons) {
         size_t batch_start = 0;
@@ -2729,10 +4295,10 @@ static void drawelements_handle_2d_normal(GLsizei count, const unsigned short* i
 }
 
 static void drawelements_handle_3d_silhouette(struct GLContext* c) {
-    GLint ubo_binding, ubo_index;
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ModelConsts, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_index);
-    const GLfloat* model_matrix = (GLfloat*)(((uint8_t*)context_get_buffer(c, ubo_index)->data) + c->bound_program->offset_uModelMatrix);
+    const GLuint ubo_index = context_uniform_block_buffer(c, c->bound_program->block_index_ModelConsts);
+    const uint8_t* ubo_model_buf = context_buffer_data(c, ubo_index);
+    if (!ubo_model_buf) return;
+    const GLfloat* model_matrix = (GLfloat*)(ubo_model_buf + c->bound_program->offset_uModelMatrix);
     c->player_model_x = (int32_t)roundf(model_matrix[12]);
     c->player_model_y = (int32_t)roundf(model_matrix[13]);
     c->player_model_z = (int32_t)roundf(model_matrix[14]);
@@ -2741,26 +4307,31 @@ static void drawelements_handle_3d_silhouette(struct GLContext* c) {
 static void drawelements_handle_3d_normal(GLsizei count, const unsigned short* indices, struct GLContext* c, const struct GLAttrBinding* attributes) {
     frames_without_3d = 0;
     drawelements_update_depth_tex(c);
+    if (!EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDER3D))) return;
+    if (!vao_mirror_attributes(c, c->bound_vao)) return;
 
-    GLint atlas, settings_atlas, ubo_binding, ubo_view_index, ubo_batch_index, ubo_model_index;
-    gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uTextureAtlas, &atlas);
-    gl.GetUniformiv(c->bound_program->id, c->bound_program->loc_uTextureAtlasSettings, &settings_atlas);
+    GLint atlas, settings_atlas;
+    GLuint ubo_view_index, ubo_batch_index, ubo_model_index;
+    atlas = c->bound_program->val_uTextureAtlas;
+    settings_atlas = c->bound_program->val_uTextureAtlasSettings;
     struct GLTexture2D* tex = CONTEXT_GET_TEX_BINDING(c, atlas, texture_2d);
     struct GLTexture2D* tex_settings = CONTEXT_GET_TEX_BINDING(c, settings_atlas, texture_2d);
     if (!tex || !tex_settings) return;
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ViewTransforms, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_view_index);
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_BatchConsts, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_batch_index);
-    gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ModelConsts, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-    gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_model_index);
-    const GLfloat atlas_scale = *((GLfloat*)(((uint8_t*)context_get_buffer(c, ubo_batch_index)->data) + c->bound_program->offset_uAtlasMeta) + 1);
+    ubo_view_index = context_uniform_block_buffer(c, c->bound_program->block_index_ViewTransforms);
+    ubo_batch_index = context_uniform_block_buffer(c, c->bound_program->block_index_BatchConsts);
+    ubo_model_index = context_uniform_block_buffer(c, c->bound_program->block_index_ModelConsts);
+    const uint8_t* ubo_view_buf = context_buffer_data(c, ubo_view_index);
+    const uint8_t* ubo_batch_buf = context_buffer_data(c, ubo_batch_index);
+    const uint8_t* ubo_model_buf = context_buffer_data(c, ubo_model_index);
+    if (!ubo_view_buf || !ubo_batch_buf || !ubo_model_buf) return;
+    const GLfloat atlas_scale = *((GLfloat*)(ubo_batch_buf + c->bound_program->offset_uAtlasMeta) + 1);
 
     struct GLPluginDrawElementsVertex3DUserData vertex_userdata;
     vertex_userdata.c = c;
     vertex_userdata.indices = indices;
     vertex_userdata.atlas_scale = roundf(atlas_scale);
     vertex_userdata.settings_atlas = tex_settings;
+    texture_shadow_pin(c, tex_settings);
     vertex_userdata.xy_xz = &attributes[c->bound_program->loc_aMaterialSettingsSlotXY_TilePositionXZ];
     vertex_userdata.xyz_bone = &attributes[c->bound_program->loc_aVertexPosition_BoneLabel];
     vertex_userdata.tex_uv = &attributes[c->bound_program->loc_aTextureUV];
@@ -2768,13 +4339,13 @@ static void drawelements_handle_3d_normal(GLsizei count, const unsigned short* i
     vertex_userdata.skin_bones = &attributes[c->bound_program->loc_aVertexSkinBones];
     vertex_userdata.skin_weights = &attributes[c->bound_program->loc_aVertexSkinWeights];
     vertex_userdata.transforms_ubo = NULL;
+    vertex_userdata.vertex_count = count;
 
     struct GLPluginTextureUserData tex_userdata;
     tex_userdata.tex = tex;
+    texture_shadow_pin(c, tex);
 
     struct GLPlugin3DMatrixUserData matrix_userdata;
-    const uint8_t* ubo_view_buf = (uint8_t*)(context_get_buffer(c, ubo_view_index)->data);
-    const uint8_t* ubo_model_buf = (uint8_t*)(context_get_buffer(c, ubo_model_index)->data);
     matrix_userdata.model_matrix = (GLfloat*)(ubo_model_buf + c->bound_program->offset_uModelMatrix);
     matrix_userdata.view_matrix = (GLfloat*)(ubo_view_buf + c->bound_program->offset_uViewMatrix);
     matrix_userdata.projection_matrix = (GLfloat*)(ubo_view_buf + c->bound_program->offset_uProjectionMatrix);
@@ -2794,11 +4365,17 @@ static void drawelements_handle_3d_normal(GLsizei count, const unsigned short* i
     render.vertex_functions.uv = glplugin_drawelements_vertex3d_uv;
     render.vertex_functions.colour = glplugin_drawelements_vertex3d_colour;
     render.vertex_functions.bone_transform = glplugin_drawelements_vertex3d_transform;
+    render.vertex_functions.xyz_batch = glplugin_drawelements_vertex3d_xyz_batch;
+    render.vertex_functions.uv_batch = glplugin_drawelements_vertex3d_uv_batch;
+    render.vertex_functions.colour_batch = glplugin_drawelements_vertex3d_colour_batch;
+    render.vertex_functions.bone_id_batch = glplugin_drawelements_vertex3d_boneid_batch;
+    render.vertex_functions.model_hash = glplugin_drawelements_vertex3d_modelhash;
     render.texture_functions.userdata = &tex_userdata;
     render.texture_functions.id = glplugin_texture_id;
     render.texture_functions.size = glplugin_texture_size;
     render.texture_functions.compare = glplugin_texture_compare;
     render.texture_functions.data = glplugin_texture_data;
+    render.texture_functions.generation = glplugin_texture_generation;
     render.matrix_functions.userdata = &matrix_userdata;
     render.matrix_functions.model_matrix = glplugin_matrix3d_modelmatrix;
     render.matrix_functions.view_matrix = glplugin_matrix3d_viewmatrix;
@@ -2816,19 +4393,21 @@ static void drawelements_handle_3d_iconrender(GLsizei count, const unsigned shor
     const uint8_t is_icon = tex && tex->compare_mode == GL_NONE && tex->internalformat == GL_RGBA8 && tex->width == GAME_ITEM_ICON_SIZE && tex->height == GAME_ITEM_ICON_SIZE;
     const uint8_t is_big_icon = tex && tex->internalformat == GL_RGBA8 && tex->width == GAME_ITEM_BIGICON_SIZE && tex->height == GAME_ITEM_BIGICON_SIZE;
     if ((is_icon || is_big_icon) && tex->icon.model_count < MAX_MODELS_PER_ICON) {
+        // icon models are only ever read by rendericon and renderbigicon events
+        if (!EVENTS_SUBSCRIBED(PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERICON) | PLUGIN_EVENT_BIT(PLUGIN_EVENT_RENDERBIGICON))) return;
+        if (!vao_mirror_attributes(c, c->bound_vao)) return;
+        const GLuint ubo_model_index = context_uniform_block_buffer(c, c->bound_program->block_index_ModelConsts);
+        const GLuint ubo_view_index = context_uniform_block_buffer(c, c->bound_program->block_index_ViewTransforms);
+        const uint8_t* ubo_model_buf = context_buffer_data(c, ubo_model_index);
+        const uint8_t* ubo_view_buf = context_buffer_data(c, ubo_view_index);
+        if (!ubo_model_buf || !ubo_view_buf) return;
         struct IconModel* model = &tex->icon.models[tex->icon.model_count];
         tex->icon.model_count += 1;
         tex->icon.is_big_icon = is_big_icon;
-        GLint ubo_binding, ubo_model_index, ubo_view_index;
-        gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ModelConsts, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-        gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_model_index);
-        const GLfloat* model_matrix = (GLfloat*)(((uint8_t*)context_get_buffer(c, ubo_model_index)->data) + c->bound_program->offset_uModelMatrix);
+        const GLfloat* model_matrix = (GLfloat*)(ubo_model_buf + c->bound_program->offset_uModelMatrix);
         for (size_t i = 0; i < 16; i += 1) {
             model->model_matrix.matrix[i] = (double)model_matrix[i];
         }
-        gl.GetActiveUniformBlockiv(c->bound_program->id, c->bound_program->block_index_ViewTransforms, GL_UNIFORM_BLOCK_BINDING, &ubo_binding);
-        gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, ubo_binding, &ubo_view_index);
-        const uint8_t* ubo_view_buf = (uint8_t*)context_get_buffer(c, ubo_view_index)->data;
         const float* viewmatrix = (float*)(ubo_view_buf + c->bound_program->offset_uViewMatrix);
         const float* projmatrix = (float*)(ubo_view_buf + c->bound_program->offset_uProjectionMatrix);
         const float* viewprojmatrix = (float*)(ubo_view_buf + c->bound_program->offset_uViewProjMatrix);
@@ -2870,8 +4449,9 @@ DEFGETMATRIX(TYPE, inv_view, STRUCT)
 DEFGETMATRIX(TYPE, model, STRUCT) \
 DEFNORMALMATRIXGETTERS(TYPE, STRUCT)
 
-static void xywh_from_meta_atlas(const struct GLTexture2D* settings_atlas, size_t slot_x, size_t slot_y, int scale, int32_t* out) {
+static void xywh_from_meta_atlas(struct GLTexture2D* settings_atlas, size_t slot_x, size_t slot_y, int scale, int32_t* out) {
     // this is pretty wild
+    texture_decode_region(settings_atlas, slot_x * 3, slot_y * 4, 3, 3, false);
     const uint8_t* settings_ptr = settings_atlas->data + (slot_y * settings_atlas->width * 4 * 4) + (slot_x * 3 * 4);
     const uint8_t bitmask = *(settings_ptr + (settings_atlas->width * 2 * 4) + 7);
     out[0] = ((int32_t)(*settings_ptr) + (bitmask & 1 ? 256 : 0)) * scale;
@@ -2953,8 +4533,8 @@ static void surface_draw(const struct GLContext* c, const struct PluginSurfaceUs
     if (cull_face) lgl->Enable(GL_CULL_FACE);
     if (!blend) lgl->Disable(GL_BLEND);
     lgl->Viewport(c->viewport_x, c->viewport_y, c->viewport_w, c->viewport_h);
-    const struct TextureUnit* unit = &c->texture_units[c->active_texture];
-    lgl->BindTexture(unit->target, unit->recent);
+    const struct TextureUnit* unit = context_active_texture_unit(c);
+    if (unit) lgl->BindTexture(unit->target, unit->recent);
     gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, c->current_draw_framebuffer);
     gl.BindVertexArray(c->bound_vao->id);
     gl.UseProgram(c->bound_program ? c->bound_program->id : 0);
@@ -2962,8 +4542,6 @@ static void surface_draw(const struct GLContext* c, const struct PluginSurfaceUs
 
 static void shaderprogram_draw(const struct PluginProgramUserdata* program, const struct PluginShaderBufferUserdata* buffer, uint32_t count, GLuint target_fb, GLsizei width, GLsizei height) {
     const struct GLContext* c = _bolt_context();
-    GLint array_binding;
-    lgl->GetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_binding);
     GLboolean depth_test, scissor_test, cull_face, blend;
     lgl->GetBooleanv(GL_DEPTH_TEST, &depth_test);
     lgl->GetBooleanv(GL_SCISSOR_TEST, &scissor_test);
@@ -3001,7 +4579,7 @@ static void shaderprogram_draw(const struct PluginProgramUserdata* program, cons
     lgl->DrawArrays(GL_TRIANGLES, 0, count);
 
     if (active_texture > 0) {
-        for (size_t i = 0; i < active_texture; i += 1) {
+        for (size_t i = 0; i < active_texture && i < (size_t)c->texture_unit_count; i += 1) {
             gl.ActiveTexture(GL_TEXTURE0 + i);
             lgl->BindTexture(c->texture_units[i].target, c->texture_units[i].recent);
         }
@@ -3012,7 +4590,7 @@ static void shaderprogram_draw(const struct PluginProgramUserdata* program, cons
     if (cull_face) lgl->Enable(GL_CULL_FACE);
     if (!blend) lgl->Disable(GL_BLEND);
     lgl->Viewport(c->viewport_x, c->viewport_y, c->viewport_w, c->viewport_h);
-    gl.BindBuffer(GL_ARRAY_BUFFER, array_binding);
+    gl.BindBuffer(GL_ARRAY_BUFFER, c->bound_array_buffer);
     gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, c->current_draw_framebuffer);
     gl.BindVertexArray(c->bound_vao->id);
     gl.UseProgram(c->bound_program ? c->bound_program->id : 0);    
@@ -3138,7 +4716,7 @@ static void glplugin_drawelements_vertex3d_transform(size_t vertex, void* userda
         bone_id = (uint8_t)(uint32_t)(int32_t)roundf(xyzbone_floats[3]);
     }
     if (data->c->bound_program->block_index_VertexTransformData == -1) return;
-    bone_index_transform(data->c, &data->transforms_ubo, bone_id, out);
+    if (!bone_index_transform(data->c, &data->transforms_ubo, bone_id, out)) return;
     
     GLfloat smooth_skinning = *(GLfloat*)(((uint8_t*)data->transforms_ubo->data) + data->c->bound_program->offset_uSmoothSkinning);
     if (smooth_skinning < 0.0) return;
@@ -3160,13 +4738,7 @@ static void glplugin_drawelements_vertex3d_transform(size_t vertex, void* userda
         for (size_t i = 0; i < 4; i += 1) {
             bone_index_transform(data->c, &data->transforms_ubo, skin_bones[i], &weighted_modifiers[i]);
         }
-        for (size_t i = 0; i < 16; i += 1) {
-            modifier.matrix[i] =
-                weighted_modifiers[0].matrix[i] * skin_weights[0] +
-                weighted_modifiers[1].matrix[i] * skin_weights[1] +
-                weighted_modifiers[2].matrix[i] * skin_weights[2] +
-                weighted_modifiers[3].matrix[i] * skin_weights[3];
-        }
+        blend_transforms(weighted_modifiers, skin_weights, &modifier);
     } else {
         bone_index_transform(data->c, &data->transforms_ubo, skin_bones[0], &modifier);
     }
@@ -3423,11 +4995,231 @@ static void glplugin_drawelements_vertexbillboard_colour(size_t index, void* use
     out[3] = (double)rgba[3];
 }
 
+// number of vertices whose float attributes are decoded at a time by the batch functions below, which then
+// convert them into the caller's output
+#define VERTEXDECODECHUNK 256
+
+static void glplugin_drawelements_vertex2d_xy_batch(size_t first, size_t count, void* userdata, int32_t* out) {
+    const struct GLPluginDrawElementsVertex2DUserData* data = userdata;
+    const unsigned short* indices = data->indices + first;
+    // see glplugin_drawelements_vertex2d_xy for why Y is measured from screen_height rather than screen_height - 1
+    if (attr_get_binding_int_batch(data->c, data->position, indices, count, 2, out)) {
+        for (size_t i = 0; i < count; i += 1) out[(i * 2) + 1] = (int32_t)data->screen_height - out[(i * 2) + 1];
+        return;
+    }
+    float pos[VERTEXDECODECHUNK * 2];
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) {
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK;
+        attr_get_binding_batch(data->c, data->position, indices + done, n, 2, pos);
+        int32_t* o = out + (done * 2);
+        for (size_t i = 0; i < n; i += 1) {
+            o[i * 2] = (int32_t)roundf(pos[i * 2]);
+            o[(i * 2) + 1] = (int32_t)data->screen_height - (int32_t)roundf(pos[(i * 2) + 1]);
+        }
+    }
+}
+
+static void glplugin_drawelements_vertex2d_atlas_details_batch(size_t first, size_t count, void* userdata, int32_t* out, uint8_t* wrapx, uint8_t* wrapy) {
+    const struct GLPluginDrawElementsVertex2DUserData* data = userdata;
+    const unsigned short* indices = data->indices + first;
+    const float width = (float)data->atlas->width;
+    const float height = (float)data->atlas->height;
+    float xy[VERTEXDECODECHUNK * 2];
+    float wh[VERTEXDECODECHUNK * 2];
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) {
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK;
+        attr_get_binding_batch(data->c, data->atlas_min, indices + done, n, 2, xy);
+        attr_get_binding_batch(data->c, data->atlas_size, indices + done, n, 2, wh);
+        for (size_t i = 0; i < n; i += 1) {
+            int32_t* o = out + ((done + i) * 4);
+            o[0] = (int32_t)roundf(xy[i * 2] * width);
+            o[1] = (int32_t)roundf(xy[(i * 2) + 1] * height);
+            o[2] = (int32_t)roundf(fabsf(wh[i * 2]) * width);
+            o[3] = (int32_t)roundf(fabsf(wh[(i * 2) + 1]) * height);
+            wrapx[done + i] = wh[i * 2] > 0.0;
+            wrapy[done + i] = wh[(i * 2) + 1] > 0.0;
+        }
+    }
+}
+
+static void glplugin_drawelements_vertex2d_uv_batch(size_t first, size_t count, void* userdata, double* out, uint8_t* discard) {
+    const struct GLPluginDrawElementsVertex2DUserData* data = userdata;
+    const unsigned short* indices = data->indices + first;
+    float uv[VERTEXDECODECHUNK * 2];
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) {
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK;
+        attr_get_binding_batch(data->c, data->tex_uv, indices + done, n, 2, uv);
+        for (size_t i = 0; i < n * 2; i += 1) out[(done * 2) + i] = (double)uv[i];
+        for (size_t i = 0; i < n; i += 1) discard[done + i] = uv[i * 2] < -60000.0; // hard-coded shader value
+    }
+}
+
+static void glplugin_drawelements_vertex2d_colour_batch(size_t first, size_t count, void* userdata, double* out) {
+    const struct GLPluginDrawElementsVertex2DUserData* data = userdata;
+    const unsigned short* indices = data->indices + first;
+    float colour[VERTEXDECODECHUNK * 4];
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) {
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK;
+        attr_get_binding_batch(data->c, data->colour, indices + done, n, 4, colour);
+        // ABGR, as in glplugin_drawelements_vertex2d_colour
+        for (size_t i = 0; i < n; i += 1) {
+            double* o = out + ((done + i) * 4);
+            o[0] = (double)colour[(i * 4) + 3];
+            o[1] = (double)colour[(i * 4) + 2];
+            o[2] = (double)colour[(i * 4) + 1];
+            o[3] = (double)colour[i * 4];
+        }
+    }
+}
+
+// defines NAME_batch, which decodes the SIZE-float attribute FIELD of `count` consecutive vertices and writes it out
+// as doubles, for vertex functions which return an attribute unchanged
+#define DEFVERTEXBATCHFLOAT(NAME, USERDATA, FIELD, SIZE) \
+static void glplugin_drawelements_##NAME##_batch(size_t first, size_t count, void* userdata, double* out) { \
+    const struct USERDATA* data = userdata; \
+    const unsigned short* indices = data->indices + first; \
+    float values[VERTEXDECODECHUNK * SIZE]; \
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) { \
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK; \
+        attr_get_binding_batch(data->c, data->FIELD, indices + done, n, SIZE, values); \
+        for (size_t i = 0; i < n * SIZE; i += 1) out[(done * SIZE) + i] = (double)values[i]; \
+    } \
+}
+
+// as above, for vertex positions, which are decoded as integers where the attribute type allows it, and as floats
+// otherwise. only X, Y and Z are written out.
+#define DEFVERTEXBATCHPOINT(NAME, USERDATA, FIELD) \
+static void glplugin_drawelements_##NAME##_batch(size_t first, size_t count, void* userdata, double* out) { \
+    const struct USERDATA* data = userdata; \
+    const unsigned short* indices = data->indices + first; \
+    int32_t ints[VERTEXDECODECHUNK * 3]; \
+    float floats[VERTEXDECODECHUNK * 3]; \
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) { \
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK; \
+        if (attr_get_binding_int_batch(data->c, data->FIELD, indices + done, n, 3, ints)) { \
+            for (size_t i = 0; i < n * 3; i += 1) out[(done * 3) + i] = (double)ints[i]; \
+        } else { \
+            attr_get_binding_batch(data->c, data->FIELD, indices + done, n, 3, floats); \
+            for (size_t i = 0; i < n * 3; i += 1) out[(done * 3) + i] = (double)floats[i]; \
+        } \
+    } \
+}
+
+// defines FUNC_batch, which calls FUNC for `count` consecutive vertices, each one writing SIZE values. only used for
+// particle vertices, whose values aren't a straight decode of a single attribute.
+#define DEFVERTEXBATCH(FUNC, TYPE, SIZE) \
+static void FUNC##_batch(size_t first, size_t count, void* userdata, TYPE* out) { \
+    for (size_t i = 0; i < count; i += 1) FUNC(first + i, userdata, out + (i * SIZE)); \
+}
+
+static void glplugin_drawelements_vertexparticles_xyz_batch(size_t first, size_t count, void* userdata, double* out) {
+    struct Point3D point;
+    for (size_t i = 0; i < count; i += 1) {
+        glplugin_drawelements_vertexparticles_xyz(first + i, userdata, &point);
+        for (size_t j = 0; j < 3; j += 1) {
+            out[(i * 3) + j] = point.integer ? (double)point.xyzh.ints[j] : point.xyzh.floats[j];
+        }
+    }
+}
+
+DEFVERTEXBATCHPOINT(vertex3d_xyz, GLPluginDrawElementsVertex3DUserData, xyz_bone)
+DEFVERTEXBATCHFLOAT(vertex3d_uv, GLPluginDrawElementsVertex3DUserData, tex_uv, 2)
+DEFVERTEXBATCHFLOAT(vertex3d_colour, GLPluginDrawElementsVertex3DUserData, colour, 4)
+DEFVERTEXBATCH(glplugin_drawelements_vertexparticles_uv, double, 2)
+DEFVERTEXBATCHFLOAT(vertexparticles_colour, GLPluginDrawElementsVertexParticlesUserData, colour, 4)
+DEFVERTEXBATCHPOINT(vertexbillboard_xyz, GLPluginDrawElementsVertexBillboardUserData, vertex_position)
+DEFVERTEXBATCHFLOAT(vertexbillboard_colour, GLPluginDrawElementsVertexBillboardUserData, vertex_colour, 4)
+
+#undef DEFVERTEXBATCHFLOAT
+#undef DEFVERTEXBATCHPOINT
+#undef DEFVERTEXBATCH
+
+static void glplugin_drawelements_vertexbillboard_uv_batch(size_t first, size_t count, void* userdata, double* out) {
+    const struct GLPluginDrawElementsVertexBillboardUserData* data = userdata;
+    const unsigned short* indices = data->indices + first;
+    int32_t xyuv[VERTEXDECODECHUNK * 4];
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) {
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK;
+        if (!attr_get_binding_int_batch(data->c, data->material_xy_uv, indices + done, n, 4, xyuv)) {
+            memset(xyuv, 0, n * 4 * sizeof(*xyuv));
+        }
+        for (size_t i = 0; i < n; i += 1) {
+            out[(done + i) * 2] = (double)xyuv[(i * 4) + 2];
+            out[((done + i) * 2) + 1] = (double)xyuv[(i * 4) + 3];
+        }
+    }
+}
+
+static void glplugin_drawelements_vertex3d_boneid_batch(size_t first, size_t count, void* userdata, uint8_t* out) {
+    const struct GLPluginDrawElementsVertex3DUserData* data = userdata;
+    const unsigned short* indices = data->indices + first;
+    int32_t ints[VERTEXDECODECHUNK * 4];
+    float floats[VERTEXDECODECHUNK * 4];
+    for (size_t done = 0; done < count; done += VERTEXDECODECHUNK) {
+        const size_t n = (count - done) < VERTEXDECODECHUNK ? (count - done) : VERTEXDECODECHUNK;
+        if (attr_get_binding_int_batch(data->c, data->xyz_bone, indices + done, n, 4, ints)) {
+            for (size_t i = 0; i < n; i += 1) out[done + i] = (uint8_t)(uint32_t)ints[(i * 4) + 3];
+        } else {
+            attr_get_binding_batch(data->c, data->xyz_bone, indices + done, n, 4, floats);
+            for (size_t i = 0; i < n; i += 1) out[done + i] = (uint8_t)(uint32_t)(int32_t)roundf(floats[(i * 4) + 3]);
+        }
+    }
+}
+
+#undef VERTEXDECODECHUNK
+
+static uint64_t glplugin_drawelements_vertex3d_modelhash(void* userdata) {
+    const struct GLPluginDrawElementsVertex3DUserData* data = userdata;
+    const struct GLAttrBinding* position = data->xyz_bone;
+    const struct GLArrayBuffer* element_buffer = context_get_buffer(data->c, context_bound_buffer(data->c, GL_ELEMENT_ARRAY_BUFFER));
+    if (!element_buffer || !element_buffer->data || !position->buffer || !position->buffer->data) return 0;
+
+    // a draw's hash can only change if one of these does, so they're used to look up previous results
+    const uintptr_t index_offset = (uintptr_t)((const uint8_t*)data->indices - (const uint8_t*)element_buffer->data);
+    const uint64_t element_generation = element_buffer->generation;
+    const uint64_t vertex_generation = position->buffer->generation;
+    const uint64_t key = (element_generation * 0x9E3779B97F4A7C15ull) ^ (vertex_generation * 0xC2B2AE3D27D4EB4Full) ^ ((uint64_t)index_offset << 16) ^ data->vertex_count ^ position->offset;
+    struct ModelHashCacheEntry* entry = &model_hash_cache[(key * 0x9E3779B97F4A7C15ull) >> (64 - MODEL_HASH_CACHE_BITS)];
+    if (entry->element_generation == element_generation && entry->vertex_generation == vertex_generation && entry->index_offset == index_offset && entry->vertex_count == data->vertex_count && entry->attr_offset == position->offset && entry->attr_stride == position->stride) {
+        return entry->hash;
+    }
+
+    // hash the decoded position and bone label of every vertex in draw order, so the result doesn't
+    // depend on where the model happens to be in the game's buffers
+    const size_t components = position->size < 4 ? position->size : 4;
+    int32_t* values = calloc(data->vertex_count * 4, sizeof(*values));
+    if (!values) return 0;
+    for (size_t i = 0; i < data->vertex_count; i += 1) {
+        if (!attr_get_binding_int(data->c, position, data->indices[i], components, values + (i * 4))) {
+            float pos[4];
+            attr_get_binding(data->c, position, data->indices[i], components, pos);
+            memcpy(values + (i * 4), pos, components * sizeof(*pos));
+        }
+    }
+    // hash is truncated to 53 bits so that it fits exactly in a lua number
+    const uint64_t hash = hashmap_murmur(values, data->vertex_count * 4 * sizeof(*values), 0, 0) & ((1ull << 53) - 1);
+    free(values);
+
+    entry->element_generation = element_generation;
+    entry->vertex_generation = vertex_generation;
+    entry->index_offset = index_offset;
+    entry->vertex_count = data->vertex_count;
+    entry->attr_offset = position->offset;
+    entry->attr_stride = position->stride;
+    entry->hash = hash;
+    return hash;
+}
+
 static size_t glplugin_texture_id(void* userdata) {
     const struct GLPluginTextureUserData* data = userdata;
     return data->tex->id;
 }
 
+static uint64_t glplugin_texture_generation(void* userdata) {
+    const struct GLPluginTextureUserData* data = userdata;
+    return data->tex->generation;
+}
+
 static void glplugin_texture_size(void* userdata, size_t* out) {
     const struct GLPluginTextureUserData* data = userdata;
     out[0] = data->tex->width;
@@ -3445,13 +5237,16 @@ static uint8_t glplugin_texture_compare(void* userdata, size_t x, size_t y, size
         );
         return 0;
     }
+    texture_decode_bytes(data_->tex, start_offset, len);
     return !memcmp(tex->data + start_offset, data, len);
 }
 
-static uint8_t* glplugin_texture_data(void* userdata, size_t x, size_t y) {
+static uint8_t* glplugin_texture_data(void* userdata, size_t x, size_t y, size_t len) {
     const struct GLPluginTextureUserData* data = userdata;
-    const struct GLTexture2D* tex = data->tex;
-    return tex->data + (tex->width * y * 4) + (x * 4);
+    struct GLTexture2D* tex = data->tex;
+    const size_t start_offset = (tex->width * y * 4) + (x * 4);
+    texture_decode_bytes(tex, start_offset, len);
+    return tex->data + start_offset;
 }
 
 static void glplugin_camera_position(void* userdata, double* out) {
@@ -3492,7 +5287,8 @@ static void glplugin_surface_init(struct SurfaceFunctions* functions, unsigned i
     functions->set_alpha = glplugin_surface_set_alpha;
 
     const struct GLTexture2D* original_tex = CONTEXT_GET_TEX_CURRENT(c, texture_2d);
-    lgl->BindTexture(GL_TEXTURE_2D, c->texture_units[c->active_texture].texture_2d);
+    const struct TextureUnit* unit = context_active_texture_unit(c);
+    if (unit) lgl->BindTexture(GL_TEXTURE_2D, unit->texture_2d);
     gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, c->current_draw_framebuffer);
 }
 
@@ -3526,7 +5322,8 @@ static void glplugin_surface_subimage(void* _userdata, int x, int y, int w, int
     const struct GLContext* c = _bolt_context();
     lgl->BindTexture(GL_TEXTURE_2D, userdata->renderbuffer);
     lgl->TexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, is_bgra ? GL_BGRA : GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-    lgl->BindTexture(GL_TEXTURE_2D, c->texture_units[c->active_texture].texture_2d);
+    const struct TextureUnit* unit = context_active_texture_unit(c);
+    if (unit) lgl->BindTexture(GL_TEXTURE_2D, unit->texture_2d);
 }
 
 static void glplugin_surface_drawtoscreen(void* userdata, int sx, int sy, int sw, int sh, int dx, int dy, int dw, int dh) {
@@ -3593,6 +5390,193 @@ static void glplugin_read_screen_pixels(int16_t x, int16_t y, uint32_t width, ui
     gl.BindFramebuffer(GL_READ_FRAMEBUFFER, c->current_read_framebuffer);
 }
 
+static void* glplugin_capture_screen_init(void) {
+    return calloc(1, sizeof(struct ScreenCapture));
+}
+
+// makes sure the shared downscaling target is at least the given size
+static void screen_capture_scale_target_init(const struct GLContext* c, uint32_t width, uint32_t height) {
+    if (width <= screen_capture_scale_width && height <= screen_capture_scale_height) return;
+    if (screen_capture_scale_fb) {
+        gl.DeleteFramebuffers(1, &screen_capture_scale_fb);
+        lgl->DeleteTextures(1, &screen_capture_scale_tex);
+    }
+    if (width > screen_capture_scale_width) screen_capture_scale_width = width;
+    if (height > screen_capture_scale_height) screen_capture_scale_height = height;
+    gl.GenFramebuffers(1, &screen_capture_scale_fb);
+    lgl->GenTextures(1, &screen_capture_scale_tex);
+    gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, screen_capture_scale_fb);
+    lgl->BindTexture(GL_TEXTURE_2D, screen_capture_scale_tex);
+    gl.TexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, screen_capture_scale_width, screen_capture_scale_height);
+    gl.FramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, screen_capture_scale_tex, 0);
+    const struct TextureUnit* unit = context_active_texture_unit(c);
+    if (unit) lgl->BindTexture(GL_TEXTURE_2D, unit->texture_2d);
+    gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, c->current_draw_framebuffer);
+}
+
+// drops a reference to a readback, returning it to the pool (or freeing it) if that was the last one
+static void screen_readback_release(struct ScreenReadback* readback) {
+    readback->refcount -= 1;
+    if (readback->refcount) return;
+    if (screen_readback_latest == readback) screen_readback_latest = NULL;
+    if (readback->fence) {
+        gl.DeleteSync(readback->fence);
+        readback->fence = NULL;
+    }
+    if (screen_readback_pool_count < SCREEN_READBACK_POOL_SIZE) {
+        screen_readback_pool[screen_readback_pool_count] = readback;
+        screen_readback_pool_count += 1;
+    } else {
+        gl.DeleteBuffers(1, &readback->buffer);
+        free(readback);
+    }
+}
+
+// starts reading back a region of the screen into a new readback, which starts with one reference
+static struct ScreenReadback* screen_readback_start(const struct GLContext* c, int16_t x, int16_t y, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height, uint8_t format) {
+    struct ScreenReadback* readback;
+    if (screen_readback_pool_count) {
+        screen_readback_pool_count -= 1;
+        readback = screen_readback_pool[screen_readback_pool_count];
+    } else {
+        readback = calloc(1, sizeof(struct ScreenReadback));
+        gl.GenBuffers(1, &readback->buffer);
+    }
+
+    const GLenum gl_format = (format == IPC_CAPTURE_RGBA) ? GL_RGBA : ((format == IPC_CAPTURE_RED) ? GL_RED : GL_RGB);
+    const GLsizeiptr size = (GLsizeiptr)out_width * out_height * IPC_CAPTURE_BYTES_PER_PIXEL(format);
+    const GLint src_y = gl_height - (y + height);
+    GLint pack_buffer, pack_alignment;
+    lgl->GetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack_buffer);
+    lgl->GetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+    if (readback->buffer_size < size) {
+        gl.BufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        readback->buffer_size = size;
+    }
+    lgl->PixelStorei(GL_PACK_ALIGNMENT, 1);
+    gl.BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    if (out_width == width && out_height == height) {
+        lgl->ReadPixels(x, src_y, width, height, gl_format, GL_UNSIGNED_BYTE, NULL);
+    } else {
+        // downscale on the GPU so that only the small image has to be read back
+        GLboolean scissor_test;
+        lgl->GetBooleanv(GL_SCISSOR_TEST, &scissor_test);
+        if (scissor_test) lgl->Disable(GL_SCISSOR_TEST);
+        screen_capture_scale_target_init(c, out_width, out_height);
+        gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, screen_capture_scale_fb);
+        gl.BlitFramebuffer(x, src_y, x + width, src_y + height, 0, 0, out_width, out_height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, c->current_draw_framebuffer);
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, screen_capture_scale_fb);
+        lgl->ReadPixels(0, 0, out_width, out_height, gl_format, GL_UNSIGNED_BYTE, NULL);
+        if (scissor_test) lgl->Enable(GL_SCISSOR_TEST);
+    }
+    gl.BindFramebuffer(GL_READ_FRAMEBUFFER, c->current_read_framebuffer);
+    lgl->PixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffer);
+    readback->fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback->frame = screen_capture_frame;
+    readback->x = x;
+    readback->y = y;
+    readback->src_width = width;
+    readback->src_height = height;
+    readback->width = out_width;
+    readback->height = out_height;
+    readback->format = format;
+    readback->refcount = 1;
+    return readback;
+}
+
+// if shared_only is set, the capture is only started if it can share a readback that's already been started
+// this frame, i.e. if it's free. returns whether a capture was started.
+static uint8_t glplugin_capture_screen_begin(void* userdata, int16_t x, int16_t y, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height, uint8_t format, uint8_t shared_only) {
+    const struct GLContext* c = _bolt_context();
+    struct ScreenCapture* capture = userdata;
+    struct ScreenReadback* latest = screen_readback_latest;
+    const uint8_t can_share = latest && latest->frame == screen_capture_frame && latest->x == x && latest->y == y && latest->src_width == width &&
+        latest->src_height == height && latest->width == out_width && latest->height == out_height && latest->format == format;
+    if (shared_only && !can_share) return false;
+    struct ScreenCaptureSlot* slot = NULL;
+    for (size_t i = 0; i < SCREEN_CAPTURE_SLOTS; i += 1) {
+        struct ScreenCaptureSlot* candidate = &capture->slots[i];
+        if (!candidate->readback) {
+            slot = candidate;
+            break;
+        }
+        if (!slot || candidate->sequence < slot->sequence) slot = candidate;
+    }
+    // if every slot is in flight, the oldest one is superseded by this one
+    if (slot->readback) {
+        screen_readback_release(slot->readback);
+        slot->readback = NULL;
+        if (capture->ready == slot) capture->ready = NULL;
+    }
+
+    if (can_share) {
+        latest->refcount += 1;
+        slot->readback = latest;
+    } else {
+        slot->readback = screen_readback_start(c, x, y, width, height, out_width, out_height, format);
+        screen_readback_latest = slot->readback;
+    }
+    screen_capture_sequence += 1;
+    slot->sequence = screen_capture_sequence;
+    return true;
+}
+
+static uint8_t glplugin_capture_screen_poll(void* userdata, uint32_t* width, uint32_t* height, uint8_t* format) {
+    struct ScreenCapture* capture = userdata;
+    // only the newest finished capture is worth delivering, so older ones don't need to be checked
+    capture->ready = NULL;
+    for (size_t i = 0; i < SCREEN_CAPTURE_SLOTS; i += 1) {
+        struct ScreenCaptureSlot* slot = &capture->slots[i];
+        if (!slot->readback) continue;
+        if (capture->ready && slot->sequence < capture->ready->sequence) continue;
+        const GLenum status = gl.ClientWaitSync(slot->readback->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) capture->ready = slot;
+    }
+    if (!capture->ready) return false;
+    *width = capture->ready->readback->width;
+    *height = capture->ready->readback->height;
+    *format = capture->ready->readback->format;
+    return true;
+}
+
+static void glplugin_capture_screen_read(void* userdata, void* data) {
+    struct ScreenCapture* capture = userdata;
+    if (!capture->ready) return;
+    const struct ScreenReadback* readback = capture->ready->readback;
+    const GLsizeiptr size = (GLsizeiptr)readback->width * readback->height * IPC_CAPTURE_BYTES_PER_PIXEL(readback->format);
+    GLint pack_buffer;
+    lgl->GetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pack_buffer);
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+    const void* contents = gl.MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (contents) {
+        memcpy(data, contents, size);
+        gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffer);
+
+    // this capture, and anything older than it, is now done with
+    const uint64_t sequence = capture->ready->sequence;
+    for (size_t i = 0; i < SCREEN_CAPTURE_SLOTS; i += 1) {
+        struct ScreenCaptureSlot* slot = &capture->slots[i];
+        if (slot->readback && slot->sequence <= sequence) {
+            screen_readback_release(slot->readback);
+            slot->readback = NULL;
+        }
+    }
+    capture->ready = NULL;
+}
+
+static void glplugin_capture_screen_destroy(void* userdata) {
+    struct ScreenCapture* capture = userdata;
+    for (size_t i = 0; i < SCREEN_CAPTURE_SLOTS; i += 1) {
+        if (capture->slots[i].readback) screen_readback_release(capture->slots[i].readback);
+    }
+    free(capture);
+}
+
 static void glplugin_copy_screen(void* userdata, int sx, int sy, int sw, int sh, int dx, int dy, int dw, int dh) {
     const struct GLContext* c = _bolt_context();
     const struct PluginSurfaceUserdata* surface = userdata;
@@ -3618,6 +5602,18 @@ static void glplugin_player_position(int32_t* x, int32_t* y, int32_t* z) {
     *z = c->player_model_z;
 }
 
+static void glplugin_texture_shadow_stats(struct TextureShadowStats* out) {
+    const struct GLContext* c = _bolt_context();
+    struct TextureShadows* s = c->texture_shadows;
+    _bolt_rwlock_lock_read(&s->rwlock);
+    out->bytes = s->bytes;
+    out->budget = s->budget;
+    out->evictions = s->evictions;
+    out->evicted_bytes = s->evicted_bytes;
+    out->restores = s->restores;
+    _bolt_rwlock_unlock_read(&s->rwlock);
+}
+
 static uint8_t glplugin_vertex_shader_init(struct ShaderFunctions* out, const char* source, int len, char* output, int output_len) {
     const GLuint shader = gl.CreateShader(GL_VERTEX_SHADER);
     const GLchar* sources[] = {GLSLHEADER, GLSLPLUGINEXTENSIONHEADER, source};
@@ -3826,12 +5822,11 @@ static void glplugin_shaderprogram_drawtogameview(void* userdata, void* gameview
 static void glplugin_shaderbuffer_init(struct ShaderBufferFunctions* out, const void* data, uint32_t len) {
     out->userdata = malloc(sizeof(struct PluginShaderBufferUserdata));
     struct PluginShaderBufferUserdata* buffer = out->userdata;
-    GLint array_binding;
-    lgl->GetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_binding);
+    const struct GLContext* c = _bolt_context();
     gl.GenBuffers(1, &buffer->buffer);
     gl.BindBuffer(GL_ARRAY_BUFFER, buffer->buffer);
     gl.BufferData(GL_ARRAY_BUFFER, len, data, GL_STATIC_DRAW);
-    gl.BindBuffer(GL_ARRAY_BUFFER, array_binding);
+    gl.BindBuffer(GL_ARRAY_BUFFER, c->bound_array_buffer);
 }
 
 static void glplugin_shaderbuffer_destroy(void* userdata) {
@@ -30,6 +30,8 @@ typedef void GLvoid;
 typedef char GLchar;
 typedef intptr_t GLintptr;
 typedef uintptr_t GLsizeiptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
 
 /* consts used from libgl */
 #define GL_NONE 0
@@ -40,6 +42,7 @@ typedef uintptr_t GLsizeiptr;
 #define GL_TEXTURE 5890
 #define GL_TEXTURE_2D 3553
 #define GL_TEXTURE_2D_MULTISAMPLE 37120
+#define GL_RED 6403
 #define GL_RGB 6407
 #define GL_RGBA 6408
 #define GL_BGRA 32993
@@ -59,6 +62,7 @@ typedef uintptr_t GLsizeiptr;
 #define GL_MAP_INVALIDATE_RANGE_BIT 4
 #define GL_MAP_INVALIDATE_BUFFER_BIT 8
 #define GL_MAP_FLUSH_EXPLICIT_BIT 16
+#define GL_MAP_PERSISTENT_BIT 64
 #define GL_TEXTURE_MAG_FILTER 10240
 #define GL_TEXTURE_MIN_FILTER 10241
 #define GL_TEXTURE_WRAP_S 10242
@@ -78,6 +82,7 @@ typedef uintptr_t GLsizeiptr;
 #define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 35919
 #define GL_ACTIVE_TEXTURE 34016
 #define GL_STATIC_DRAW 35044
+#define GL_STREAM_READ 35041
 #define GL_FRAGMENT_SHADER 35632
 #define GL_VERTEX_SHADER 35633
 #define GL_FRAMEBUFFER 36160
@@ -90,21 +95,37 @@ typedef uintptr_t GLsizeiptr;
 #define GL_ARRAY_BUFFER_BINDING 34964
 #define GL_ELEMENT_ARRAY_BUFFER_BINDING 34965
 #define GL_UNIFORM_BUFFER_BINDING 35368
+#define GL_PIXEL_PACK_BUFFER 35051
+#define GL_PIXEL_PACK_BUFFER_BINDING 35053
+#define GL_PIXEL_UNPACK_BUFFER 35052
+#define GL_COPY_READ_BUFFER 36662
+#define GL_COPY_WRITE_BUFFER 36663
+#define GL_COPY_READ_BUFFER_BINDING 36662
+#define GL_COPY_WRITE_BUFFER_BINDING 36663
 #define GL_UNIFORM_OFFSET 35387
 #define GL_UNIFORM_BLOCK_BINDING 35391
 #define GL_TEXTURE0 33984
 #define GL_COLOR_ATTACHMENT0 36064
 #define GL_DEPTH_ATTACHMENT 36096
+#define GL_DEPTH_STENCIL_ATTACHMENT 33306
+#define GL_ACTIVE_UNIFORM_BLOCKS 35382
 #define GL_NEAREST 9728
+#define GL_LINEAR 9729
+#define GL_PACK_ALIGNMENT 3333
 #define GL_DEPTH_BUFFER_BIT 256
 #define GL_COLOR_BUFFER_BIT 16384
 #define GL_RGBA8 32856
 #define GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE 36048
 #define GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME 36049
 #define GL_MAX_VERTEX_ATTRIBS 34921
+#define GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS 35661
 #define GL_TEXTURE_COMPARE_MODE 34892
 #define GL_COMPILE_STATUS 35713
 #define GL_LINK_STATUS 35714
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 37143
+#define GL_SYNC_FLUSH_COMMANDS_BIT 1
+#define GL_ALREADY_SIGNALED 37146
+#define GL_CONDITION_SATISFIED 37148
 
 /*
 What's the difference between GLProcFunctions and GLLibFunctions? Well, I'm glad you asked.
@@ -137,6 +158,8 @@ struct GLProcFunctions {
     void (*AttachShader)(GLuint, GLuint);
     void (*BindAttribLocation)(GLuint, GLuint, const GLchar*);
     void (*BindBuffer)(GLenum, GLuint);
+    void (*BindBufferBase)(GLenum, GLuint, GLuint);
+    void (*BindBufferRange)(GLenum, GLuint, GLuint, GLintptr, GLsizeiptr);
     void (*BindFramebuffer)(GLenum, GLuint);
     void (*BindVertexArray)(GLuint);
     void (*BlendFuncSeparate)(GLenum, GLenum, GLenum, GLenum);
@@ -144,8 +167,10 @@ struct GLProcFunctions {
     void (*BufferData)(GLenum, GLsizeiptr, const void*, GLenum);
     void (*BufferStorage)(GLenum, GLsizeiptr, const void*, GLbitfield);
     void (*BufferSubData)(GLenum, GLintptr, GLsizeiptr, const void*);
+    GLenum (*ClientWaitSync)(GLsync, GLbitfield, GLuint64);
     void (*CompileShader)(GLuint);
     void (*CompressedTexSubImage2D)(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei, const void*);
+    void (*CopyBufferSubData)(GLenum, GLenum, GLintptr, GLintptr, GLsizeiptr);
     void (*CopyImageSubData)(GLuint, GLenum, GLint, GLint, GLint, GLint, GLuint, GLenum, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei);
     GLuint (*CreateProgram)(void);
     GLuint (*CreateShader)(GLenum);
@@ -153,17 +178,22 @@ struct GLProcFunctions {
     void (*DeleteFramebuffers)(GLsizei, const GLuint*);
     void (*DeleteProgram)(GLuint);
     void (*DeleteShader)(GLuint);
+    void (*DeleteSync)(GLsync);
     void (*DeleteVertexArrays)(GLsizei, const GLuint*);
     void (*DetachShader)(GLuint, GLuint);
     void (*DisableVertexAttribArray)(GLuint);
     void (*EnableVertexAttribArray)(GLuint);
+    GLsync (*FenceSync)(GLenum, GLbitfield);
     void (*FlushMappedBufferRange)(GLenum, GLintptr, GLsizeiptr);
+    void (*FramebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint);
     void (*FramebufferTexture)(GLenum, GLenum, GLuint, GLint);
+    void (*FramebufferTexture2D)(GLenum, GLenum, GLenum, GLuint, GLint);
     void (*FramebufferTextureLayer)(GLenum, GLenum, GLuint, GLint, GLint);
     void (*GenBuffers)(GLsizei, GLuint*);
     void (*GenFramebuffers)(GLsizei, GLuint*);
     void (*GenVertexArrays)(GLsizei, GLuint*);
     void (*GetActiveUniformBlockiv)(GLuint, GLuint, GLenum, GLint*);
+    void (*GetBufferSubData)(GLenum, GLintptr, GLsizeiptr, void*);
     void (*GetActiveUniformsiv)(GLuint, GLsizei, const GLuint*, GLenum, GLint*);
     void (*GetFramebufferAttachmentParameteriv)(GLenum, GLenum, GLenum, GLint*);
     void (*GetIntegeri_v)(GLenum, GLuint, GLint*);
@@ -198,6 +228,7 @@ struct GLProcFunctions {
     void (*Uniform2iv)(GLint, GLsizei, const GLint*);
     void (*Uniform3iv)(GLint, GLsizei, const GLint*);
     void (*Uniform4iv)(GLint, GLsizei, const GLint*);
+    void (*UniformBlockBinding)(GLuint, GLuint, GLuint);
     void (*UniformMatrix2fv)(GLint, GLsizei, GLboolean, const GLfloat*);
     void (*UniformMatrix3fv)(GLint, GLsizei, GLboolean, const GLfloat*);
     void (*UniformMatrix4fv)(GLint, GLsizei, GLboolean, const GLfloat*);
@@ -223,6 +254,7 @@ struct GLLibFunctions {
     void (*GetBooleanv)(GLenum, GLboolean*);
     GLenum (*GetError)(void);
     void (*GetIntegerv)(GLenum, GLint*);
+    void (*PixelStorei)(GLenum, GLint);
     void (*ReadPixels)(GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, void*);
     void (*TexParameteri)(GLenum, GLenum, GLint);
     void (*TexSubImage2D)(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const void*);
@@ -37,6 +37,7 @@ enum BoltIPCMessageTypeToHost {
     IPC_MSG_CAPTURENOTIFY_OSR,
     IPC_MSG_SHOWDEVTOOLS_EXTERNAL,
     IPC_MSG_SHOWDEVTOOLS_OSR,
+    IPC_MSG_PLUGINPROFILE,
 };
 
 enum BoltIPCMessageTypeToClient {
@@ -54,8 +55,20 @@ enum BoltIPCMessageTypeToClient {
     IPC_MSG_OSRCLOSEREQUEST,
     IPC_MSG_EXTERNALCAPTUREDONE,
     IPC_MSG_OSRCAPTUREDONE,
+    IPC_MSG_PLUGINPROFILEREQUEST,
 };
 
+/// Pixel formats that a screen capture can be delivered in. The contents are always in row-major order,
+/// starting with the bottom-left pixel.
+enum BoltIPCCaptureFormat {
+    IPC_CAPTURE_RGB,
+    IPC_CAPTURE_RGBA,
+    IPC_CAPTURE_RED,
+};
+
+/// Number of bytes per pixel in a screen capture of the given BoltIPCCaptureFormat
+#define IPC_CAPTURE_BYTES_PER_PIXEL(FORMAT) ((FORMAT) == IPC_CAPTURE_RGBA ? 4 : ((FORMAT) == IPC_CAPTURE_RED ? 1 : 3))
+
 /// Header for BoltIPCMessageTypeToHost::IPC_MSG_IDENTIFY
 struct BoltIPCIdentifyHeader {
     uint8_t name_length;
@@ -111,6 +124,7 @@ struct BoltIPCCaptureNotifyHeader {
     uint64_t capture_id;
     uint32_t width;
     uint32_t height;
+    uint8_t format; // BoltIPCCaptureFormat
     uint8_t needs_remap;
 };
 
@@ -120,6 +134,24 @@ struct BoltIPCShowDevtoolsHeader {
     uint64_t window_id;
 };
 
+/// Header for BoltMessageTypeToHost::IPC_MSG_PLUGINPROFILE
+struct BoltIPCPluginProfileHeader {
+    uint64_t plugin_id;
+    uint32_t entry_count;
+};
+
+/// Entry sent after IPC_MSG_PLUGINPROFILE; header.entry_count indicates the number of entries sent.
+/// There is one entry for each event type the plugin has handled at least once. Times are in nanoseconds.
+struct BoltIPCPluginProfileEntry {
+    char event_name[16]; // null-terminated, e.g. "render3d"
+    uint64_t calls;
+    uint64_t frames; // number of frames the plugin has been running for
+    uint64_t total_nanos;
+    uint64_t max_call_nanos;
+    uint64_t max_frame_nanos; // highest total time in one frame, out of the most recent frames
+    uint64_t p99_frame_nanos; // 99th percentile of total time per frame, out of the most recent frames
+};
+
 /// Header for BoltIPCMessageTypeToClient::IPC_MSG_STARTPLUGIN
 struct BoltIPCStartPluginHeader {
     uint64_t uid;
@@ -211,6 +243,18 @@ struct BoltIPCOsrCaptureDoneHeader {
     uint64_t window_id;
 };
 
+/// Header for BoltMessageTypeToClient::IPC_MSG_PLUGINPROFILEREQUEST. The client will reply with an
+/// IPC_MSG_PLUGINPROFILE message for the plugin, if it's still running.
+struct BoltIPCPluginProfileRequestHeader {
+    uint64_t plugin_id;
+};
+
+/// One contiguous block of bytes for _bolt_ipc_sendv
+struct BoltIPCBuffer {
+    const void* data;
+    size_t len;
+};
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -218,6 +262,11 @@ extern "C" {
 /// Sends the given bytes on the IPC channel and returns zero on success or non-zero on failure.
 uint8_t _bolt_ipc_send(BoltSocketType fd, const void* data, size_t len);
 
+/// Sends several blocks of bytes on the IPC channel, in order, using as few system calls as possible.
+/// If `syscalls` is not NULL, the number of system calls made is added to it. Returns zero on success
+/// or non-zero on failure.
+uint8_t _bolt_ipc_sendv(BoltSocketType fd, const struct BoltIPCBuffer* buffers, size_t count, uint64_t* syscalls);
+
 /// Receives the given number of bytes from the IPC socket, blocking until the full amount has been
 /// received. Use plugin_ipc_poll to check if this will block. Returns zero on success or non-zero
 /// on failure.
@@ -8,9 +8,13 @@
 #include <errno.h>
 #include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #define SENDFLAGS MSG_NOSIGNAL
 #endif
 
+// maximum number of buffers passed to the OS in one call to _bolt_ipc_sendv
+#define SENDV_MAX_BUFFERS 16
+
 #include <stdio.h>
 
 uint8_t _bolt_ipc_send(BoltSocketType fd, const void* data, size_t len) {
@@ -30,6 +34,61 @@ uint8_t _bolt_ipc_send(BoltSocketType fd, const void* data, size_t len) {
     return 0;
 }
 
+uint8_t _bolt_ipc_sendv(BoltSocketType fd, const struct BoltIPCBuffer* buffers, size_t count, uint64_t* syscalls) {
+    const int olderr = errno;
+    size_t index = 0;
+    size_t offset = 0; // bytes of buffers[index] that have already been sent
+    while (index < count) {
+        if (offset == buffers[index].len) {
+            index += 1;
+            offset = 0;
+            continue;
+        }
+#if defined(_WIN32)
+        WSABUF vectors[SENDV_MAX_BUFFERS];
+        DWORD vector_count = 0;
+        for (size_t i = index; i < count && vector_count < SENDV_MAX_BUFFERS; i += 1) {
+            const size_t skip = (i == index) ? offset : 0;
+            vectors[vector_count].buf = (CHAR*)buffers[i].data + skip;
+            vectors[vector_count].len = (ULONG)(buffers[i].len - skip);
+            vector_count += 1;
+        }
+        DWORD sent;
+        const int r = WSASend(fd, vectors, vector_count, &sent, 0, NULL, NULL) == 0 ? (int)sent : -1;
+#else
+        struct iovec vectors[SENDV_MAX_BUFFERS];
+        size_t vector_count = 0;
+        for (size_t i = index; i < count && vector_count < SENDV_MAX_BUFFERS; i += 1) {
+            const size_t skip = (i == index) ? offset : 0;
+            vectors[vector_count].iov_base = (uint8_t*)buffers[i].data + skip;
+            vectors[vector_count].iov_len = buffers[i].len - skip;
+            vector_count += 1;
+        }
+        const struct msghdr msg = {.msg_iov = vectors, .msg_iovlen = vector_count};
+        const ssize_t r = sendmsg(fd, &msg, SENDFLAGS);
+#endif
+        if (syscalls) *syscalls += 1;
+        if (r == -1) {
+            printf("[IPC] error: IPC sendmsg() failed, error %i\n", errno);
+            errno = olderr;
+            return 1;
+        }
+        // work out where the OS stopped, which may be part-way through a buffer
+        size_t remaining = r;
+        while (remaining > 0) {
+            const size_t left = buffers[index].len - offset;
+            if (remaining < left) {
+                offset += remaining;
+                break;
+            }
+            remaining -= left;
+            index += 1;
+            offset = 0;
+        }
+    }
+    return 0;
+}
+
 uint8_t _bolt_ipc_receive(BoltSocketType fd, void* data, size_t len) {
     const int olderr = errno;
     size_t remaining = len;
@@ -1,5 +1,6 @@
 #include "../ipc.h"
 
+#include "../atomic.h"
 #include "plugin.h"
 #include "lua.h"
 #include "plugin_api.h"
@@ -7,17 +8,21 @@
 
 #include <lauxlib.h>
 #include <lualib.h>
+#include <luajit.h>
 #include <stdlib.h>
 #include <string.h>
 
 #if defined(_WIN32)
 #include <afunix.h>
+#include <limits.h>
 #define getpid _getpid
 #define close closesocket
 LARGE_INTEGER performance_frequency;
 #else
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
@@ -39,13 +44,70 @@ static int _bolt_api_init(lua_State* state);
 
 static BoltSocketType fd = 0;
 
-static struct BoltSHM capture_shm;
-static uint64_t next_capture_time = 0;
-static uint64_t capture_id;
-static uint32_t capture_width;
-static uint32_t capture_height;
-static uint8_t capture_inited;
-#define CAPTURE_COOLDOWN_MICROS 250000
+// the socket is only ever read and written by two I/O threads, so that the render thread never has to wait
+// for the host. blocks of bytes are passed between them and the render thread through lock-free queues,
+// which only need pointers to be published with release semantics and read with acquire semantics (see
+// atomic.h).
+
+#if defined(_WIN32)
+typedef HANDLE IPCThread;
+typedef HANDLE IPCSemaphore;
+#define IPC_THREAD_FUNC(NAME) static DWORD WINAPI NAME(LPVOID arg)
+#define IPC_THREAD_RETURN 0
+#else
+typedef pthread_t IPCThread;
+typedef sem_t IPCSemaphore;
+#define IPC_THREAD_FUNC(NAME) static void* NAME(void* arg)
+#define IPC_THREAD_RETURN NULL
+#endif
+
+// a block of bytes passed between the render thread and one of the I/O threads
+struct IPCBlock {
+    struct IPCBlock* next; // set by the producer, using ATOMIC_STORE_PTR, once the next block is complete
+    size_t len;
+    size_t capacity;
+    size_t read; // how much of `data` the consumer has used
+    uint8_t data[];
+};
+
+// unbounded single-producer single-consumer queue of IPCBlocks. `head` is the block the consumer is on (or an
+// empty placeholder) and is only touched by the consumer, `tail` is only touched by the producer.
+struct IPCBlockQueue {
+    struct IPCBlock* head;
+    struct IPCBlock* tail;
+};
+
+// maximum number of blocks the writer thread will send in one go
+#define IPC_WRITER_MAX_BLOCKS 16
+
+static struct {
+    struct IPCBlockQueue outbound; // produced by the render thread, consumed by the writer thread
+    struct IPCBlockQueue inbound; // produced by the reader thread, consumed by the render thread
+    IPCSemaphore outbound_signal; // posted once for each block pushed to `outbound`, and on shutdown
+    IPCThread writer;
+    IPCThread reader;
+    uint32_t running; // only accessed by the render thread
+    uint32_t stopping; // set by the render thread to tell the writer to finish up
+    uint32_t failed; // set by the writer if the host stops accepting data
+    uint64_t syscalls; // total syscalls made by the writer, only ever increased by the writer
+} ipc_io;
+
+// messages to the host are built up here during a frame, then all handed to the writer thread together at
+// the end of it. only ever used from the render thread, same as the lua states.
+static struct {
+    struct IPCBlock* block;
+    uint64_t frame_bytes;
+    uint64_t last_syscalls;
+    struct PluginIPCStats stats;
+} ipc_queue;
+
+// percentage of frame time that captures may use, or 0 for no limit
+static uint32_t capture_budget_percent;
+// factor by which every capture interval is currently stretched, between 1 and CAPTURE_MAX_BACKOFF
+static uint32_t capture_backoff = 1;
+// time spent on captures since capture_window_start, both in microseconds
+static uint64_t capture_cost_micros = 0;
+static uint64_t capture_window_start = 0;
 
 /* 0 indicates no window */
 static uint64_t last_mouseevent_window_id = 0;
@@ -53,11 +115,21 @@ static uint64_t grabbed_window_id = 0;
 
 static char character_hash[SHA256_BLOCK_SIZE * 2] = {0};
 
+// PLUGIN_EVENT_BITs of event types which at least one running plugin has a handler for
+static uint32_t subscribed_events = 0;
+
+// per-plugin time budget for event handlers in each frame, or 0 for no budget
+static uint64_t frame_budget_nanos;
+// number of Lua VM instructions between each time the budget hook checks the clock
+#define BUDGET_HOOK_INTERVAL 1000
+
 // called mainly from the input thread - see comment in header for thread-safety observations
 uint64_t _bolt_plugin_get_last_mouseevent_windowid() { return last_mouseevent_window_id; }
 
 static void _bolt_plugin_ipc_init(BoltSocketType*);
 static void _bolt_plugin_ipc_close(BoltSocketType);
+static void ipc_io_start();
+static void ipc_io_stop();
 
 static void _bolt_plugin_window_onreposition(struct EmbeddedWindow*, const struct RepositionEvent*);
 static void _bolt_plugin_window_onmousemotion(struct EmbeddedWindow*, const struct MouseMotionEvent*);
@@ -102,14 +174,170 @@ uint64_t _bolt_plugin_new_windowid() {
     return ret;
 }
 
-BoltSocketType _bolt_plugin_fd() {
-    return fd;
+static struct IPCBlock* ipc_block_new(size_t capacity) {
+    struct IPCBlock* block = malloc(sizeof(struct IPCBlock) + capacity);
+    block->next = NULL;
+    block->len = 0;
+    block->capacity = capacity;
+    block->read = 0;
+    return block;
+}
+
+static void ipc_block_queue_init(struct IPCBlockQueue* queue) {
+    queue->head = ipc_block_new(0);
+    queue->tail = queue->head;
+}
+
+// called by the producer. the block must not be touched by the producer afterwards.
+static void ipc_block_queue_push(struct IPCBlockQueue* queue, struct IPCBlock* block) {
+    block->next = NULL;
+    ATOMIC_STORE_PTR(&queue->tail->next, block);
+    queue->tail = block;
+}
+
+// called by the consumer. returns the next block, or NULL if there isn't one yet. the returned block stays
+// valid until the next call, which frees it.
+static struct IPCBlock* ipc_block_queue_pop(struct IPCBlockQueue* queue) {
+    struct IPCBlock* next = ATOMIC_LOAD_PTR(&queue->head->next);
+    if (!next) return NULL;
+    free(queue->head);
+    queue->head = next;
+    return next;
+}
+
+// frees every block in the queue. neither thread may be using it any more.
+static void ipc_block_queue_destroy(struct IPCBlockQueue* queue) {
+    struct IPCBlock* block = queue->head;
+    while (block) {
+        struct IPCBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    queue->head = NULL;
+    queue->tail = NULL;
+}
+
+static void ipc_semaphore_post(IPCSemaphore* semaphore) {
+#if defined(_WIN32)
+    ReleaseSemaphore(*semaphore, 1, NULL);
+#else
+    sem_post(semaphore);
+#endif
+}
+
+static void ipc_semaphore_wait(IPCSemaphore* semaphore) {
+#if defined(_WIN32)
+    WaitForSingleObject(*semaphore, INFINITE);
+#else
+    while (sem_wait(semaphore) == -1 && errno == EINTR);
+#endif
+}
+
+// sends everything the render thread has queued, a few blocks per syscall, until told to stop
+IPC_THREAD_FUNC(ipc_writer_thread) {
+    struct BoltIPCBuffer buffers[IPC_WRITER_MAX_BLOCKS];
+    uint8_t stopping = false;
+    while (!stopping) {
+        ipc_semaphore_wait(&ipc_io.outbound_signal);
+        // checked before sending, so that anything queued before the stop request still gets sent
+        stopping = ATOMIC_LOAD_U32(&ipc_io.stopping);
+        while (true) {
+            struct IPCBlock* last = ipc_io.outbound.head;
+            struct IPCBlock* next;
+            size_t count = 0;
+            while (count < IPC_WRITER_MAX_BLOCKS && (next = ATOMIC_LOAD_PTR(&last->next))) {
+                buffers[count].data = next->data;
+                buffers[count].len = next->len;
+                count += 1;
+                last = next;
+            }
+            if (!count) break;
+            if (!ATOMIC_LOAD_U32(&ipc_io.failed)) {
+                uint64_t syscalls = 0;
+                if (_bolt_ipc_sendv(fd, buffers, count, &syscalls)) ATOMIC_STORE_U32(&ipc_io.failed, true);
+                ATOMIC_ADD_U64(&ipc_io.syscalls, syscalls);
+            }
+            while (ipc_io.outbound.head != last) {
+                struct IPCBlock* sent = ipc_io.outbound.head;
+                ipc_io.outbound.head = sent->next;
+                free(sent);
+            }
+        }
+    }
+    return IPC_THREAD_RETURN;
+}
+
+// hands everything in the outgoing IPC queue to the writer thread
+static void ipc_queue_flush() {
+    struct IPCBlock* block = ipc_queue.block;
+    if (!block || !block->len) return;
+    ipc_queue.block = NULL;
+    if (!ipc_io.running) {
+        free(block);
+        return;
+    }
+    ipc_queue.frame_bytes += block->len;
+    ipc_block_queue_push(&ipc_io.outbound, block);
+    ipc_semaphore_post(&ipc_io.outbound_signal);
+}
+
+uint8_t _bolt_plugin_ipc_send(const void* data, size_t len) {
+    if (ATOMIC_LOAD_U32(&ipc_io.failed)) return 1;
+    struct IPCBlock* block = ipc_queue.block;
+    if (block && block->len + len > IPC_QUEUE_MAX_BYTES) {
+        ipc_queue_flush();
+        block = NULL;
+    }
+    if (!block || block->len + len > block->capacity) {
+        size_t capacity = block ? block->capacity : 4096;
+        while (capacity < (block ? block->len : 0) + len) capacity *= 2;
+        block = realloc(block, sizeof(struct IPCBlock) + capacity);
+        if (!ipc_queue.block) {
+            block->next = NULL;
+            block->len = 0;
+            block->read = 0;
+        }
+        block->capacity = capacity;
+        ipc_queue.block = block;
+    }
+    memcpy(block->data + block->len, data, len);
+    block->len += len;
+    return 0;
+}
+
+// hands the outgoing IPC queue to the writer thread and rolls over the per-frame counters. called once at the
+// end of each frame.
+static void ipc_queue_end_frame() {
+    ipc_queue_flush();
+    const uint64_t syscalls = ATOMIC_LOAD_U64(&ipc_io.syscalls);
+    const uint64_t frame_syscalls = syscalls - ipc_queue.last_syscalls;
+    ipc_queue.last_syscalls = syscalls;
+    ipc_queue.stats.frames += 1;
+    ipc_queue.stats.syscalls += frame_syscalls;
+    ipc_queue.stats.bytes += ipc_queue.frame_bytes;
+    ipc_queue.stats.last_frame_syscalls = frame_syscalls;
+    ipc_queue.stats.last_frame_bytes = ipc_queue.frame_bytes;
+    if (frame_syscalls > ipc_queue.stats.max_frame_syscalls) ipc_queue.stats.max_frame_syscalls = frame_syscalls;
+    if (ipc_queue.frame_bytes > ipc_queue.stats.max_frame_bytes) ipc_queue.stats.max_frame_bytes = ipc_queue.frame_bytes;
+    ipc_queue.frame_bytes = 0;
+}
+
+void _bolt_plugin_ipc_stats(struct PluginIPCStats* out) {
+    *out = ipc_queue.stats;
 }
 
 void _bolt_plugin_free(struct Plugin* plugin) {
+    size_t iter = 0;
+    void* item;
+    while (hashmap_iter(plugin->external_browsers, &iter, &item)) {
+        struct ExternalBrowser* browser = *(struct ExternalBrowser**)item;
+        _bolt_plugin_capture_release(&browser->capture);
+    }
     hashmap_free(plugin->external_browsers);
     free(plugin->path);
     free(plugin->config_path);
+    free(plugin->profiles);
+    free(plugin->filters);
     lua_close(plugin->state);
     free(plugin);
 }
@@ -149,40 +377,265 @@ uint64_t _bolt_plugin_itemicon_hash(const void* item, uint64_t seed0, uint64_t s
 
 static struct hashmap* plugins;
 
-#define DEFINE_CALLBACK(APINAME, STRUCTNAME) \
+static const char* const event_names[PLUGIN_EVENT_COUNT] = {
+    "swapbuffers",
+    "render2d",
+    "render3d",
+    "renderparticles",
+    "renderbillboard",
+    "rendericon",
+    "renderbigicon",
+    "minimapterrain",
+    "minimaprender2d",
+    "renderminimap",
+    "rendergameview",
+    "mousemotion",
+    "mousebutton",
+    "mousebuttonup",
+    "scroll",
+};
+
+static int compare_texture_id(const void* a, const void* b) {
+    const size_t x = *(const size_t*)a;
+    const size_t y = *(const size_t*)b;
+    return (x > y) - (x < y);
+}
+
+// recalculates subscribed_events from every running plugin. should be called whenever a plugin sets or
+// removes an event handler, or stops running.
+static void update_subscribed_events() {
+    uint32_t events = 0;
+    size_t iter = 0;
+    void* item;
+    while (hashmap_iter(plugins, &iter, &item)) {
+        const struct Plugin* plugin = *(struct Plugin* const*)item;
+        if (!plugin->is_deleted) events |= plugin->subscribed_events;
+    }
+    subscribed_events = events;
+}
+
+uint32_t _bolt_plugin_subscribed_events() {
+    return subscribed_events;
+}
+
+void _bolt_plugin_set_subscribed(struct Plugin* plugin, enum PluginEventType type, uint8_t subscribed) {
+    if (subscribed) plugin->subscribed_events |= PLUGIN_EVENT_BIT(type);
+    else plugin->subscribed_events &= ~PLUGIN_EVENT_BIT(type);
+    update_subscribed_events();
+}
+
+void _bolt_plugin_set_filter(struct Plugin* plugin, enum PluginEventType type, const struct PluginEventFilter* filter) {
+    struct PluginEventFilter* dest = &plugin->filters[type];
+    *dest = *filter;
+    qsort(dest->texture_ids, dest->texture_id_count, sizeof(*dest->texture_ids), compare_texture_id);
+}
+
+const char* _bolt_plugin_event_name(enum PluginEventType type) {
+    return event_names[type];
+}
+
+// adds one handler call, which took `nanos` nanoseconds, to the plugin's profile for that event type
+static void profile_record(struct Plugin* plugin, enum PluginEventType type, uint64_t nanos) {
+    struct PluginEventProfile* profile = &plugin->profiles[type];
+    plugin->frame_used_nanos += nanos;
+    profile->calls += 1;
+    profile->total_nanos += nanos;
+    profile->frame_nanos += nanos;
+    if (nanos > profile->max_call_nanos) profile->max_call_nanos = nanos;
+}
+
+// moves every plugin's per-frame timings into their frame histories, resets their frame budgets, and lets
+// budget strikes expire. called once at the end of every frame.
+static void accounting_end_frame() {
+    size_t iter = 0;
+    void* item;
+    while (hashmap_iter(plugins, &iter, &item)) {
+        struct Plugin* plugin = *(struct Plugin* const*)item;
+        if (plugin->is_deleted) continue;
+        plugin->frames += 1;
+        plugin->frame_used_nanos = 0;
+        if (plugin->budget_strikes && plugin->frames - plugin->last_strike_frame >= PLUGIN_BUDGET_DECAY_FRAMES) {
+            plugin->budget_strikes -= 1;
+            plugin->last_strike_frame = plugin->frames;
+        }
+        for (size_t i = 0; i < PLUGIN_EVENT_COUNT; i += 1) {
+            struct PluginEventProfile* profile = &plugin->profiles[i];
+            if (!profile->calls) continue;
+            profile->frame_history[profile->frame_history_next] = profile->frame_nanos > UINT32_MAX ? UINT32_MAX : (uint32_t)profile->frame_nanos;
+            profile->frame_history_next = (profile->frame_history_next + 1) % PLUGIN_PROFILE_FRAMES;
+            if (profile->frame_history_count < PLUGIN_PROFILE_FRAMES) profile->frame_history_count += 1;
+            profile->frame_nanos = 0;
+        }
+    }
+}
+
+// count hook for plugins' Lua states, which aborts the running event handler once it's past its deadline.
+// note that LuaJIT doesn't call hooks from JIT-compiled code, so a compiled loop can still overrun until it
+// calls back into the interpreter; handle_budget catches that overrun after the fact and turns the JIT off
+// for the offending plugin, so the hook will fire reliably from then on.
+static void budget_hook(lua_State* state, lua_Debug* ar) {
+    lua_getfield(state, LUA_REGISTRYINDEX, PLUGIN_REGISTRYNAME);
+    struct Plugin* plugin = lua_touserdata(state, -1);
+    lua_pop(state, 1);
+    if (!plugin || !plugin->deadline_nanos) return;
+    uint64_t now = 0;
+    _bolt_monotonic_nanoseconds(&now);
+    if (now < plugin->deadline_nanos) return;
+    plugin->budget_exceeded = true;
+    luaL_error(state, "event handler ran out of time (frame budget is %d ms)", (int)(frame_budget_nanos / 1000000));
+}
+
+// returns the time at which a handler starting at `start_nanos` will run out of budget, or 0 if there's no budget
+static uint64_t budget_deadline(const struct Plugin* plugin, uint64_t start_nanos) {
+    if (!frame_budget_nanos) return 0;
+    return start_nanos + (frame_budget_nanos - plugin->frame_used_nanos);
+}
+
+// called after each event handler returns. if the plugin has used up its budget for this frame, it gets a strike
+// and its handlers are skipped for a number of frames, which doubles with each strike. returns true if the plugin
+// has run out of strikes and should be stopped.
+static uint8_t handle_budget(struct Plugin* plugin, const char* handler) {
+    const uint8_t aborted = plugin->budget_exceeded;
+    plugin->budget_exceeded = false;
+    if (!frame_budget_nanos || plugin->frame_used_nanos < frame_budget_nanos) return false;
+    plugin->budget_strikes += 1;
+    plugin->last_strike_frame = plugin->frames;
+    printf(
+        "plugin %llu exceeded its frame time budget in %s%s (strike %u of %u)\n",
+        (unsigned long long)plugin->id, handler, aborted ? ", handler was aborted" : "", plugin->budget_strikes, PLUGIN_BUDGET_STRIKES
+    );
+    if (plugin->budget_strikes >= PLUGIN_BUDGET_STRIKES) return true;
+    // compiled traces never call the count hook, so run this plugin in the interpreter from now on
+    luaJIT_setmode(plugin->state, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+    plugin->skip_until_frame = plugin->frames + (1ULL << plugin->budget_strikes);
+    return false;
+}
+
+static int compare_u32(const void* a, const void* b) {
+    const uint32_t x = *(const uint32_t*)a;
+    const uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+uint8_t _bolt_plugin_event_stats(const struct Plugin* plugin, enum PluginEventType type, struct PluginEventStats* out) {
+    const struct PluginEventProfile* profile = &plugin->profiles[type];
+    if (!profile->calls) return false;
+    out->calls = profile->calls;
+    out->frames = plugin->frames;
+    out->total_nanos = profile->total_nanos;
+    out->max_call_nanos = profile->max_call_nanos;
+    out->max_frame_nanos = 0;
+    out->p99_frame_nanos = 0;
+    const uint32_t count = profile->frame_history_count;
+    if (count) {
+        uint32_t sorted[PLUGIN_PROFILE_FRAMES];
+        memcpy(sorted, profile->frame_history, count * sizeof(*sorted));
+        qsort(sorted, count, sizeof(*sorted), compare_u32);
+        out->max_frame_nanos = sorted[count - 1];
+        out->p99_frame_nanos = sorted[((count * 99) + 99) / 100 - 1];
+    }
+    return true;
+}
+
+// checks the parts of a filter that apply to all filterable events
+static uint8_t filter_common(const struct PluginEventFilter* filter, uint32_t vertex_count, const struct TextureFunctions* texture_functions) {
+    if (vertex_count < filter->min_vertices || vertex_count > filter->max_vertices) return false;
+    if (filter->texture_id_count) {
+        const size_t id = texture_functions->id(texture_functions->userdata);
+        if (!bsearch(&id, filter->texture_ids, filter->texture_id_count, sizeof(*filter->texture_ids), compare_texture_id)) return false;
+    }
+    return true;
+}
+
+static uint8_t filter_none(const struct PluginEventFilter* filter, const void* e) {
+    return true;
+}
+
+static uint8_t filter_batch2d(const struct PluginEventFilter* filter, const struct RenderBatch2D* e) {
+    if (!filter_common(filter, e->index_count, &e->texture_functions)) return false;
+    if (!filter->has_atlas) return true;
+    for (size_t i = 0; i < e->index_count; i += e->vertices_per_icon) {
+        int32_t xywh[4];
+        uint8_t wrapx, wrapy;
+        e->vertex_functions.atlas_details(i, e->vertex_functions.userdata, xywh, &wrapx, &wrapy);
+        if (!memcmp(xywh, filter->atlas_xywh, sizeof(xywh))) return true;
+    }
+    return false;
+}
+
+// defines a filter function for an event struct that has vertex_count and texture_functions fields
+#define DEFINE_FILTER(NAME, STRUCTNAME) \
+static uint8_t filter_##NAME(const struct PluginEventFilter* filter, const struct STRUCTNAME* e) { \
+    return filter_common(filter, e->vertex_count, &e->texture_functions); \
+}
+DEFINE_FILTER(render3d, Render3D)
+DEFINE_FILTER(particles, RenderParticles)
+DEFINE_FILTER(billboard, RenderBillboard)
+
+// each plugin has one event object per event type, which is created on first use and then refilled for
+// every event of that type, to avoid allocating userdata per plugin for every event. once the callback has
+// returned, the object's metatable is swapped for one that raises an error on any use. a plugin that
+// keeps a reference gets the live metatable back along with the next event of that type, so the reference
+// is valid again for the duration of that callback - this is documented in eventobjectwarning.
+// FILTER is a function which checks an event against a PluginEventFilter, or filter_none if this event
+// type can't be filtered. it's only called if the plugin has enabled a filter for this event type.
+#define DEFINE_CALLBACK(APINAME, STRUCTNAME, EVTYPE, FILTER) \
 void _bolt_plugin_handle_##APINAME(const struct STRUCTNAME* e) { \
     if (!overlay_inited) return; \
     size_t iter = 0; \
     void* item; \
     while (hashmap_iter(plugins, &iter, &item)) { \
         struct Plugin* plugin = *(struct Plugin* const*)item; \
-        if (plugin->is_deleted) continue; \
-        void* newud = lua_newuserdata(plugin->state, sizeof(struct STRUCTNAME)); /*stack: userdata*/ \
-        memcpy(newud, e, sizeof(struct STRUCTNAME)); \
-        lua_getfield(plugin->state, LUA_REGISTRYINDEX, #APINAME "meta"); /*stack: userdata, metatable*/ \
-        lua_setmetatable(plugin->state, -2); /*stack: userdata*/ \
-        lua_pushliteral(plugin->state, #APINAME "cb"); /*stack: userdata, enumname*/ \
-        lua_gettable(plugin->state, LUA_REGISTRYINDEX); /*stack: userdata, callback*/ \
+        if (plugin->is_deleted || plugin->frames < plugin->skip_until_frame) continue; \
+        const struct PluginEventFilter* filter = &plugin->filters[PLUGIN_EVENT_##EVTYPE]; \
+        if (filter->enabled && !FILTER(filter, e)) continue; \
+        lua_pushliteral(plugin->state, #APINAME "cb"); /*stack: enumname*/ \
+        lua_gettable(plugin->state, LUA_REGISTRYINDEX); /*stack: callback*/ \
         if (!lua_isfunction(plugin->state, -1)) { \
-            lua_pop(plugin->state, 2); \
+            lua_pop(plugin->state, 1); \
             continue; \
         } \
-        lua_pushvalue(plugin->state, -2); /*stack: userdata, callback, userdata*/ \
-        if (lua_pcall(plugin->state, 1, 0, 0)) { /*stack: userdata, ?error*/ \
+        lua_getfield(plugin->state, LUA_REGISTRYINDEX, #APINAME "ud"); /*stack: callback, userdata or nil*/ \
+        if (lua_isnil(plugin->state, -1)) { \
+            lua_pop(plugin->state, 1); /*stack: callback*/ \
+            lua_newuserdata(plugin->state, sizeof(struct STRUCTNAME)); /*stack: callback, userdata*/ \
+            lua_pushvalue(plugin->state, -1); /*stack: callback, userdata, userdata*/ \
+            lua_setfield(plugin->state, LUA_REGISTRYINDEX, #APINAME "ud"); /*stack: callback, userdata*/ \
+        } \
+        memcpy(lua_touserdata(plugin->state, -1), e, sizeof(struct STRUCTNAME)); \
+        lua_getfield(plugin->state, LUA_REGISTRYINDEX, #APINAME "meta"); /*stack: callback, userdata, metatable*/ \
+        lua_setmetatable(plugin->state, -2); /*stack: callback, userdata*/ \
+        lua_pushvalue(plugin->state, -1); /*stack: callback, userdata, userdata*/ \
+        lua_insert(plugin->state, -3); /*stack: userdata, callback, userdata*/ \
+        uint64_t start_nanos = 0, end_nanos = 0; \
+        _bolt_monotonic_nanoseconds(&start_nanos); \
+        plugin->deadline_nanos = budget_deadline(plugin, start_nanos); \
+        const int pcall_error = lua_pcall(plugin->state, 1, 0, 0); \
+        plugin->deadline_nanos = 0; \
+        _bolt_monotonic_nanoseconds(&end_nanos); \
+        profile_record(plugin, PLUGIN_EVENT_##EVTYPE, end_nanos - start_nanos); \
+        if (pcall_error && !plugin->budget_exceeded) { /*stack: userdata, error*/ \
             const char* e = lua_tolstring(plugin->state, -1, 0); \
             printf("plugin callback on" #APINAME " error: %s\n", e); \
             lua_pop(plugin->state, 2); /*stack: (empty)*/ \
             _bolt_plugin_stop(plugin->id); \
             _bolt_plugin_notify_stopped(plugin->id); \
             break; \
-        } else { \
-            lua_pop(plugin->state, 1); /*stack: (empty)*/ \
+        } \
+        if (pcall_error) lua_pop(plugin->state, 1); /*stack: userdata*/ \
+        lua_getfield(plugin->state, LUA_REGISTRYINDEX, EXPIREDEVENT_REGISTRYNAME); /*stack: userdata, metatable*/ \
+        lua_setmetatable(plugin->state, -2); /*stack: userdata*/ \
+        lua_pop(plugin->state, 1); /*stack: (empty)*/ \
+        if (handle_budget(plugin, "on" #APINAME)) { \
+            _bolt_plugin_stop(plugin->id); \
+            _bolt_plugin_notify_stopped(plugin->id); \
+            break; \
         } \
     } \
 } \
 
 // same as DEFINE_CALLBACK except _bolt_plugin_handle_... will be defined as static
-#define DEFINE_CALLBACK_STATIC(APINAME, STRUCTNAME) static DEFINE_CALLBACK(APINAME, STRUCTNAME)
+#define DEFINE_CALLBACK_STATIC(APINAME, STRUCTNAME, EVTYPE, FILTER) static DEFINE_CALLBACK(APINAME, STRUCTNAME, EVTYPE, FILTER)
 
 #define DEFINE_WINDOWEVENT(APINAME, REGNAME, EVNAME) \
 void _bolt_plugin_window_on##APINAME(struct EmbeddedWindow* window, const struct EVNAME* event) { \
@@ -191,9 +644,9 @@ void _bolt_plugin_window_on##APINAME(struct EmbeddedWindow* window, const struct
     if (window->is_browser) { \
         const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_EV##REGNAME; \
         const struct BoltIPCEvHeader header = { .plugin_id = window->plugin_id, .window_id = window->id }; \
-        _bolt_ipc_send(fd, &msg_type, sizeof(msg_type)); \
-        _bolt_ipc_send(fd, &header, sizeof(header)); \
-        _bolt_ipc_send(fd, event, sizeof(struct EVNAME)); \
+        _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type)); \
+        _bolt_plugin_ipc_send(&header, sizeof(header)); \
+        _bolt_plugin_ipc_send(event, sizeof(struct EVNAME)); \
     } \
     lua_getfield(state, LUA_REGISTRYINDEX, window->is_browser ? BROWSERS_REGISTRYNAME : WINDOWS_REGISTRYNAME); /*stack: window table*/ \
     lua_pushinteger(state, window->id); /*stack: window table, window id*/ \
@@ -221,6 +674,11 @@ void _bolt_plugin_window_on##APINAME(struct EmbeddedWindow* window, const struct
     } \
 }
 
+static int expired_event_index(lua_State* state) {
+    lua_pushliteral(state, "event object was used after its event handler returned");
+    return lua_error(state);
+}
+
 static void delete_windows_by_uid(uint64_t uid) {
     size_t iter = 0;
     void* item;
@@ -239,7 +697,6 @@ void _bolt_plugin_on_startup() {
     overlay_width = 0;
     overlay_height = 0;
     overlay_inited = false;
-    capture_inited = false;
 #if defined(_WIN32)
     QueryPerformanceFrequency(&performance_frequency);
 #endif
@@ -256,15 +713,17 @@ char u4_to_char(uint8_t u4) {
 
 void _bolt_plugin_init(const struct PluginManagedFunctions* functions) {
     _bolt_plugin_ipc_init(&fd);
+    ipc_io_start();
 
     const char* display_name = getenv("JX_DISPLAY_NAME");
     if (display_name && *display_name) {
         size_t name_len = strlen(display_name);
         const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_IDENTIFY;
         const struct BoltIPCIdentifyHeader header = { .name_length = name_len };
-        _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-        _bolt_ipc_send(fd, &header, sizeof(header));
-        _bolt_ipc_send(fd, display_name, name_len);
+        _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+        _bolt_plugin_ipc_send(&header, sizeof(header));
+        _bolt_plugin_ipc_send(display_name, name_len);
+        ipc_queue_flush();
     }
 
     const char* character_id = getenv("JX_CHARACTER_ID");
@@ -278,6 +737,14 @@ void _bolt_plugin_init(const struct PluginManagedFunctions* functions) {
         character_hash[(i * 2) + 1] = u4_to_char(hash[i] & 0b1111);
     }
 
+    const char* budget = getenv("BOLT_PLUGIN_FRAME_BUDGET_MS");
+    frame_budget_nanos = (uint64_t)((budget && *budget) ? strtoul(budget, NULL, 10) : PLUGIN_DEFAULT_FRAME_BUDGET_MS) * 1000000;
+    const char* capture_budget = getenv("BOLT_CAPTURE_BUDGET_PERCENT");
+    capture_budget_percent = (capture_budget && *capture_budget) ? strtoul(capture_budget, NULL, 10) : CAPTURE_DEFAULT_BUDGET_PERCENT;
+    capture_backoff = 1;
+    capture_cost_micros = 0;
+    capture_window_start = 0;
+
     managed_functions = *functions;
     _bolt_rwlock_lock_write(&windows.lock);
     next_window_id = 1;
@@ -311,6 +778,25 @@ uint8_t _bolt_monotonic_microseconds(uint64_t* microseconds) {
 #endif
 }
 
+uint8_t _bolt_monotonic_nanoseconds(uint64_t* nanoseconds) {
+#if defined(_WIN32)
+    LARGE_INTEGER ticks;
+    if (QueryPerformanceCounter(&ticks)) {
+        // split into seconds and remainder, since multiplying the whole tick count by 10^9 could overflow
+        const uint64_t seconds = ticks.QuadPart / performance_frequency.QuadPart;
+        const uint64_t remainder = ticks.QuadPart % performance_frequency.QuadPart;
+        *nanoseconds = (seconds * 1000000000) + ((remainder * 1000000000) / performance_frequency.QuadPart);
+        return true;
+    }
+    return false;
+#else
+    struct timespec s;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &s);
+    *nanoseconds = ((uint64_t)s.tv_sec * 1000000000) + s.tv_nsec;
+    return true;
+#endif
+}
+
 static bool embedded_window_meta_eq(const struct EmbeddedWindowMetadata* a, const struct EmbeddedWindowMetadata* b) {
     return a->x == b->x && a->y == b->y && a->width == b->width && a->height == b->height;
 }
@@ -383,7 +869,7 @@ static void _bolt_window_calc_repos_target(struct EmbeddedWindow* window, const
     }
 }
 
-static void _bolt_process_plugins(uint8_t* need_capture, uint8_t* capture_ready) {
+static void _bolt_process_plugins() {
     size_t iter = 0;
     void* item;
     while (hashmap_iter(plugins, &iter, &item)) {
@@ -394,16 +880,6 @@ static void _bolt_process_plugins(uint8_t* need_capture, uint8_t* capture_ready)
             iter = 0;
             continue;
         }
-        if (plugin->ext_browser_capture_count == 0) continue;
-        void* item2;
-        size_t iter2 = 0;
-        while (hashmap_iter(plugin->external_browsers, &iter2, &item2)) {
-            struct ExternalBrowser* browser = *(struct ExternalBrowser**)item2;
-            if (browser->do_capture) {
-                *need_capture = true;
-                if (!browser->capture_ready) *capture_ready = false;
-            }
-        }
     }
 }
 
@@ -434,7 +910,7 @@ static void snap_window(struct EmbeddedWindowMetadata* metadata, uint32_t window
     }
 }
 
-static void _bolt_process_embedded_windows(uint32_t window_width, uint32_t window_height, uint8_t* need_capture, uint8_t* capture_ready) {
+static void _bolt_process_embedded_windows(uint32_t window_width, uint32_t window_height) {
     _bolt_rwlock_lock_write(&windows.input_lock);
     struct WindowPendingInput inputs = windows.input;
     memset(&windows.input, 0, sizeof(windows.input));
@@ -488,11 +964,6 @@ static void _bolt_process_embedded_windows(uint32_t window_width, uint32_t windo
             continue;
         }
 
-        if (window->do_capture) {
-            *need_capture = true;
-            if (!window->capture_ready) *capture_ready = false;
-        }
-
         _bolt_rwlock_lock_write(&window->lock);
         bool did_move = false;
         bool did_resize = false;
@@ -627,8 +1098,9 @@ static void _bolt_process_embedded_windows(uint32_t window_width, uint32_t windo
             struct EmbeddedWindow* window = *(struct EmbeddedWindow**)item;
             if (window->is_deleted) {
                 if (window->is_browser) {
-                    // destroy shm object
+                    // destroy shm objects
                     _bolt_plugin_shm_close(&window->browser_shm);
+                    _bolt_plugin_capture_release(&window->capture);
                 }
 
                 // destroy the plugin registry entry
@@ -651,50 +1123,141 @@ static void _bolt_process_embedded_windows(uint32_t window_width, uint32_t windo
     }
 }
 
-// does a screen capture, then notifies all the browsers. don't call if any browser isn't ready yet.
-static void _bolt_process_captures(uint32_t window_width, uint32_t window_height) {
-    const size_t capture_bytes = window_width * window_height * 3;
-    uint8_t need_remap = false;
-    if (!capture_inited) {
-        capture_id = _bolt_plugin_new_windowid();
-        _bolt_plugin_shm_open_outbound(&capture_shm, capture_bytes, "sc", capture_id);
-        capture_inited = true;
-        capture_width = window_width;
-        capture_height = window_height;
-        need_remap = true;
-    } else if (capture_width != window_width || capture_height != window_height) {
+void _bolt_plugin_capture_init(struct CaptureTarget* target) {
+    memset(target, 0, sizeof(*target));
+    target->request.scale = 1.0;
+    target->request.format = IPC_CAPTURE_RGB;
+    target->request.interval_micros = CAPTURE_DEFAULT_INTERVAL_MICROS;
+}
+
+void _bolt_plugin_capture_release(struct CaptureTarget* target) {
+    if (target->userdata) {
+        managed_functions.capture_screen_destroy(target->userdata);
+        target->userdata = NULL;
+    }
+    if (target->shm_inited) {
+        _bolt_plugin_shm_close(&target->shm);
+        target->shm_inited = false;
+    }
+}
+
+// works out which pixels a capture request covers in a window of the given size, and how big the image
+// will be after scaling. returns false if the region is entirely outside the window.
+static uint8_t capture_resolve_region(const struct CaptureRequest* request, uint32_t window_width, uint32_t window_height, int16_t* x, int16_t* y, uint32_t* width, uint32_t* height, uint32_t* out_width, uint32_t* out_height) {
+    const int32_t x1 = request->x < 0 ? 0 : request->x;
+    const int32_t y1 = request->y < 0 ? 0 : request->y;
+    int32_t x2 = request->width ? request->x + request->width : (int32_t)window_width;
+    int32_t y2 = request->height ? request->y + request->height : (int32_t)window_height;
+    if (x2 > (int32_t)window_width) x2 = window_width;
+    if (y2 > (int32_t)window_height) y2 = window_height;
+    if (x2 <= x1 || y2 <= y1) return false;
+    *x = x1;
+    *y = y1;
+    *width = x2 - x1;
+    *height = y2 - y1;
+    *out_width = (uint32_t)(*width * request->scale + 0.5);
+    *out_height = (uint32_t)(*height * request->scale + 0.5);
+    if (*out_width == 0) *out_width = 1;
+    if (*out_height == 0) *out_height = 1;
+    return true;
+}
+
+// captures are started on one frame and delivered on a later one, once the GPU has finished with them.
+// this delivers a finished capture if there is one, i.e. copies it into the target's SHM and notifies the
+// browser, then starts another one if its interval has passed. `capture_ready` and `capture_id` are the
+// browser's fields of the same names. nothing happens while the browser is still busy with a capture.
+//
+// a target that's at least half way through its interval will also start a capture early if another
+// browser has already asked for the exact same one this frame, since sharing it costs next to nothing.
+static void process_capture_target(struct CaptureTarget* target, enum BoltIPCMessageTypeToHost msg_type, uint64_t plugin_id, uint64_t window_id, uint8_t* capture_ready, uint64_t* capture_id, uint32_t window_width, uint32_t window_height, uint64_t micros) {
+    if (!*capture_ready) return;
+    if (!target->userdata) target->userdata = managed_functions.capture_screen_init();
+
+    uint32_t width, height;
+    uint8_t format;
+    if (managed_functions.capture_screen_poll(target->userdata, &width, &height, &format)) {
+        const size_t capture_bytes = (size_t)width * height * IPC_CAPTURE_BYTES_PER_PIXEL(format);
+        uint8_t need_remap = false;
+        if (!target->shm_inited) {
+            target->shm_id = _bolt_plugin_new_windowid();
+            _bolt_plugin_shm_open_outbound(&target->shm, capture_bytes, "sc", target->shm_id);
+            target->shm_inited = true;
+            target->shm_size = capture_bytes;
+            need_remap = true;
+        } else if (target->shm_size != capture_bytes) {
 #if defined(_WIN32)
-        capture_id = _bolt_plugin_new_windowid();
+            target->shm_id = _bolt_plugin_new_windowid();
 #endif
-        _bolt_plugin_shm_resize(&capture_shm, capture_bytes, capture_id);
-        capture_width = window_width;
-        capture_height = window_height;
-        need_remap = true;
+            _bolt_plugin_shm_resize(&target->shm, capture_bytes, target->shm_id);
+            target->shm_size = capture_bytes;
+            need_remap = true;
+        }
+        managed_functions.capture_screen_read(target->userdata, target->shm.file);
+
+        const struct BoltIPCCaptureNotifyHeader header = {
+            .plugin_id = plugin_id,
+            .window_id = window_id,
+            .pid = getpid(),
+            .capture_id = target->shm_id,
+            .width = width,
+            .height = height,
+            .format = format,
+            .needs_remap = need_remap || (target->shm_id != *capture_id),
+        };
+        _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+        _bolt_plugin_ipc_send(&header, sizeof(header));
+        *capture_ready = false;
+        *capture_id = target->shm_id;
     }
-    managed_functions.read_screen_pixels(0, 0, window_width, window_height, capture_shm.file);
-    
+
+    uint64_t interval = target->request.interval_micros;
+    if (capture_backoff > 1) {
+        if (interval < CAPTURE_BACKOFF_MIN_INTERVAL_MICROS) interval = CAPTURE_BACKOFF_MIN_INTERVAL_MICROS;
+        interval *= capture_backoff;
+    }
+    const uint8_t due = micros >= target->next_capture_time;
+    if (!due && micros + (interval / 2) < target->next_capture_time) return;
+    int16_t x, y;
+    uint32_t out_width, out_height;
+    uint8_t started = false;
+    if (capture_resolve_region(&target->request, window_width, window_height, &x, &y, &width, &height, &out_width, &out_height)) {
+        started = managed_functions.capture_screen_begin(target->userdata, x, y, width, height, out_width, out_height, target->request.format, !due);
+    }
+    if (due || started) target->next_capture_time = micros + interval;
+}
+
+// compares the time spent on captures against the budget once per CAPTURE_BUDGET_WINDOW_MICROS, and
+// stretches or relaxes every browser's capture interval accordingly
+static void update_capture_backoff(uint64_t start_micros, uint64_t end_micros) {
+    if (!capture_budget_percent) return;
+    capture_cost_micros += end_micros - start_micros;
+    if (!capture_window_start) capture_window_start = start_micros;
+    const uint64_t elapsed = end_micros - capture_window_start;
+    if (elapsed < CAPTURE_BUDGET_WINDOW_MICROS) return;
+    const uint64_t cost_percent_x100 = capture_cost_micros * 10000 / elapsed;
+    const uint64_t budget_x100 = (uint64_t)capture_budget_percent * 100;
+    if (cost_percent_x100 > budget_x100) {
+        if (capture_backoff < CAPTURE_MAX_BACKOFF) capture_backoff *= 2;
+    } else if (cost_percent_x100 < budget_x100 / 4) {
+        if (capture_backoff > 1) capture_backoff /= 2;
+    }
+    capture_cost_micros = 0;
+    capture_window_start = end_micros;
+}
+
+static void _bolt_process_captures(uint32_t window_width, uint32_t window_height) {
+    uint64_t micros = 0;
+    _bolt_monotonic_microseconds(&micros);
+    uint8_t any_captures = false;
+
     lock_windows_for_reading();
     size_t iter = 0;
     void* item;
     while (hashmap_iter(windows.map, &iter, &item)) {
         struct EmbeddedWindow* window = *(struct EmbeddedWindow**)item;
-        if (window->is_deleted) continue;
-        if (window->do_capture) {
-            const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_CAPTURENOTIFY_OSR;
-            const struct BoltIPCCaptureNotifyHeader header = {
-                .plugin_id = window->plugin_id,
-                .window_id = window->id,
-                .pid = getpid(),
-                .capture_id = capture_id,
-                .width = window_width,
-                .height = window_height,
-                .needs_remap = need_remap || (capture_id != window->capture_id),
-            };
-            _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-            _bolt_ipc_send(fd, &header, sizeof(header));
-            window->capture_ready = false;
-            window->capture_id = capture_id;
-        }
+        if (window->is_deleted || !window->do_capture) continue;
+        any_captures = true;
+        process_capture_target(&window->capture, IPC_MSG_CAPTURENOTIFY_OSR, window->plugin_id, window->id, &window->capture_ready, &window->capture_id, window_width, window_height, micros);
     }
     unlock_windows_for_reading();
 
@@ -706,24 +1269,22 @@ static void _bolt_process_captures(uint32_t window_width, uint32_t window_height
         size_t iter2 = 0;
         while (hashmap_iter(plugin->external_browsers, &iter2, &item2)) {
             struct ExternalBrowser* browser = *(struct ExternalBrowser**)item2;
-            if (browser->do_capture) {
-                const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_CAPTURENOTIFY_EXTERNAL;
-                    const struct BoltIPCCaptureNotifyHeader header = {
-                    .plugin_id = browser->plugin_id,
-                    .window_id = browser->id,
-                    .pid = getpid(),
-                    .capture_id = capture_id,
-                    .width = window_width,
-                    .height = window_height,
-                    .needs_remap = need_remap || (capture_id != browser->capture_id),
-                };
-                _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-                _bolt_ipc_send(fd, &header, sizeof(header));
-                browser->capture_ready = false;
-                browser->capture_id = capture_id;
-            }
+            if (!browser->do_capture) continue;
+            any_captures = true;
+            process_capture_target(&browser->capture, IPC_MSG_CAPTURENOTIFY_EXTERNAL, browser->plugin_id, browser->id, &browser->capture_ready, &browser->capture_id, window_width, window_height, micros);
         }
     }
+
+    if (any_captures) {
+        uint64_t end_micros = micros;
+        _bolt_monotonic_microseconds(&end_micros);
+        update_capture_backoff(micros, end_micros);
+    } else {
+        // nothing is capturing, so start from scratch next time something does
+        capture_backoff = 1;
+        capture_cost_micros = 0;
+        capture_window_start = 0;
+    }
 }
 
 void _bolt_plugin_end_frame(uint32_t window_width, uint32_t window_height) {
@@ -748,33 +1309,28 @@ void _bolt_plugin_end_frame(uint32_t window_width, uint32_t window_height) {
     }
 
     _bolt_plugin_handle_messages();
-    if (!overlay_inited) return;
-
-    uint8_t need_capture = false;
-    uint8_t capture_ready = true;
-    _bolt_process_embedded_windows(window_width, window_height, &need_capture, &capture_ready);
-    _bolt_process_plugins(&need_capture, &capture_ready);
-
-    uint64_t micros = 0;
-    _bolt_monotonic_microseconds(&micros);
-    if (need_capture && capture_ready && (micros >= next_capture_time)) {
-        _bolt_process_captures(window_width, window_height);
-        next_capture_time = micros + CAPTURE_COOLDOWN_MICROS;
-        if (next_capture_time < micros) next_capture_time = micros;
-    } else if (!need_capture && capture_inited) {
-        _bolt_plugin_shm_close(&capture_shm);
-        capture_inited = false;
+    if (!overlay_inited) {
+        ipc_queue_end_frame();
+        return;
     }
 
+    _bolt_process_embedded_windows(window_width, window_height);
+    _bolt_process_plugins();
+    _bolt_process_captures(window_width, window_height);
+
     struct SwapBuffersEvent event;
     _bolt_plugin_handle_swapbuffers(&event);
     overlay.draw_to_screen(overlay.userdata, 0, 0, window_width, window_height, 0, 0, window_width, window_height);
     overlay_windows.draw_to_screen(overlay_windows.userdata, 0, 0, window_width, window_height, 0, 0, window_width, window_height);
     overlay.clear(overlay.userdata, 0.0, 0.0, 0.0, 0.0);
     overlay_windows.clear(overlay_windows.userdata, 0.0, 0.0, 0.0, 0.0);
+    accounting_end_frame();
+    ipc_queue_end_frame();
 }
 
 void _bolt_plugin_close() {
+    ipc_queue_flush();
+    ipc_io_stop();
     _bolt_plugin_ipc_close(fd);
     size_t iter = 0;
     void* item;
@@ -784,6 +1340,7 @@ void _bolt_plugin_close() {
         if (!window->is_deleted) {
             if (window->is_browser) {
                 _bolt_plugin_shm_close(&window->browser_shm);
+                _bolt_plugin_capture_release(&window->capture);
             }
             managed_functions.surface_destroy(window->surface_functions.userdata);
             _bolt_rwlock_destroy(&window->lock);
@@ -798,34 +1355,37 @@ void _bolt_plugin_close() {
     }
     
     hashmap_free(plugins);
-    if (capture_inited) {
-        _bolt_plugin_shm_close(&capture_shm);
-        capture_inited = false;
-    }
+    free(ipc_queue.block);
+    memset(&ipc_queue, 0, sizeof(ipc_queue));
+    subscribed_events = 0;
     inited = 0;
 }
 
 void _bolt_plugin_notify_stopped(uint64_t id) {
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_CLIENT_STOPPED_PLUGIN;
     const struct BoltIPCClientStoppedPluginHeader header = { .plugin_id = id };
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
 }
 
 struct WindowInfo* _bolt_plugin_windowinfo() {
     return &windows;
 }
 
+// reads from the message currently being handled, which the reader thread has already received in full.
+// returns zero on success or non-zero if the message is shorter than that.
+static uint8_t ipc_read(void* data, size_t len) {
+    struct IPCBlock* block = ipc_io.inbound.head;
+    if (block->len - block->read < len) return 1;
+    memcpy(data, block->data + block->read, len);
+    block->read += len;
+    return 0;
+}
+
 static void _bolt_receive_discard(uint64_t amount) {
-    uint8_t buf[0x10000];
-    uint64_t i = 0;
-    while (amount - i > sizeof(buf)) {
-        _bolt_ipc_receive(fd, buf, sizeof(buf));
-        amount -= sizeof(buf);
-    }
-    if (i < amount) {
-        _bolt_ipc_receive(fd, buf, amount - i);
-    }
+    struct IPCBlock* block = ipc_io.inbound.head;
+    const size_t remaining = block->len - block->read;
+    block->read += (amount < remaining) ? amount : remaining;
 }
 
 /// can return nullptr if the browser is nonexistent or deleted
@@ -861,7 +1421,7 @@ static void handle_plugin_message(lua_State* state, struct BoltIPCBrowserMessage
     lua_gettable(state, -2); /*stack: window table, event table, function or nil*/
     if (lua_isfunction(state, -1)) {
         void* data = lua_newuserdata(state, header->message_size); /* window table, event table, function, message userdata*/
-        _bolt_ipc_receive(fd, data, header->message_size);
+        ipc_read(data, header->message_size);
         lua_pushvalue(state, -2); /* window table, event table, function, message userdata, function*/
         lua_pushlstring(state, data, header->message_size); /*stack: window table, event table, function, message userdata, function, message*/
         if (lua_pcall(state, 1, 0, 0)) { /*stack: window table, event table, function, message userdata, ?error*/
@@ -906,14 +1466,14 @@ static void handle_close_request(lua_State* state, uint64_t window_id) {
 
 #define IPCCASE(NAME, STRUCT) case IPC_MSG_##NAME: { \
     struct BoltIPC##STRUCT##Header header; \
-    _bolt_ipc_receive(fd, &header, sizeof(header)); \
+    ipc_read(&header, sizeof(header)); \
     handle_ipc_##NAME(&header); \
     break; \
 }
 
 #define IPCCASEWINDOW(NAME, STRUCT) case IPC_MSG_##NAME: { \
     struct BoltIPC##STRUCT##Header header; \
-    _bolt_ipc_receive(fd, &header, sizeof(header)); \
+    ipc_read(&header, sizeof(header)); \
     struct EmbeddedWindow* window = get_embeddedwindow(&header.window_id); \
     if (window && !window->is_deleted) handle_ipc_##NAME(&header, window); \
     break; \
@@ -921,7 +1481,7 @@ static void handle_close_request(lua_State* state, uint64_t window_id) {
 
 #define IPCCASEWINDOWTAIL(NAME, STRUCT) case IPC_MSG_##NAME: { \
     struct BoltIPC##STRUCT##Header header; \
-    _bolt_ipc_receive(fd, &header, sizeof(header)); \
+    ipc_read(&header, sizeof(header)); \
     struct EmbeddedWindow* window = get_embeddedwindow(&header.window_id); \
     if (window && !window->is_deleted) handle_ipc_##NAME(&header, window); \
     else _bolt_receive_discard(get_tail_ipc_##STRUCT(&header)); \
@@ -930,7 +1490,7 @@ static void handle_close_request(lua_State* state, uint64_t window_id) {
 
 #define IPCCASEBROWSER(NAME, STRUCT) case IPC_MSG_##NAME: { \
     struct BoltIPC##STRUCT##Header header; \
-    _bolt_ipc_receive(fd, &header, sizeof(header)); \
+    ipc_read(&header, sizeof(header)); \
     struct ExternalBrowser* window = get_externalbrowser(header.plugin_id, &header.window_id); \
     if (window && !window->plugin->is_deleted) handle_ipc_##NAME(&header, window); \
     break; \
@@ -938,7 +1498,7 @@ static void handle_close_request(lua_State* state, uint64_t window_id) {
 
 #define IPCCASEBROWSERTAIL(NAME, STRUCT) case IPC_MSG_##NAME: { \
     struct BoltIPC##STRUCT##Header header; \
-    _bolt_ipc_receive(fd, &header, sizeof(header)); \
+    ipc_read(&header, sizeof(header)); \
     struct ExternalBrowser* window = get_externalbrowser(header.plugin_id, &header.window_id); \
     if (window && !window->plugin->is_deleted) handle_ipc_##NAME(&header, window); \
     else _bolt_receive_discard(get_tail_ipc_##STRUCT(&header)); \
@@ -950,7 +1510,7 @@ static void handle_ipc_STARTPLUGIN(struct BoltIPCStartPluginHeader* header) {
     // making sure to leave a trailing slash, when initiating this type of message
     // (see PluginMenu.svelte)
     struct Plugin* plugin = malloc(sizeof(struct Plugin));
-    plugin->external_browsers = hashmap_new(sizeof(struct ExternalBrowser), 8, 0, 0, _bolt_window_map_hash, _bolt_window_map_compare, NULL, NULL);
+    plugin->external_browsers = hashmap_new(sizeof(struct ExternalBrowser*), 8, 0, 0, _bolt_window_map_hash, _bolt_window_map_compare, NULL, NULL);
     plugin->state = luaL_newstate();
     plugin->id = header->uid;
     plugin->path = malloc(header->path_size);
@@ -958,18 +1518,29 @@ static void handle_ipc_STARTPLUGIN(struct BoltIPCStartPluginHeader* header) {
     plugin->config_path = malloc(header->config_path_size);
     plugin->config_path_length = header->config_path_size;
     plugin->ext_browser_capture_count = 0;
+    plugin->profiles = calloc(PLUGIN_EVENT_COUNT, sizeof(struct PluginEventProfile));
+    plugin->filters = calloc(PLUGIN_EVENT_COUNT, sizeof(struct PluginEventFilter));
+    plugin->subscribed_events = 0;
+    plugin->frames = 0;
+    plugin->frame_used_nanos = 0;
+    plugin->deadline_nanos = 0;
+    plugin->skip_until_frame = 0;
+    plugin->last_strike_frame = 0;
+    plugin->budget_strikes = 0;
+    plugin->budget_exceeded = false;
     plugin->is_deleted = false;
-    _bolt_ipc_receive(fd, plugin->path, header->path_size);
+    ipc_read(plugin->path, header->path_size);
     char* full_path = lua_newuserdata(plugin->state, header->path_size + header->main_size + 1);
     memcpy(full_path, plugin->path, header->path_size);
-    _bolt_ipc_receive(fd, full_path + header->path_size, header->main_size);
-    _bolt_ipc_receive(fd, plugin->config_path, header->config_path_size);
+    ipc_read(full_path + header->path_size, header->main_size);
+    ipc_read(plugin->config_path, header->config_path_size);
     full_path[header->path_size + header->main_size] = '\0';
     if (_bolt_plugin_add(full_path, plugin)) {
         lua_pop(plugin->state, 1);
     } else {
         _bolt_plugin_notify_stopped(header->uid);
         plugin->is_deleted = true;
+        update_subscribed_events();
     }
 }
 
@@ -977,6 +1548,34 @@ static void handle_ipc_HOST_STOPPED_PLUGIN(struct BoltIPCHostStoppedPluginHeader
     _bolt_plugin_stop(header->plugin_id);
 }
 
+static void handle_ipc_PLUGINPROFILEREQUEST(struct BoltIPCPluginProfileRequestHeader* header) {
+    struct Plugin p = {.id = header->plugin_id};
+    struct Plugin* pp = &p;
+    struct Plugin* const* plugin = hashmap_get(plugins, &pp);
+    if (!plugin || (*plugin)->is_deleted) return;
+    struct BoltIPCPluginProfileEntry entries[PLUGIN_EVENT_COUNT];
+    uint32_t entry_count = 0;
+    for (size_t i = 0; i < PLUGIN_EVENT_COUNT; i += 1) {
+        struct PluginEventStats stats;
+        if (!_bolt_plugin_event_stats(*plugin, i, &stats)) continue;
+        struct BoltIPCPluginProfileEntry* entry = &entries[entry_count];
+        memset(entry->event_name, 0, sizeof(entry->event_name));
+        strncpy(entry->event_name, event_names[i], sizeof(entry->event_name) - 1);
+        entry->calls = stats.calls;
+        entry->frames = stats.frames;
+        entry->total_nanos = stats.total_nanos;
+        entry->max_call_nanos = stats.max_call_nanos;
+        entry->max_frame_nanos = stats.max_frame_nanos;
+        entry->p99_frame_nanos = stats.p99_frame_nanos;
+        entry_count += 1;
+    }
+    const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_PLUGINPROFILE;
+    const struct BoltIPCPluginProfileHeader reply = { .plugin_id = header->plugin_id, .entry_count = entry_count };
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&reply, sizeof(reply));
+    _bolt_plugin_ipc_send(entries, entry_count * sizeof(*entries));
+}
+
 static size_t get_tail_ipc_OsrUpdate(const struct BoltIPCOsrUpdateHeader* header) {
     return (size_t)header->rect_count * sizeof(struct BoltIPCOsrUpdateRect);
 }
@@ -992,14 +1591,14 @@ static void handle_ipc_OSRUPDATE(struct BoltIPCOsrUpdateHeader* header, struct E
         // damage area. that way we have contiguous pixels straight out of the shm file.
         // would it be faster to allocate and build a contiguous pixel rect and use
         // that as the subimage? probably not.
-        _bolt_ipc_receive(fd, &rect, sizeof(rect));
+        ipc_read(&rect, sizeof(rect));
         const void* data_ptr = (const void*)((uint8_t*)window->browser_shm.file + (header->width * rect.y * 4));
         window->surface_functions.subimage(window->surface_functions.userdata, 0, rect.y, header->width, rect.h, data_ptr, 1);
     }
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_OSRUPDATE_ACK;
     const struct BoltIPCOsrUpdateAckHeader ack_header = { .window_id = header->window_id, .plugin_id = window->plugin_id };
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &ack_header, sizeof(ack_header));
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&ack_header, sizeof(ack_header));
 }
 
 static size_t get_tail_ipc_OsrPopupContents(const struct BoltIPCOsrPopupContentsHeader* header) {
@@ -1010,7 +1609,7 @@ static void handle_ipc_OSRPOPUPCONTENTS(struct BoltIPCOsrPopupContentsHeader* he
     const size_t rgba_size = get_tail_ipc_OsrPopupContents(header);
     void* rgba = lua_newuserdata(window->plugin, rgba_size);
     struct EmbeddedWindowMetadata* meta = &window->popup_meta;
-    _bolt_ipc_receive(fd, rgba, rgba_size);
+    ipc_read(rgba, rgba_size);
     if (!window->popup_initialised) {
         managed_functions.surface_init(&window->popup_surface_functions, header->width, header->height, NULL);
         window->popup_initialised = true;
@@ -1071,13 +1670,122 @@ static void handle_ipc_OSRCAPTUREDONE(struct BoltIPCOsrCaptureDoneHeader* header
     window->capture_ready = true;
 }
 
+// size of the header that comes after each type of message from the host, or 0 for unknown types
+static size_t ipc_header_size(enum BoltIPCMessageTypeToClient msg_type) {
+#define IPCSIZE(NAME, STRUCT) case IPC_MSG_##NAME: return sizeof(struct BoltIPC##STRUCT##Header);
+    switch (msg_type) {
+        IPCSIZE(STARTPLUGIN, StartPlugin)
+        IPCSIZE(HOST_STOPPED_PLUGIN, HostStoppedPlugin)
+        IPCSIZE(PLUGINPROFILEREQUEST, PluginProfileRequest)
+        IPCSIZE(OSRUPDATE, OsrUpdate)
+        IPCSIZE(OSRPOPUPCONTENTS, OsrPopupContents)
+        IPCSIZE(OSRPOPUPPOSITION, OsrPopupPosition)
+        IPCSIZE(OSRPOPUPVISIBILITY, OsrPopupVisibility)
+        IPCSIZE(EXTERNALBROWSERMESSAGE, BrowserMessage)
+        IPCSIZE(OSRBROWSERMESSAGE, BrowserMessage)
+        IPCSIZE(OSRSTARTREPOSITION, OsrStartReposition)
+        IPCSIZE(OSRCANCELREPOSITION, OsrCancelReposition)
+        IPCSIZE(BROWSERCLOSEREQUEST, BrowserCloseRequest)
+        IPCSIZE(OSRCLOSEREQUEST, OsrCloseRequest)
+        IPCSIZE(EXTERNALCAPTUREDONE, ExternalCaptureDone)
+        IPCSIZE(OSRCAPTUREDONE, OsrCaptureDone)
+        default: return 0;
+    }
+#undef IPCSIZE
+}
+
+// number of bytes that come after a message's header
+static size_t ipc_tail_size(enum BoltIPCMessageTypeToClient msg_type, const void* header) {
+    switch (msg_type) {
+        case IPC_MSG_STARTPLUGIN: {
+            const struct BoltIPCStartPluginHeader* start = header;
+            return (size_t)start->path_size + start->main_size + start->config_path_size;
+        }
+        case IPC_MSG_OSRUPDATE: return get_tail_ipc_OsrUpdate(header);
+        case IPC_MSG_OSRPOPUPCONTENTS: return get_tail_ipc_OsrPopupContents(header);
+        case IPC_MSG_EXTERNALBROWSERMESSAGE:
+        case IPC_MSG_OSRBROWSERMESSAGE: return get_tail_ipc_BrowserMessage(header);
+        default: return 0;
+    }
+}
+
+// receives whole messages from the host and queues each one as a block for the render thread, until the
+// connection is closed
+IPC_THREAD_FUNC(ipc_reader_thread) {
+    enum BoltIPCMessageTypeToClient msg_type;
+    uint64_t header[16];
+    while (_bolt_ipc_receive(fd, &msg_type, sizeof(msg_type)) == 0) {
+        const size_t header_size = ipc_header_size(msg_type);
+        if (!header_size || header_size > sizeof(header)) {
+            // there's no way to know how long this message is, so nothing after it can be read either
+            printf("unknown message type %i\n", (int)msg_type);
+            break;
+        }
+        if (_bolt_ipc_receive(fd, header, header_size)) break;
+        const size_t tail_size = ipc_tail_size(msg_type, header);
+        struct IPCBlock* block = ipc_block_new(sizeof(msg_type) + header_size + tail_size);
+        memcpy(block->data, &msg_type, sizeof(msg_type));
+        memcpy(block->data + sizeof(msg_type), header, header_size);
+        if (tail_size && _bolt_ipc_receive(fd, block->data + sizeof(msg_type) + header_size, tail_size)) {
+            free(block);
+            break;
+        }
+        block->len = block->capacity;
+        ipc_block_queue_push(&ipc_io.inbound, block);
+    }
+    return IPC_THREAD_RETURN;
+}
+
+static void ipc_io_start() {
+    ipc_block_queue_init(&ipc_io.outbound);
+    ipc_block_queue_init(&ipc_io.inbound);
+    ipc_io.stopping = false;
+    ipc_io.failed = false;
+    ipc_io.syscalls = 0;
+#if defined(_WIN32)
+    ipc_io.outbound_signal = CreateSemaphoreW(NULL, 0, LONG_MAX, NULL);
+    ipc_io.writer = CreateThread(NULL, 0, ipc_writer_thread, NULL, 0, NULL);
+    ipc_io.reader = CreateThread(NULL, 0, ipc_reader_thread, NULL, 0, NULL);
+#else
+    sem_init(&ipc_io.outbound_signal, 0, 0);
+    pthread_create(&ipc_io.writer, NULL, ipc_writer_thread, NULL);
+    pthread_create(&ipc_io.reader, NULL, ipc_reader_thread, NULL);
+#endif
+    ipc_io.running = true;
+}
+
+// sends anything that's still queued, then stops both I/O threads. this does wait for the host, but it's
+// only done when the game is closing.
+static void ipc_io_stop() {
+    if (!ipc_io.running) return;
+    ipc_io.running = false;
+    ATOMIC_STORE_U32(&ipc_io.stopping, true);
+    ipc_semaphore_post(&ipc_io.outbound_signal);
+#if defined(_WIN32)
+    WaitForSingleObject(ipc_io.writer, INFINITE);
+    shutdown(fd, SD_BOTH);
+    WaitForSingleObject(ipc_io.reader, INFINITE);
+    CloseHandle(ipc_io.writer);
+    CloseHandle(ipc_io.reader);
+    CloseHandle(ipc_io.outbound_signal);
+#else
+    pthread_join(ipc_io.writer, NULL);
+    shutdown(fd, SHUT_RDWR);
+    pthread_join(ipc_io.reader, NULL);
+    sem_destroy(&ipc_io.outbound_signal);
+#endif
+    ipc_block_queue_destroy(&ipc_io.outbound);
+    ipc_block_queue_destroy(&ipc_io.inbound);
+}
+
 void _bolt_plugin_handle_messages() {
     enum BoltIPCMessageTypeToHost msg_type;
-    while (_bolt_ipc_poll(fd)) {
-        if (_bolt_ipc_receive(fd, &msg_type, sizeof(msg_type)) != 0) break;
+    while (ipc_io.running && ipc_block_queue_pop(&ipc_io.inbound)) {
+        if (ipc_read(&msg_type, sizeof(msg_type)) != 0) continue;
         switch (msg_type) {
             IPCCASE(STARTPLUGIN, StartPlugin)
             IPCCASE(HOST_STOPPED_PLUGIN, HostStoppedPlugin)
+            IPCCASE(PLUGINPROFILEREQUEST, PluginProfileRequest)
             IPCCASEWINDOWTAIL(OSRUPDATE, OsrUpdate)
             IPCCASEWINDOWTAIL(OSRPOPUPCONTENTS, OsrPopupContents)
             IPCCASEWINDOW(OSRPOPUPPOSITION, OsrPopupPosition)
@@ -1207,21 +1915,21 @@ uint8_t _bolt_plugin_handle_mouse_event(struct MouseEvent* event, ptrdiff_t bool
     return true;
 }
 
-DEFINE_CALLBACK_STATIC(swapbuffers, SwapBuffersEvent)
-DEFINE_CALLBACK(render2d, RenderBatch2D)
-DEFINE_CALLBACK(render3d, Render3D)
-DEFINE_CALLBACK(renderparticles, RenderParticles)
-DEFINE_CALLBACK(renderbillboard, RenderBillboard)
-DEFINE_CALLBACK(rendericon, RenderIconEvent)
-DEFINE_CALLBACK(renderbigicon, RenderIconEvent)
-DEFINE_CALLBACK(minimapterrain, MinimapTerrainEvent)
-DEFINE_CALLBACK(minimaprender2d, RenderBatch2D)
-DEFINE_CALLBACK(renderminimap, RenderMinimapEvent)
-DEFINE_CALLBACK(rendergameview, RenderGameViewEvent)
-DEFINE_CALLBACK(mousemotion, MouseMotionEvent)
-DEFINE_CALLBACK(mousebutton, MouseButtonEvent)
-DEFINE_CALLBACK(mousebuttonup, MouseButtonEvent)
-DEFINE_CALLBACK(scroll, MouseScrollEvent)
+DEFINE_CALLBACK_STATIC(swapbuffers, SwapBuffersEvent, SWAPBUFFERS, filter_none)
+DEFINE_CALLBACK(render2d, RenderBatch2D, RENDER2D, filter_batch2d)
+DEFINE_CALLBACK(render3d, Render3D, RENDER3D, filter_render3d)
+DEFINE_CALLBACK(renderparticles, RenderParticles, RENDERPARTICLES, filter_particles)
+DEFINE_CALLBACK(renderbillboard, RenderBillboard, RENDERBILLBOARD, filter_billboard)
+DEFINE_CALLBACK(rendericon, RenderIconEvent, RENDERICON, filter_none)
+DEFINE_CALLBACK(renderbigicon, RenderIconEvent, RENDERBIGICON, filter_none)
+DEFINE_CALLBACK(minimapterrain, MinimapTerrainEvent, MINIMAPTERRAIN, filter_none)
+DEFINE_CALLBACK(minimaprender2d, RenderBatch2D, MINIMAPRENDER2D, filter_batch2d)
+DEFINE_CALLBACK(renderminimap, RenderMinimapEvent, RENDERMINIMAP, filter_none)
+DEFINE_CALLBACK(rendergameview, RenderGameViewEvent, RENDERGAMEVIEW, filter_none)
+DEFINE_CALLBACK(mousemotion, MouseMotionEvent, MOUSEMOTION, filter_none)
+DEFINE_CALLBACK(mousebutton, MouseButtonEvent, MOUSEBUTTON, filter_none)
+DEFINE_CALLBACK(mousebuttonup, MouseButtonEvent, MOUSEBUTTONUP, filter_none)
+DEFINE_CALLBACK(scroll, MouseScrollEvent, SCROLL, filter_none)
 DEFINE_WINDOWEVENT(reposition, REPOSITION, RepositionEvent)
 DEFINE_WINDOWEVENT(mousemotion, MOUSEMOTION, MouseMotionEvent)
 DEFINE_WINDOWEVENT(mousebutton, MOUSEBUTTON, MouseButtonEvent)
@@ -1250,6 +1958,7 @@ uint8_t _bolt_plugin_add(const char* path, struct Plugin* plugin) {
         // by starting 18 quintillion plugins in one session? okay, yes, it's very unlikely.
         printf("plugin ID %llu has been overwritten by one with the same ID\n", (unsigned long long)plugin->id);
         (*old_plugin)->is_deleted = true;
+        update_subscribed_events();
     }
 
     // add the struct pointer to the registry
@@ -1257,6 +1966,9 @@ uint8_t _bolt_plugin_add(const char* path, struct Plugin* plugin) {
     lua_pushlightuserdata(plugin->state, plugin);
     lua_settable(plugin->state, LUA_REGISTRYINDEX);
 
+    // enforce the frame budget during event handlers; the hook does nothing outside of them
+    if (frame_budget_nanos) lua_sethook(plugin->state, budget_hook, LUA_MASKCOUNT, BUDGET_HOOK_INTERVAL);
+
     // Open just the specific libraries plugins are allowed to have
     lua_pushcfunction(plugin->state, luaopen_base);
     lua_call(plugin->state, 0, 0);
@@ -1303,6 +2015,14 @@ uint8_t _bolt_plugin_add(const char* path, struct Plugin* plugin) {
     lua_newtable(plugin->state);
     lua_settable(plugin->state, LUA_REGISTRYINDEX);
 
+    // create the metatable given to event objects after their callback has returned
+    lua_pushliteral(plugin->state, EXPIREDEVENT_REGISTRYNAME);
+    lua_newtable(plugin->state);
+    lua_pushliteral(plugin->state, "__index");
+    lua_pushcfunction(plugin->state, expired_event_index);
+    lua_settable(plugin->state, -3);
+    lua_settable(plugin->state, LUA_REGISTRYINDEX);
+
     // create metatables
 #define SETMETA(NAME) \
 lua_pushliteral(plugin->state, #NAME "meta"); \
@@ -1350,6 +2070,7 @@ lua_settable(plugin->state, LUA_REGISTRYINDEX);
         printf("plugin startup error: %s\n", e);
         lua_pop(plugin->state, 1);
         plugin->is_deleted = true;
+        update_subscribed_events();
         return 0;
     } else {
         return 1;
@@ -1362,6 +2083,7 @@ void _bolt_plugin_stop(uint64_t uid) {
     struct Plugin* pp = &p;
     struct Plugin* const* plugin = hashmap_get(plugins, &pp);
     (*plugin)->is_deleted = true;
+    update_subscribed_events();
 }
 
 void _bolt_plugin_ipc_init(BoltSocketType* fd) {
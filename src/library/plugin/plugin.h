@@ -18,6 +18,116 @@
 #define MAX_MODELS_PER_ICON 8
 #define MAX_PROGRAM_BINDINGS 16
 
+/// Types of event which are sent to every plugin, and which have their handlers profiled.
+enum PluginEventType {
+    PLUGIN_EVENT_SWAPBUFFERS,
+    PLUGIN_EVENT_RENDER2D,
+    PLUGIN_EVENT_RENDER3D,
+    PLUGIN_EVENT_RENDERPARTICLES,
+    PLUGIN_EVENT_RENDERBILLBOARD,
+    PLUGIN_EVENT_RENDERICON,
+    PLUGIN_EVENT_RENDERBIGICON,
+    PLUGIN_EVENT_MINIMAPTERRAIN,
+    PLUGIN_EVENT_MINIMAPRENDER2D,
+    PLUGIN_EVENT_RENDERMINIMAP,
+    PLUGIN_EVENT_RENDERGAMEVIEW,
+    PLUGIN_EVENT_MOUSEMOTION,
+    PLUGIN_EVENT_MOUSEBUTTON,
+    PLUGIN_EVENT_MOUSEBUTTONUP,
+    PLUGIN_EVENT_SCROLL,
+    PLUGIN_EVENT_COUNT,
+};
+
+/// Bit representing an event type in a bitmask of event types, such as _bolt_plugin_subscribed_events
+#define PLUGIN_EVENT_BIT(TYPE) (1u << (TYPE))
+
+/// Number of recent frames for which each plugin's per-frame handler times are kept.
+#define PLUGIN_PROFILE_FRAMES 256
+
+/// Number of bytes that can build up in the outgoing IPC queue before it gets handed to the I/O thread mid-frame
+#define IPC_QUEUE_MAX_BYTES (256 * 1024)
+
+/// Counters for the outgoing IPC queue, as returned by _bolt_plugin_ipc_stats
+struct PluginIPCStats {
+    uint64_t frames;
+    uint64_t syscalls;
+    uint64_t bytes;
+    uint64_t last_frame_syscalls;
+    uint64_t last_frame_bytes;
+    uint64_t max_frame_syscalls;
+    uint64_t max_frame_bytes;
+};
+
+/// Counters for the CPU shadow copies of the game's textures, as returned by
+/// PluginManagedFunctions.texture_shadow_stats. `budget` is 0 if there's no limit.
+struct TextureShadowStats {
+    uint64_t bytes;
+    uint64_t budget;
+    uint64_t evictions;
+    uint64_t evicted_bytes;
+    uint64_t restores;
+};
+
+/// CPU time spent in one plugin's handler for one type of event. Times are in nanoseconds.
+struct PluginEventProfile {
+    uint64_t calls;
+    uint64_t total_nanos;
+    uint64_t max_call_nanos;
+    uint64_t frame_nanos; // time spent so far in the current frame
+    uint32_t frame_history[PLUGIN_PROFILE_FRAMES]; // time spent in recent frames, overwriting the oldest first
+    uint32_t frame_history_count;
+    uint32_t frame_history_next;
+};
+
+/// Default for the per-plugin, per-frame time budget for event handlers, in milliseconds. Can be overridden
+/// with the BOLT_PLUGIN_FRAME_BUDGET_MS environment variable, where 0 means no budget.
+#define PLUGIN_DEFAULT_FRAME_BUDGET_MS 50
+/// Number of times a plugin can exceed its frame budget before it gets stopped
+#define PLUGIN_BUDGET_STRIKES 5
+/// Number of frames without exceeding the budget after which a plugin loses one strike
+#define PLUGIN_BUDGET_DECAY_FRAMES 600
+
+/// Time between captures for browsers that don't ask for a specific interval, in microseconds
+#define CAPTURE_DEFAULT_INTERVAL_MICROS 250000
+/// Longest interval between captures that a browser can ask for, in microseconds
+#define CAPTURE_MAX_INTERVAL_MICROS 60000000
+/// Default for the percentage of frame time that screen captures may use before they start being done less
+/// often. Can be overridden with the BOLT_CAPTURE_BUDGET_PERCENT environment variable, where 0 means no limit.
+#define CAPTURE_DEFAULT_BUDGET_PERCENT 10
+/// How often capture cost is compared against the budget, in microseconds
+#define CAPTURE_BUDGET_WINDOW_MICROS 1000000
+/// Largest factor by which capture intervals can be stretched when captures are over budget
+#define CAPTURE_MAX_BACKOFF 16
+/// Intervals shorter than this, in microseconds, are treated as being this long when they're being stretched,
+/// so that browsers asking for every frame still get slowed down
+#define CAPTURE_BACKOFF_MIN_INTERVAL_MICROS 16667
+
+/// Maximum number of texture IDs that one PluginEventFilter can match against
+#define PLUGIN_FILTER_MAX_TEXTURES 64
+
+/// Conditions which a render event must meet before it's passed to a plugin's handler, set from Lua using
+/// bolt.setrenderfilter. These are checked without entering the Lua VM, so events which fail them cost
+/// very little. Only render2d, minimaprender2d, render3d, renderparticles and renderbillboard can be filtered.
+struct PluginEventFilter {
+    uint8_t enabled;
+    uint32_t min_vertices;
+    uint32_t max_vertices;
+    uint32_t texture_id_count; // 0 means any texture is allowed
+    size_t texture_ids[PLUGIN_FILTER_MAX_TEXTURES]; // sorted in ascending order
+    uint8_t has_atlas; // render2d and minimaprender2d only
+    int32_t atlas_xywh[4]; // if has_atlas, at least one icon in the batch must have exactly this atlas region
+};
+
+/// Summary of a PluginEventProfile, see _bolt_plugin_event_stats. Times are in nanoseconds.
+struct PluginEventStats {
+    uint64_t calls;
+    uint64_t frames;
+    uint64_t total_nanos;
+    uint64_t max_call_nanos;
+    uint64_t max_frame_nanos;
+    uint64_t p99_frame_nanos;
+};
+
 // a currently-running plugin.
 // note "path" is not null-terminated, and must always be converted to use '/' as path-separators
 // and must always end with a trailing separator by the time it's received by this process.
@@ -30,6 +140,16 @@ struct Plugin {
     uint32_t path_length;
     char* config_path;
     uint32_t config_path_length;
+    struct PluginEventProfile* profiles; // PLUGIN_EVENT_COUNT entries, indexed by enum PluginEventType
+    struct PluginEventFilter* filters; // PLUGIN_EVENT_COUNT entries, indexed by enum PluginEventType
+    uint32_t subscribed_events; // PLUGIN_EVENT_BITs of the events this plugin has a handler for
+    uint64_t frames; // number of frames this plugin has been running for
+    uint64_t frame_used_nanos; // time spent in event handlers so far this frame
+    uint64_t deadline_nanos; // when the current handler runs out of budget, or 0 if not in a handler
+    uint64_t skip_until_frame; // event handlers are skipped until `frames` reaches this value
+    uint64_t last_strike_frame;
+    uint8_t budget_strikes;
+    uint8_t budget_exceeded; // set when the current handler was aborted for running out of budget
     uint8_t is_deleted;
 };
 
@@ -66,6 +186,20 @@ struct Vertex2DFunctions {
 
     /// Returns the RGBA colour of this vertex, each one normalised from 0.0 to 1.0.
     void (*colour)(size_t index, void* userdata, double* out);
+
+    /// Batch version of xy: fetches `count` vertices starting at `first`, two values per vertex.
+    void (*xy_batch)(size_t first, size_t count, void* userdata, int32_t* out);
+
+    /// Batch version of atlas_details: fetches `count` vertices starting at `first`, four values per vertex
+    /// in `out` and one per vertex in each of `wrapx` and `wrapy`.
+    void (*atlas_details_batch)(size_t first, size_t count, void* userdata, int32_t* out, uint8_t* wrapx, uint8_t* wrapy);
+
+    /// Batch version of uv: fetches `count` vertices starting at `first`, two values per vertex in `out`
+    /// and one per vertex in `discard`.
+    void (*uv_batch)(size_t first, size_t count, void* userdata, double* out, uint8_t* discard);
+
+    /// Batch version of colour: fetches `count` vertices starting at `first`, four values per vertex.
+    void (*colour_batch)(size_t first, size_t count, void* userdata, double* out);
 };
 
 /// Struct containing "vtable" callback information for Render3D's list of vertices.
@@ -95,6 +229,25 @@ struct Vertex3DFunctions {
 
     /// Returns the animation transform matrix for the given vertex. Assumes the model is animated.
     void (*bone_transform)(size_t vertex, void* userdata, struct Transform3D* out);
+
+    /// Batch version of xyz: fetches `count` vertices starting at `first`, as three values (X, Y and
+    /// Z) per vertex. These are doubles regardless of how the vertices are stored by the game.
+    void (*xyz_batch)(size_t first, size_t count, void* userdata, double* out);
+
+    /// Batch version of uv: fetches `count` vertices starting at `first`, two values per vertex.
+    void (*uv_batch)(size_t first, size_t count, void* userdata, double* out);
+
+    /// Batch version of colour: fetches `count` vertices starting at `first`, four values per vertex.
+    void (*colour_batch)(size_t first, size_t count, void* userdata, double* out);
+
+    /// Fetches the bone ID of `count` vertices starting at `first`, one value per vertex.
+    void (*bone_id_batch)(size_t first, size_t count, void* userdata, uint8_t* out);
+
+    /// Returns a hash of the model's vertex positions and bone labels, in draw order. The same model
+    /// will always give the same hash, even across sessions. Results are cached for as long as the
+    /// underlying buffers are unmodified, so calling this repeatedly for the same model is cheap.
+    /// The hash is at most 53 bits. Returns 0 if the vertex data isn't available.
+    uint64_t (*model_hash)(void* userdata);
 };
 
 /// Struct containing "vtable" callback information for RenderParticles' list of vertices.
@@ -125,6 +278,15 @@ struct VertexParticleFunctions {
 
     /// Returns the RGBA colour of this vertex, each one normalised from 0.0 to 1.0.
     void (*colour)(size_t index, void* userdata, double* out);
+
+    /// Batch version of xyz: fetches `count` vertices starting at `first`, three values per vertex.
+    void (*xyz_batch)(size_t first, size_t count, void* userdata, double* out);
+
+    /// Batch version of uv: fetches `count` vertices starting at `first`, two values per vertex.
+    void (*uv_batch)(size_t first, size_t count, void* userdata, double* out);
+
+    /// Batch version of colour: fetches `count` vertices starting at `first`, four values per vertex.
+    void (*colour_batch)(size_t first, size_t count, void* userdata, double* out);
 };
 
 /// Struct containing "vtable" callback information for RenderBillboard's list of vertices.
@@ -151,6 +313,15 @@ struct VertexBillboardFunctions {
 
     /// Returns the RGBA colour of this vertex, each one normalised from 0.0 to 1.0.
     void (*colour)(size_t index, void* userdata, double* out);
+
+    /// Batch version of xyz: fetches `count` vertices starting at `first`, three values per vertex.
+    void (*xyz_batch)(size_t first, size_t count, void* userdata, double* out);
+
+    /// Batch version of uv: fetches `count` vertices starting at `first`, two values per vertex.
+    void (*uv_batch)(size_t first, size_t count, void* userdata, double* out);
+
+    /// Batch version of colour: fetches `count` vertices starting at `first`, four values per vertex.
+    void (*colour_batch)(size_t first, size_t count, void* userdata, double* out);
 };
 
 /// Struct containing "vtable" callback information for various types of render's transformation matrices.
@@ -195,7 +366,12 @@ struct TextureFunctions {
 
     /// Fetches a pointer to the texture's pixel data at coordinates x and y. Doesn't do any checks
     /// on whether x and y are in-bounds. Data is always RGBA and pixel rows are always contiguous.
-    uint8_t* (*data)(void* userdata, size_t x, size_t y);
+    /// Only the `len` bytes following the pointer are guaranteed to be up-to-date.
+    uint8_t* (*data)(void* userdata, size_t x, size_t y, size_t len);
+
+    /// Returns a number which changes whenever the texture's contents are changed by an upload or copy,
+    /// and is never reused by any other texture. Rendering to the texture doesn't change it.
+    uint64_t (*generation)(void* userdata);
 };
 
 /// Struct containing "vtable" callback information for events which have a camera position.
@@ -305,9 +481,15 @@ struct PluginManagedFunctions {
     void (*surface_resize_and_clear)(void*, unsigned int, unsigned int);
     void (*draw_region_outline)(void* target, int16_t x, int16_t y, uint16_t width, uint16_t height);
     void (*read_screen_pixels)(int16_t x, int16_t y, uint32_t width, uint32_t height, void* data);
+    void* (*capture_screen_init)(void);
+    uint8_t (*capture_screen_begin)(void* userdata, int16_t x, int16_t y, uint32_t width, uint32_t height, uint32_t out_width, uint32_t out_height, uint8_t format, uint8_t shared_only);
+    uint8_t (*capture_screen_poll)(void* userdata, uint32_t* width, uint32_t* height, uint8_t* format);
+    void (*capture_screen_read)(void* userdata, void* data);
+    void (*capture_screen_destroy)(void* userdata);
     void (*copy_screen)(void*, int sx, int sy, int sw, int sh, int dx, int dy, int dw, int dh);
     void (*game_view_rect)(int* x, int* y, int* w, int* h);
     void (*player_position)(int32_t* x, int32_t* y, int32_t* z);
+    void (*texture_shadow_stats)(struct TextureShadowStats* out);
 
     uint8_t (*vertex_shader_init)(struct ShaderFunctions*, const char* source, int len, char* output, int output_len);
     uint8_t (*fragment_shader_init)(struct ShaderFunctions*, const char* source, int len, char* output, int output_len);
@@ -355,6 +537,31 @@ struct BoltSHM {
     void* file;
 };
 
+/// The part of the game window that a browser wants captured, and how. Coordinates are in pixels from the
+/// top-left of the window; a width or height of 0 means "up to the edge of the window". `scale` is in the
+/// range (0, 1], and `format` is a BoltIPCCaptureFormat. `interval_micros` is how long the browser wants
+/// to wait between captures, which may be stretched if captures are taking up too much of the frame.
+struct CaptureRequest {
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+    double scale;
+    uint8_t format;
+    uint32_t interval_micros;
+};
+
+/// Screen capture state belonging to one browser
+struct CaptureTarget {
+    struct CaptureRequest request;
+    void* userdata; // from PluginManagedFunctions.capture_screen_init, or NULL if not created yet
+    struct BoltSHM shm;
+    uint64_t shm_id;
+    size_t shm_size;
+    uint8_t shm_inited;
+    uint64_t next_capture_time;
+};
+
 struct EmbeddedWindowMetadata {
     int x;
     int y;
@@ -391,6 +598,7 @@ struct EmbeddedWindow {
     uint8_t popup_shown; // always false for non-browser
     uint8_t popup_initialised;
     uint64_t capture_id;
+    struct CaptureTarget capture;
     struct BoltSHM browser_shm;
     struct EmbeddedWindowMetadata popup_meta;
     struct SurfaceFunctions popup_surface_functions;
@@ -580,6 +788,13 @@ void _bolt_plugin_shm_resize(struct BoltSHM* shm, size_t length, uint64_t new_id
 /// HANDLE object, created by the host using DuplicateHandle, and is unused on non-Windows systems.
 void _bolt_plugin_shm_remap(struct BoltSHM* shm, size_t length, void* handle);
 
+/// Resets a CaptureTarget to capture the whole window in RGB format, without allocating anything.
+void _bolt_plugin_capture_init(struct CaptureTarget* target);
+
+/// Frees everything owned by a CaptureTarget. It can be used again afterwards, and will keep its request.
+/// Must be called from the render thread.
+void _bolt_plugin_capture_release(struct CaptureTarget* target);
+
 /* The following handlers send the relevant event to all plugins in no particular order */
 void _bolt_plugin_handle_render2d(const struct RenderBatch2D*);
 void _bolt_plugin_handle_render3d(const struct Render3D*);
@@ -596,6 +811,29 @@ void _bolt_plugin_handle_rendergameview(const struct RenderGameViewEvent*);
 /// Can only fail on Windows, and even then there are no known cases where it would fail.
 uint8_t _bolt_monotonic_microseconds(uint64_t* microseconds);
 
+/// Same as _bolt_monotonic_microseconds, but in nanoseconds. The actual precision depends on the platform.
+uint8_t _bolt_monotonic_nanoseconds(uint64_t* nanoseconds);
+
+/// Returns a bitmask of PLUGIN_EVENT_BITs for the event types that at least one running plugin has a
+/// handler for. Events of other types don't need to be constructed, since nothing would receive them.
+uint32_t _bolt_plugin_subscribed_events();
+
+/// Records whether a plugin has a handler for an event type. Should be called whenever a handler is set or removed.
+void _bolt_plugin_set_subscribed(struct Plugin*, enum PluginEventType, uint8_t subscribed);
+
+/// Sets or replaces a plugin's filter for an event type. The filter is copied, and its texture IDs needn't be sorted.
+void _bolt_plugin_set_filter(struct Plugin*, enum PluginEventType, const struct PluginEventFilter*);
+
+/// Gets the name of an event type, as used in the Lua API (e.g. "render3d" for bolt.onrender3d).
+const char* _bolt_plugin_event_name(enum PluginEventType);
+
+/// Summarises the time a plugin has spent in its handler for the given event type. Returns false if the
+/// handler has never been called, in which case `out` is not written to.
+uint8_t _bolt_plugin_event_stats(const struct Plugin*, enum PluginEventType, struct PluginEventStats* out);
+
+/// Gets the counters for IPC messages sent to the host since the library was initialised
+void _bolt_plugin_ipc_stats(struct PluginIPCStats* out);
+
 /// Marks the plugin and its embedded-windows as deleted
 void _bolt_plugin_stop(uint64_t id);
 
@@ -610,8 +848,10 @@ const struct PluginManagedFunctions* _bolt_plugin_managed_functions();
 /// Returns a new unique window ID and increments the counter
 uint64_t _bolt_plugin_new_windowid();
 
-/// Gets the IPC handle
-BoltSocketType _bolt_plugin_fd();
+/// Adds the given bytes to the outgoing IPC queue. The queue is handed to a background thread at the end of
+/// every frame, or sooner if it gets large, and that thread sends it to the host, so this never blocks.
+/// Returns zero on success or non-zero if the connection to the host has failed. Render thread only.
+uint8_t _bolt_plugin_ipc_send(const void* data, size_t len);
 
 /// Calls `managed_functions.draw_to_surface` using the internal overlay as the target,
 /// if the overlay is initialised. If not, it does nothing.
@@ -46,15 +46,19 @@ static void set_handler(lua_State* state, const char* regname, uint64_t window_i
 lua_getfield(state, LUA_REGISTRYINDEX, #NAME "meta"); \
 lua_setmetatable(state, -2);
 
-#define DEFINE_CALLBACK(APINAME) \
+#define DEFINE_CALLBACK(APINAME, EVTYPE) \
 static int api_on##APINAME(lua_State* state) { \
+    const uint8_t is_function = lua_isfunction(state, 1); \
     lua_pushliteral(state, #APINAME "cb"); \
-    if (lua_isfunction(state, 1)) { \
+    if (is_function) { \
         lua_pushvalue(state, 1); \
     } else { \
         lua_pushnil(state); \
     } \
     lua_settable(state, LUA_REGISTRYINDEX); \
+    lua_getfield(state, LUA_REGISTRYINDEX, PLUGIN_REGISTRYNAME); \
+    _bolt_plugin_set_subscribed(lua_touserdata(state, -1), PLUGIN_EVENT_##EVTYPE, is_function); \
+    lua_pop(state, 1); \
     return 0; \
 }
 
@@ -201,21 +205,21 @@ static int api_buffer_set##FNAME(lua_State* state) { \
 
 /* API definitions start here */
 
-DEFINE_CALLBACK(swapbuffers)
-DEFINE_CALLBACK(render2d)
-DEFINE_CALLBACK(render3d)
-DEFINE_CALLBACK(renderparticles)
-DEFINE_CALLBACK(renderbillboard)
-DEFINE_CALLBACK(rendericon)
-DEFINE_CALLBACK(renderbigicon)
-DEFINE_CALLBACK(minimapterrain)
-DEFINE_CALLBACK(minimaprender2d)
-DEFINE_CALLBACK(renderminimap)
-DEFINE_CALLBACK(rendergameview)
-DEFINE_CALLBACK(mousemotion)
-DEFINE_CALLBACK(mousebutton)
-DEFINE_CALLBACK(mousebuttonup)
-DEFINE_CALLBACK(scroll)
+DEFINE_CALLBACK(swapbuffers, SWAPBUFFERS)
+DEFINE_CALLBACK(render2d, RENDER2D)
+DEFINE_CALLBACK(render3d, RENDER3D)
+DEFINE_CALLBACK(renderparticles, RENDERPARTICLES)
+DEFINE_CALLBACK(renderbillboard, RENDERBILLBOARD)
+DEFINE_CALLBACK(rendericon, RENDERICON)
+DEFINE_CALLBACK(renderbigicon, RENDERBIGICON)
+DEFINE_CALLBACK(minimapterrain, MINIMAPTERRAIN)
+DEFINE_CALLBACK(minimaprender2d, MINIMAPRENDER2D)
+DEFINE_CALLBACK(renderminimap, RENDERMINIMAP)
+DEFINE_CALLBACK(rendergameview, RENDERGAMEVIEW)
+DEFINE_CALLBACK(mousemotion, MOUSEMOTION)
+DEFINE_CALLBACK(mousebutton, MOUSEBUTTON)
+DEFINE_CALLBACK(mousebuttonup, MOUSEBUTTONUP)
+DEFINE_CALLBACK(scroll, SCROLL)
 DEFINE_WINDOWEVENT(reposition, REPOSITION)
 DEFINE_WINDOWEVENT(mousemotion, MOUSEMOTION)
 DEFINE_WINDOWEVENT(mousebutton, MOUSEBUTTON)
@@ -437,6 +441,153 @@ static int api_saveconfig(lua_State* state) {
     return 1;
 }
 
+static int api_eventprofile(lua_State* state) {
+    lua_getfield(state, LUA_REGISTRYINDEX, PLUGIN_REGISTRYNAME);
+    const struct Plugin* plugin = lua_touserdata(state, -1);
+    lua_pop(state, 1);
+    lua_newtable(state);
+    for (size_t i = 0; i < PLUGIN_EVENT_COUNT; i += 1) {
+        struct PluginEventStats stats;
+        if (!_bolt_plugin_event_stats(plugin, i, &stats)) continue;
+        lua_createtable(state, 0, 6);
+        lua_pushinteger(state, stats.calls);
+        lua_setfield(state, -2, "calls");
+        lua_pushinteger(state, stats.frames);
+        lua_setfield(state, -2, "frames");
+        lua_pushnumber(state, (double)stats.total_nanos / 1000.0);
+        lua_setfield(state, -2, "total");
+        lua_pushnumber(state, (double)stats.max_call_nanos / 1000.0);
+        lua_setfield(state, -2, "maxcall");
+        lua_pushnumber(state, (double)stats.max_frame_nanos / 1000.0);
+        lua_setfield(state, -2, "maxframe");
+        lua_pushnumber(state, (double)stats.p99_frame_nanos / 1000.0);
+        lua_setfield(state, -2, "p99frame");
+        lua_setfield(state, -2, _bolt_plugin_event_name(i));
+    }
+    return 1;
+}
+
+static int api_ipcstats(lua_State* state) {
+    struct PluginIPCStats stats;
+    _bolt_plugin_ipc_stats(&stats);
+    lua_createtable(state, 0, 7);
+    lua_pushinteger(state, stats.frames);
+    lua_setfield(state, -2, "frames");
+    lua_pushinteger(state, stats.syscalls);
+    lua_setfield(state, -2, "syscalls");
+    lua_pushinteger(state, stats.bytes);
+    lua_setfield(state, -2, "bytes");
+    lua_pushinteger(state, stats.last_frame_syscalls);
+    lua_setfield(state, -2, "lastframesyscalls");
+    lua_pushinteger(state, stats.last_frame_bytes);
+    lua_setfield(state, -2, "lastframebytes");
+    lua_pushinteger(state, stats.max_frame_syscalls);
+    lua_setfield(state, -2, "maxframesyscalls");
+    lua_pushinteger(state, stats.max_frame_bytes);
+    lua_setfield(state, -2, "maxframebytes");
+    return 1;
+}
+
+static int api_textureshadowstats(lua_State* state) {
+    struct TextureShadowStats stats;
+    _bolt_plugin_managed_functions()->texture_shadow_stats(&stats);
+    lua_createtable(state, 0, 5);
+    lua_pushinteger(state, stats.bytes);
+    lua_setfield(state, -2, "bytes");
+    lua_pushinteger(state, stats.budget);
+    lua_setfield(state, -2, "budget");
+    lua_pushinteger(state, stats.evictions);
+    lua_setfield(state, -2, "evictions");
+    lua_pushinteger(state, stats.evicted_bytes);
+    lua_setfield(state, -2, "evictedbytes");
+    lua_pushinteger(state, stats.restores);
+    lua_setfield(state, -2, "restores");
+    return 1;
+}
+
+// reads an optional non-negative integer field from the table at stack index 2 into `out`
+// returns the value at the top of the stack, raising an error unless it's a number with no fractional part
+// from `min` to `max`. strings aren't converted, and out-of-range values aren't allowed to wrap around.
+static lua_Number check_filter_integer(lua_State* state, const char* field, lua_Number min, lua_Number max) {
+    const lua_Number value = lua_tonumber(state, -1);
+    if (lua_type(state, -1) != LUA_TNUMBER || value != floor(value) || value < min || value > max) {
+        lua_pushfstring(state, "setrenderfilter: '%s' must be an integer from %f to %f", field, min, max);
+        lua_error(state);
+    }
+    return value;
+}
+
+static void get_filter_integer(lua_State* state, const char* field, uint32_t* out) {
+    lua_getfield(state, 2, field);
+    if (!lua_isnil(state, -1)) *out = (uint32_t)check_filter_integer(state, field, 0, UINT32_MAX);
+    lua_pop(state, 1);
+}
+
+static int api_setrenderfilter(lua_State* state) {
+    const char* event_name = luaL_checkstring(state, 1);
+    enum PluginEventType type = PLUGIN_EVENT_COUNT;
+    for (size_t i = 0; i < PLUGIN_EVENT_COUNT; i += 1) {
+        if (!strcmp(event_name, _bolt_plugin_event_name(i))) {
+            type = i;
+            break;
+        }
+    }
+    const uint8_t is_2d = type == PLUGIN_EVENT_RENDER2D || type == PLUGIN_EVENT_MINIMAPRENDER2D;
+    if (!is_2d && type != PLUGIN_EVENT_RENDER3D && type != PLUGIN_EVENT_RENDERPARTICLES && type != PLUGIN_EVENT_RENDERBILLBOARD) {
+        lua_pushfstring(state, "setrenderfilter: '%s' is not an event type that can be filtered", event_name);
+        lua_error(state);
+    }
+    lua_getfield(state, LUA_REGISTRYINDEX, PLUGIN_REGISTRYNAME);
+    struct Plugin* plugin = lua_touserdata(state, -1);
+    lua_pop(state, 1);
+
+    struct PluginEventFilter filter = {.enabled = false, .min_vertices = 0, .max_vertices = UINT32_MAX, .texture_id_count = 0, .has_atlas = false};
+    if (lua_isnoneornil(state, 2)) {
+        _bolt_plugin_set_filter(plugin, type, &filter);
+        return 0;
+    }
+    luaL_checktype(state, 2, LUA_TTABLE);
+    filter.enabled = true;
+    get_filter_integer(state, "minvertices", &filter.min_vertices);
+    get_filter_integer(state, "maxvertices", &filter.max_vertices);
+
+    lua_getfield(state, 2, "textureids");
+    if (!lua_isnil(state, -1)) {
+        luaL_checktype(state, -1, LUA_TTABLE);
+        const size_t count = lua_objlen(state, -1);
+        if (count > PLUGIN_FILTER_MAX_TEXTURES) {
+            lua_pushfstring(state, "setrenderfilter: too many texture IDs (maximum %d)", PLUGIN_FILTER_MAX_TEXTURES);
+            lua_error(state);
+        }
+        for (size_t i = 0; i < count; i += 1) {
+            lua_rawgeti(state, -1, i + 1);
+            filter.texture_ids[i] = (size_t)check_filter_integer(state, "textureids", 0, UINT32_MAX);
+            lua_pop(state, 1);
+        }
+        filter.texture_id_count = count;
+    }
+    lua_pop(state, 1);
+
+    lua_getfield(state, 2, "atlas");
+    if (!lua_isnil(state, -1)) {
+        if (!is_2d) {
+            lua_pushfstring(state, "setrenderfilter: 'atlas' can't be used with %s events", event_name);
+            lua_error(state);
+        }
+        luaL_checktype(state, -1, LUA_TTABLE);
+        for (size_t i = 0; i < 4; i += 1) {
+            lua_rawgeti(state, -1, i + 1);
+            filter.atlas_xywh[i] = (int32_t)check_filter_integer(state, "atlas", INT32_MIN, INT32_MAX);
+            lua_pop(state, 1);
+        }
+        filter.has_atlas = true;
+    }
+    lua_pop(state, 1);
+
+    _bolt_plugin_set_filter(plugin, type, &filter);
+    return 0;
+}
+
 static int api_createsurface(lua_State* state) {
     const struct PluginManagedFunctions* managed_functions = _bolt_plugin_managed_functions();
     const lua_Integer w = luaL_checkinteger(state, 1);
@@ -591,6 +742,7 @@ static int api_createbrowser(lua_State* state) {
     browser->plugin = plugin;
     browser->do_capture = false;
     browser->capture_id = 0;
+    _bolt_plugin_capture_init(&browser->capture);
     SETMETATABLE(browser)
 
     // create an empty event table in the registry for this window
@@ -614,11 +766,10 @@ static int api_createbrowser(lua_State* state) {
         .custom_js_length = len,
     };
     const uint32_t url_length32 = (uint32_t)url_length;
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
-    _bolt_ipc_send(fd, url, url_length32);
-    if (custom_js) _bolt_ipc_send(fd, custom_js, len);
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
+    _bolt_plugin_ipc_send(url, url_length32);
+    if (custom_js) _bolt_plugin_ipc_send(custom_js, len);
 
     // add to the hashmap
     hashmap_set(plugin->external_browsers, &browser);
@@ -655,6 +806,7 @@ static int api_createembeddedbrowser(lua_State* state) {
     window->popup_shown = false;
     window->do_capture = false;
     window->capture_id = 0;
+    _bolt_plugin_capture_init(&window->capture);
     window->popup_initialised = false;
     window->popup_meta.x = 0;
     window->popup_meta.y = 0;
@@ -699,11 +851,10 @@ static int api_createembeddedbrowser(lua_State* state) {
         .custom_js_length = custom_js_len,
     };
     const uint32_t url_length32 = (uint32_t)url_length;
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
-    _bolt_ipc_send(fd, url, url_length32);
-    if (custom_js) _bolt_ipc_send(fd, custom_js, custom_js_len);
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
+    _bolt_plugin_ipc_send(url, url_length32);
+    if (custom_js) _bolt_plugin_ipc_send(custom_js, custom_js_len);
 
     // set this window in the hashmap, which is accessible by backends
     struct WindowInfo* windows = _bolt_plugin_windowinfo();
@@ -799,12 +950,101 @@ static int api_createshaderbuffer(lua_State* state) {
     return 1;
 }
 
+// number of vertices fetched per call when building the result of a batch vertex function
+#define VERTEXBATCHSIZE 256
+
+// reads the optional 1-based `first` and `count` arguments of a batch vertex function, defaulting to all vertices
+// from `first` onwards, and raises an error if the range doesn't fit in `vertex_count`
+static void get_vertex_range(lua_State* state, const char* apiname, uint32_t vertex_count, size_t* first, size_t* count) {
+    const lua_Integer f = luaL_optinteger(state, 2, 1);
+    const lua_Integer n = luaL_optinteger(state, 3, (lua_Integer)vertex_count - (f - 1));
+    if (f < 1 || n < 0 || (f - 1) + n > (lua_Integer)vertex_count) {
+        lua_pushfstring(state, "%s: vertex range out of bounds (first %d, count %d, vertex count %d)", apiname, (int)f, (int)n, (int)vertex_count);
+        lua_error(state);
+    }
+    *first = f - 1;
+    *count = n;
+}
+
+// defines a function which fetches a range of vertices through the event's batch function FUNC,
+// and returns them as a flat array of SIZE values per vertex, pushed with PUSH
+#define DEFVERTEXBATCHAPI(OBJECT, APINAME, STRUCT, COUNTFIELD, FUNC, TYPE, SIZE, PUSH) \
+static int api_##OBJECT##_##APINAME(lua_State* state) { \
+    const struct STRUCT* render = require_self_userdata(state, #APINAME); \
+    size_t first, count; \
+    get_vertex_range(state, #APINAME, render->COUNTFIELD, &first, &count); \
+    lua_createtable(state, count * SIZE, 0); \
+    TYPE values[VERTEXBATCHSIZE * SIZE]; \
+    for (size_t done = 0; done < count; done += VERTEXBATCHSIZE) { \
+        const size_t n = (count - done) < VERTEXBATCHSIZE ? (count - done) : VERTEXBATCHSIZE; \
+        render->vertex_functions.FUNC(first + done, n, render->vertex_functions.userdata, values); \
+        for (size_t i = 0; i < n * SIZE; i += 1) { \
+            PUSH(state, values[i]); \
+            lua_rawseti(state, -2, (done * SIZE) + i + 1); \
+        } \
+    } \
+    return 1; \
+}
+
 static int api_batch2d_vertexcount(lua_State* state) {
     const struct RenderBatch2D* batch = require_self_userdata(state, "vertexcount");
     lua_pushinteger(state, batch->index_count);
     return 1;
 }
 
+DEFVERTEXBATCHAPI(batch2d, vertexxys, RenderBatch2D, index_count, xy_batch, int32_t, 2, lua_pushinteger)
+DEFVERTEXBATCHAPI(batch2d, vertexcolours, RenderBatch2D, index_count, colour_batch, double, 4, lua_pushnumber)
+
+static int api_batch2d_vertexatlases(lua_State* state) {
+    const struct RenderBatch2D* batch = require_self_userdata(state, "vertexatlases");
+    size_t first, count;
+    get_vertex_range(state, "vertexatlases", batch->index_count, &first, &count);
+    lua_createtable(state, count * 4, 0);
+    lua_createtable(state, count, 0);
+    lua_createtable(state, count, 0);
+    int32_t xywh[VERTEXBATCHSIZE * 4];
+    uint8_t wrapx[VERTEXBATCHSIZE];
+    uint8_t wrapy[VERTEXBATCHSIZE];
+    for (size_t done = 0; done < count; done += VERTEXBATCHSIZE) {
+        const size_t n = (count - done) < VERTEXBATCHSIZE ? (count - done) : VERTEXBATCHSIZE;
+        batch->vertex_functions.atlas_details_batch(first + done, n, batch->vertex_functions.userdata, xywh, wrapx, wrapy);
+        for (size_t i = 0; i < n * 4; i += 1) {
+            lua_pushinteger(state, xywh[i]);
+            lua_rawseti(state, -4, (done * 4) + i + 1);
+        }
+        for (size_t i = 0; i < n; i += 1) {
+            lua_pushboolean(state, wrapx[i]);
+            lua_rawseti(state, -3, done + i + 1);
+            lua_pushboolean(state, wrapy[i]);
+            lua_rawseti(state, -2, done + i + 1);
+        }
+    }
+    return 3;
+}
+
+static int api_batch2d_vertexuvs(lua_State* state) {
+    const struct RenderBatch2D* batch = require_self_userdata(state, "vertexuvs");
+    size_t first, count;
+    get_vertex_range(state, "vertexuvs", batch->index_count, &first, &count);
+    lua_createtable(state, count * 2, 0);
+    lua_createtable(state, count, 0);
+    double uvs[VERTEXBATCHSIZE * 2];
+    uint8_t discard[VERTEXBATCHSIZE];
+    for (size_t done = 0; done < count; done += VERTEXBATCHSIZE) {
+        const size_t n = (count - done) < VERTEXBATCHSIZE ? (count - done) : VERTEXBATCHSIZE;
+        batch->vertex_functions.uv_batch(first + done, n, batch->vertex_functions.userdata, uvs, discard);
+        for (size_t i = 0; i < n * 2; i += 1) {
+            lua_pushnumber(state, uvs[i]);
+            lua_rawseti(state, -3, (done * 2) + i + 1);
+        }
+        for (size_t i = 0; i < n; i += 1) {
+            lua_pushboolean(state, discard[i]);
+            lua_rawseti(state, -2, done + i + 1);
+        }
+    }
+    return 2;
+}
+
 static int api_batch2d_verticesperimage(lua_State* state) {
     const struct RenderBatch2D* batch = require_self_userdata(state, "verticesperimage");
     lua_pushinteger(state, batch->vertices_per_icon);
@@ -878,6 +1118,12 @@ static int api_batch2d_textureid(lua_State* state) {
     return 1;
 }
 
+static int api_batch2d_texturegeneration(lua_State* state) {
+    const struct RenderBatch2D* render = require_self_userdata(state, "texturegeneration");
+    lua_pushnumber(state, (double)render->texture_functions.generation(render->texture_functions.userdata));
+    return 1;
+}
+
 static int api_batch2d_texturesize(lua_State* state) {
     const struct RenderBatch2D* render = require_self_userdata(state, "texturesize");
     size_t size[2];
@@ -904,7 +1150,7 @@ static int api_batch2d_texturedata(lua_State* state) {
     const size_t x = luaL_checkinteger(state, 2);
     const size_t y = luaL_checkinteger(state, 3);
     const size_t len = luaL_checkinteger(state, 4);
-    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y);
+    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y, len);
     lua_pushlstring(state, (const char*)ret, len);
     return 1;
 }
@@ -1282,6 +1528,11 @@ static int api_render3d_vertexcount(lua_State* state) {
     return 1;
 }
 
+DEFVERTEXBATCHAPI(render3d, vertexpoints, Render3D, vertex_count, xyz_batch, double, 3, lua_pushnumber)
+DEFVERTEXBATCHAPI(render3d, vertexuvs, Render3D, vertex_count, uv_batch, double, 2, lua_pushnumber)
+DEFVERTEXBATCHAPI(render3d, vertexcolours, Render3D, vertex_count, colour_batch, double, 4, lua_pushnumber)
+DEFVERTEXBATCHAPI(render3d, vertexboneids, Render3D, vertex_count, bone_id_batch, uint8_t, 1, lua_pushinteger)
+
 static int api_render3d_vertexpoint(lua_State* state) {
     const struct Render3D* render = require_self_userdata(state, "vertexpoint");
     const lua_Integer index = lua_tointeger(state, 2);
@@ -1380,6 +1631,12 @@ static int api_render3d_textureid(lua_State* state) {
     return 1;
 }
 
+static int api_render3d_texturegeneration(lua_State* state) {
+    const struct Render3D* render = require_self_userdata(state, "texturegeneration");
+    lua_pushnumber(state, (double)render->texture_functions.generation(render->texture_functions.userdata));
+    return 1;
+}
+
 static int api_render3d_texturesize(lua_State* state) {
     const struct Render3D* render = require_self_userdata(state, "texturesize");
     size_t size[2];
@@ -1406,7 +1663,7 @@ static int api_render3d_texturedata(lua_State* state) {
     const size_t x = luaL_checkinteger(state, 2);
     const size_t y = luaL_checkinteger(state, 3);
     const size_t len = luaL_checkinteger(state, 4);
-    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y);
+    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y, len);
     lua_pushlstring(state, (const char*)ret, len);
     return 1;
 }
@@ -1432,6 +1689,12 @@ static int api_render3d_animated(lua_State* state) {
     return 1;
 }
 
+static int api_render3d_modelhash(lua_State* state) {
+    const struct Render3D* render = require_self_userdata(state, "modelhash");
+    lua_pushnumber(state, (double)render->vertex_functions.model_hash(render->vertex_functions.userdata));
+    return 1;
+}
+
 static int api_render3d_cameraposition(lua_State* state) {
     const struct Render3D* render = require_self_userdata(state, "cameraposition");
     double out[3];
@@ -1448,6 +1711,10 @@ static int api_renderparticles_vertexcount(lua_State* state) {
     return 1;
 }
 
+DEFVERTEXBATCHAPI(renderparticles, vertexparticleorigins, RenderParticles, vertex_count, xyz_batch, double, 3, lua_pushnumber)
+DEFVERTEXBATCHAPI(renderparticles, vertexuvs, RenderParticles, vertex_count, uv_batch, double, 2, lua_pushnumber)
+DEFVERTEXBATCHAPI(renderparticles, vertexcolours, RenderParticles, vertex_count, colour_batch, double, 4, lua_pushnumber)
+
 static int api_renderparticles_vertexparticleorigin(lua_State* state) {
     const struct RenderParticles* render = require_self_userdata(state, "vertexparticleorigin");
     const lua_Integer vertex = luaL_checkinteger(state, 2);
@@ -1527,6 +1794,12 @@ static int api_renderparticles_textureid(lua_State* state) {
     return 1;
 }
 
+static int api_renderparticles_texturegeneration(lua_State* state) {
+    const struct RenderParticles* render = require_self_userdata(state, "texturegeneration");
+    lua_pushnumber(state, (double)render->texture_functions.generation(render->texture_functions.userdata));
+    return 1;
+}
+
 static int api_renderparticles_texturesize(lua_State* state) {
     const struct RenderParticles* render = require_self_userdata(state, "texturesize");
     size_t size[2];
@@ -1553,7 +1826,7 @@ static int api_renderparticles_texturedata(lua_State* state) {
     const size_t x = luaL_checkinteger(state, 2);
     const size_t y = luaL_checkinteger(state, 3);
     const size_t len = luaL_checkinteger(state, 4);
-    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y);
+    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y, len);
     lua_pushlstring(state, (const char*)ret, len);
     return 1;
 }
@@ -1606,6 +1879,10 @@ static int api_renderbillboard_vertexcount(lua_State* state) {
     return 1;
 }
 
+DEFVERTEXBATCHAPI(renderbillboard, vertexpoints, RenderBillboard, vertex_count, xyz_batch, double, 3, lua_pushnumber)
+DEFVERTEXBATCHAPI(renderbillboard, vertexuvs, RenderBillboard, vertex_count, uv_batch, double, 2, lua_pushnumber)
+DEFVERTEXBATCHAPI(renderbillboard, vertexcolours, RenderBillboard, vertex_count, colour_batch, double, 4, lua_pushnumber)
+
 static int api_renderbillboard_verticesperimage(lua_State* state) {
     const struct RenderBillboard* render = require_self_userdata(state, "verticesperimage");
     lua_pushinteger(state, render->vertices_per_icon);
@@ -1668,6 +1945,12 @@ static int api_renderbillboard_textureid(lua_State* state) {
     return 1;
 }
 
+static int api_renderbillboard_texturegeneration(lua_State* state) {
+    const struct RenderBillboard* render = require_self_userdata(state, "texturegeneration");
+    lua_pushnumber(state, (double)render->texture_functions.generation(render->texture_functions.userdata));
+    return 1;
+}
+
 static int api_renderbillboard_texturesize(lua_State* state) {
     const struct RenderBillboard* render = require_self_userdata(state, "texturesize");
     size_t size[2];
@@ -1694,7 +1977,7 @@ static int api_renderbillboard_texturedata(lua_State* state) {
     const size_t x = luaL_checkinteger(state, 2);
     const size_t y = luaL_checkinteger(state, 3);
     const size_t len = luaL_checkinteger(state, 4);
-    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y);
+    const uint8_t* ret = render->texture_functions.data(render->texture_functions.userdata, x, y, len);
     lua_pushlstring(state, (const char*)ret, len);
     return 1;
 }
@@ -1933,15 +2216,15 @@ static int api_scroll_direction(lua_State* state) {
 }
 
 static int api_browser_close(lua_State* state) {
-    const struct ExternalBrowser* browser = require_self_userdata(state, "close");
-    if (browser->do_capture) browser->plugin->ext_browser_capture_count += 1;
+    struct ExternalBrowser* browser = require_self_userdata(state, "close");
+    if (browser->do_capture) browser->plugin->ext_browser_capture_count -= 1;
+    _bolt_plugin_capture_release(&browser->capture);
     hashmap_delete(browser->plugin->external_browsers, &browser);
 
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_CLOSEBROWSER_EXTERNAL;
     const struct BoltIPCCloseBrowserHeader header = { .plugin_id = browser->plugin_id, .window_id = browser->id };
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
 
     return 0;
 }
@@ -1958,15 +2241,82 @@ static int api_browser_sendmessage(lua_State* state) {
 
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_PLUGINMESSAGE;
     const struct BoltIPCPluginMessageHeader header = { .plugin_id = id, .window_id = window->id, .message_size = len };
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
-    _bolt_ipc_send(fd, str, len);
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
+    _bolt_plugin_ipc_send(str, len);
     return 0;
 }
 
+// reads an optional table of capture settings from stack index 2 into `request`, leaving any missing fields
+// at their defaults (the whole window, unscaled, in RGB format). the settings are parsed into a local and
+// only copied to `request` once all of them are valid, so a bad table leaves the previous settings intact.
+static void get_capture_request(lua_State* state, struct CaptureRequest* request) {
+    struct CaptureRequest parsed = {
+        .x = 0,
+        .y = 0,
+        .width = 0,
+        .height = 0,
+        .scale = 1.0,
+        .format = IPC_CAPTURE_RGB,
+        .interval_micros = CAPTURE_DEFAULT_INTERVAL_MICROS,
+    };
+    if (lua_gettop(state) >= 2 && !lua_isnil(state, 2)) {
+        luaL_checktype(state, 2, LUA_TTABLE);
+
+        lua_getfield(state, 2, "x");
+        if (!lua_isnil(state, -1)) parsed.x = (int16_t)luaL_checkinteger(state, -1);
+        lua_pop(state, 1);
+        lua_getfield(state, 2, "y");
+        if (!lua_isnil(state, -1)) parsed.y = (int16_t)luaL_checkinteger(state, -1);
+        lua_pop(state, 1);
+        lua_getfield(state, 2, "width");
+        if (!lua_isnil(state, -1)) parsed.width = (uint16_t)luaL_checkinteger(state, -1);
+        lua_pop(state, 1);
+        lua_getfield(state, 2, "height");
+        if (!lua_isnil(state, -1)) parsed.height = (uint16_t)luaL_checkinteger(state, -1);
+        lua_pop(state, 1);
+
+        lua_getfield(state, 2, "scale");
+        if (!lua_isnil(state, -1)) parsed.scale = luaL_checknumber(state, -1);
+        lua_pop(state, 1);
+        if (!(parsed.scale > 0.0 && parsed.scale <= 1.0)) {
+            lua_pushliteral(state, "enablecapture: 'scale' must be greater than 0 and no more than 1");
+            lua_error(state);
+        }
+
+        lua_getfield(state, 2, "format");
+        if (!lua_isnil(state, -1)) {
+            const char* format = luaL_checkstring(state, -1);
+            if (!strcmp(format, "rgb")) {
+                parsed.format = IPC_CAPTURE_RGB;
+            } else if (!strcmp(format, "rgba")) {
+                parsed.format = IPC_CAPTURE_RGBA;
+            } else if (!strcmp(format, "red")) {
+                parsed.format = IPC_CAPTURE_RED;
+            } else {
+                // the format string is still on the stack here, so it stays valid until lua_error
+                lua_pushfstring(state, "enablecapture: unknown format '%s'", format);
+                lua_error(state);
+            }
+        }
+        lua_pop(state, 1);
+
+        lua_getfield(state, 2, "interval");
+        lua_Integer interval = CAPTURE_DEFAULT_INTERVAL_MICROS / 1000;
+        if (!lua_isnil(state, -1)) interval = luaL_checkinteger(state, -1);
+        lua_pop(state, 1);
+        if (interval < 0 || interval > CAPTURE_MAX_INTERVAL_MICROS / 1000) {
+            lua_pushfstring(state, "enablecapture: 'interval' must be between 0 and %d", (int)(CAPTURE_MAX_INTERVAL_MICROS / 1000));
+            lua_error(state);
+        }
+        parsed.interval_micros = (uint32_t)interval * 1000;
+    }
+    *request = parsed;
+}
+
 static int api_browser_enablecapture(lua_State* state) {
     struct ExternalBrowser* window = require_self_userdata(state, "enablecapture");
+    get_capture_request(state, &window->capture.request);
     if (!window->do_capture) {
         window->plugin->ext_browser_capture_count += 1;
         window->do_capture = true;
@@ -1979,6 +2329,7 @@ static int api_browser_disablecapture(lua_State* state) {
     struct ExternalBrowser* window = require_self_userdata(state, "disablecapture");
     if (window->do_capture) window->plugin->ext_browser_capture_count -= 1;
     window->do_capture = false;
+    _bolt_plugin_capture_release(&window->capture);
     return 0;
 }
 
@@ -1986,9 +2337,8 @@ static int api_browser_showdevtools(lua_State* state) {
     struct ExternalBrowser* window = require_self_userdata(state, "showdevtools");
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_SHOWDEVTOOLS_EXTERNAL;
     const struct BoltIPCShowDevtoolsHeader header = { .plugin_id = window->plugin_id, .window_id = window->id };
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
     return 0;
 }
 
@@ -1998,9 +2348,8 @@ static int api_embeddedbrowser_close(lua_State* state) {
 
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_CLOSEBROWSER_OSR;
     const struct BoltIPCCloseBrowserHeader header = { .plugin_id = window->plugin_id, .window_id = window->id };
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
 
     return 0;
 }
@@ -2017,15 +2366,15 @@ static int api_embeddedbrowser_sendmessage(lua_State* state) {
 
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_OSRPLUGINMESSAGE;
     const struct BoltIPCPluginMessageHeader header = { .plugin_id = id, .window_id = window->id, .message_size = len };
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
-    _bolt_ipc_send(fd, str, len);
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
+    _bolt_plugin_ipc_send(str, len);
     return 0;
 }
 
 static int api_embeddedbrowser_enablecapture(lua_State* state) {
     struct EmbeddedWindow* window = require_self_userdata(state, "enablecapture");
+    get_capture_request(state, &window->capture.request);
     if (!window->do_capture) {
         window->do_capture = true;
         window->capture_ready = true;
@@ -2037,6 +2386,7 @@ static int api_embeddedbrowser_disablecapture(lua_State* state) {
     struct EmbeddedWindow* window = require_self_userdata(state, "disablecapture");
     if (window->do_capture) {
         window->do_capture = false;
+        _bolt_plugin_capture_release(&window->capture);
     }
     return 0;
 }
@@ -2045,9 +2395,8 @@ static int api_embeddedbrowser_showdevtools(lua_State* state) {
     struct EmbeddedWindow* window = require_self_userdata(state, "showdevtools");
     const enum BoltIPCMessageTypeToHost msg_type = IPC_MSG_SHOWDEVTOOLS_OSR;
     const struct BoltIPCShowDevtoolsHeader header = { .plugin_id = window->plugin_id, .window_id = window->id };
-    const BoltSocketType fd = _bolt_plugin_fd();
-    _bolt_ipc_send(fd, &msg_type, sizeof(msg_type));
-    _bolt_ipc_send(fd, &header, sizeof(header));
+    _bolt_plugin_ipc_send(&msg_type, sizeof(msg_type));
+    _bolt_plugin_ipc_send(&header, sizeof(header));
     return 0;
 }
 
@@ -2281,6 +2630,10 @@ static struct ApiFuncTemplate bolt_functions[] = {
     BOLTFUNC(loadfile),
     BOLTFUNC(loadconfig),
     BOLTFUNC(saveconfig),
+    BOLTFUNC(eventprofile),
+    BOLTFUNC(ipcstats),
+    BOLTFUNC(textureshadowstats),
+    BOLTFUNC(setrenderfilter),
 
     BOLTFUNC(onrender2d),
     BOLTFUNC(onrender3d),
@@ -2332,19 +2685,29 @@ static struct ApiFuncTemplate render2d_functions[] = {
     BOLTFUNC(verticesperimage, batch2d),
     BOLTFUNC(targetsize, batch2d),
     BOLTFUNC(vertexxy, batch2d),
+    BOLTFUNC(vertexxys, batch2d),
+    BOLTFUNC(vertexcolours, batch2d),
     BOLTFUNC(vertexatlasdetails, batch2d),
+    BOLTFUNC(vertexatlases, batch2d),
     BOLTFUNC(vertexuv, batch2d),
+    BOLTFUNC(vertexuvs, batch2d),
     BOLTFUNC(vertexcolour, batch2d),
     BOLTFUNC(textureid, batch2d),
     BOLTFUNC(texturesize, batch2d),
+    BOLTFUNC(texturegeneration, batch2d),
     BOLTFUNC(texturecompare, batch2d),
     BOLTFUNC(texturedata, batch2d),
     BOLTALIAS(vertexcolour, vertexcolor, batch2d),
+    BOLTALIAS(vertexcolours, vertexcolors, batch2d),
 };
 
 static struct ApiFuncTemplate render3d_functions[] = {
     BOLTFUNC(vertexcount, render3d),
     BOLTFUNC(vertexpoint, render3d),
+    BOLTFUNC(vertexpoints, render3d),
+    BOLTFUNC(vertexuvs, render3d),
+    BOLTFUNC(vertexcolours, render3d),
+    BOLTFUNC(vertexboneids, render3d),
     BOLTFUNC(modelmatrix, render3d),
     BOLTFUNC(viewmatrix, render3d),
     BOLTFUNC(projmatrix, render3d),
@@ -2356,18 +2719,24 @@ static struct ApiFuncTemplate render3d_functions[] = {
     BOLTFUNC(vertexcolour, render3d),
     BOLTFUNC(textureid, render3d),
     BOLTFUNC(texturesize, render3d),
+    BOLTFUNC(texturegeneration, render3d),
     BOLTFUNC(texturecompare, render3d),
     BOLTFUNC(texturedata, render3d),
     BOLTFUNC(vertexanimation, render3d),
     BOLTFUNC(animated, render3d),
+    BOLTFUNC(modelhash, render3d),
     BOLTFUNC(cameraposition, render3d),
     BOLTALIAS(vertexcolour, vertexcolor, render3d),
+    BOLTALIAS(vertexcolours, vertexcolors, render3d),
     BOLTALIAS(projmatrix, projectionmatrix, render3d),
 };
 
 static struct ApiFuncTemplate renderparticles_functions[] = {
     BOLTFUNC(vertexcount, renderparticles),
     BOLTFUNC(vertexparticleorigin, renderparticles),
+    BOLTFUNC(vertexparticleorigins, renderparticles),
+    BOLTFUNC(vertexuvs, renderparticles),
+    BOLTFUNC(vertexcolours, renderparticles),
     BOLTFUNC(vertexworldoffset, renderparticles),
     BOLTFUNC(vertexeyeoffset, renderparticles),
     BOLTFUNC(vertexuv, renderparticles),
@@ -2376,6 +2745,7 @@ static struct ApiFuncTemplate renderparticles_functions[] = {
     BOLTFUNC(atlasxywh, renderparticles),
     BOLTFUNC(textureid, renderparticles),
     BOLTFUNC(texturesize, renderparticles),
+    BOLTFUNC(texturegeneration, renderparticles),
     BOLTFUNC(texturecompare, renderparticles),
     BOLTFUNC(texturedata, renderparticles),
     BOLTFUNC(viewmatrix, renderparticles),
@@ -2384,6 +2754,7 @@ static struct ApiFuncTemplate renderparticles_functions[] = {
     BOLTFUNC(inverseviewmatrix, renderparticles),
     BOLTFUNC(cameraposition, renderparticles),
     BOLTALIAS(vertexcolour, vertexcolor, renderparticles),
+    BOLTALIAS(vertexcolours, vertexcolors, renderparticles),
     BOLTALIAS(projmatrix, projectionmatrix, renderparticles),
 };
 
@@ -2391,6 +2762,9 @@ static struct ApiFuncTemplate renderbillboard_functions[] = {
     BOLTFUNC(vertexcount, renderbillboard),
     BOLTFUNC(verticesperimage, renderbillboard),
     BOLTFUNC(vertexpoint, renderbillboard),
+    BOLTFUNC(vertexpoints, renderbillboard),
+    BOLTFUNC(vertexuvs, renderbillboard),
+    BOLTFUNC(vertexcolours, renderbillboard),
     BOLTFUNC(vertexeyeoffset, renderbillboard),
     BOLTFUNC(vertexuv, renderbillboard),
     BOLTFUNC(vertexcolour, renderbillboard),
@@ -2398,6 +2772,7 @@ static struct ApiFuncTemplate renderbillboard_functions[] = {
     BOLTFUNC(atlasxywh, renderbillboard),
     BOLTFUNC(textureid, renderbillboard),
     BOLTFUNC(texturesize, renderbillboard),
+    BOLTFUNC(texturegeneration, renderbillboard),
     BOLTFUNC(texturecompare, renderbillboard),
     BOLTFUNC(texturedata, renderbillboard),
     BOLTFUNC(modelmatrix, renderbillboard),
@@ -2407,6 +2782,7 @@ static struct ApiFuncTemplate renderbillboard_functions[] = {
     BOLTFUNC(inverseviewmatrix, renderbillboard),
     BOLTFUNC(cameraposition, renderbillboard),
     BOLTALIAS(vertexcolour, vertexcolor, renderbillboard),
+    BOLTALIAS(vertexcolours, vertexcolors, renderbillboard),
     BOLTALIAS(projmatrix, projectionmatrix, renderbillboard),
 };
 
@@ -1,9 +1,11 @@
+#include "plugin.h"
 #include <lua.h>
 #include <stdint.h>
 
 #define PLUGIN_REGISTRYNAME "plugin"
 #define WINDOWS_REGISTRYNAME "windows"
 #define BROWSERS_REGISTRYNAME "browsers"
+#define EXPIREDEVENT_REGISTRYNAME "expiredevent"
 
 #define WINDOW_MIN_SIZE 60
 
@@ -38,6 +40,7 @@ struct ExternalBrowser {
     uint8_t do_capture;
     uint8_t capture_ready;
     uint64_t capture_id;
+    struct CaptureTarget capture;
 };
 
 void _bolt_api_push_bolt_table(lua_State*);
@@ -0,0 +1,547 @@
+// unit tests and micro-benchmarks for gl.c. gl.c is included directly rather than linked, so that its static
+// functions can be called. the plugin and OS functions it depends on are stubbed out in stubs.c.
+// run with the name of a test to run only that test, or with no arguments to run all of them.
+#include "../gl.c"
+#include "stubs.h"
+
+// xorshift64, so that failures are reproducible
+static uint64_t test_rng_state = 0x9E3779B97F4A7C15ull;
+static uint64_t test_rand() {
+    test_rng_state ^= test_rng_state << 13;
+    test_rng_state ^= test_rng_state >> 7;
+    test_rng_state ^= test_rng_state << 17;
+    return test_rng_state;
+}
+
+static void test_rand_bytes(uint8_t* out, size_t len) {
+    for (size_t i = 0; i < len; i += 1) out[i] = (uint8_t)test_rand();
+}
+
+static uint64_t test_now_nanos() {
+    uint64_t t = 0;
+    _bolt_monotonic_nanoseconds(&t);
+    return t;
+}
+
+/* s3tc */
+
+// compares dxt_decode_block_sse2 with dxt_decode_block_scalar on random blocks of every format, including
+// blocks with c0 <= c1 and alpha0 <= alpha1, which use the alternate palettes
+static int test_s3tc() {
+#if defined(BOLT_SSE2)
+    const enum DXTAlphaMode modes[] = {DXT_ALPHA_NONE, DXT_ALPHA_PUNCHTHROUGH, DXT_ALPHA_EXPLICIT, DXT_ALPHA_INTERPOLATED};
+    void (*const unpackers[])(uint16_t, uint8_t*) = {unpack_rgb565, unpack_srgb565};
+    const size_t block_count = 100000;
+    int failures = 0;
+    for (size_t m = 0; m < sizeof(modes) / sizeof(*modes); m += 1) {
+        for (size_t u = 0; u < sizeof(unpackers) / sizeof(*unpackers); u += 1) {
+            for (size_t i = 0; i < block_count; i += 1) {
+                uint8_t block[16];
+                uint8_t expected[64];
+                uint8_t actual[64];
+                test_rand_bytes(block, sizeof(block));
+                // make every other block use the alternate palettes
+                if (i & 1) {
+                    uint8_t* cptr = (modes[m] == DXT_ALPHA_EXPLICIT || modes[m] == DXT_ALPHA_INTERPOLATED) ? (block + 8) : block;
+                    if ((cptr[0] + (cptr[1] << 8)) > (cptr[2] + (cptr[3] << 8))) {
+                        uint8_t tmp[2] = {cptr[0], cptr[1]};
+                        cptr[0] = cptr[2]; cptr[1] = cptr[3];
+                        cptr[2] = tmp[0]; cptr[3] = tmp[1];
+                    }
+                    if (block[0] > block[1]) {
+                        const uint8_t tmp = block[0];
+                        block[0] = block[1];
+                        block[1] = tmp;
+                    }
+                }
+                dxt_decode_block_scalar(block, modes[m], unpackers[u], expected);
+                dxt_decode_block_sse2(block, modes[m], unpackers[u], actual);
+                if (memcmp(expected, actual, sizeof(expected))) {
+                    if (failures < 10) printf("s3tc: mismatch for mode %u, block %zu\n", (unsigned int)modes[m], i);
+                    failures += 1;
+                }
+            }
+        }
+    }
+
+    uint8_t* blocks = malloc(block_count * 16);
+    uint8_t pixels[64];
+    uint64_t checksum = 0;
+    test_rand_bytes(blocks, block_count * 16);
+    const uint64_t scalar_start = test_now_nanos();
+    for (size_t i = 0; i < block_count; i += 1) {
+        dxt_decode_block_scalar(blocks + (i * 16), DXT_ALPHA_INTERPOLATED, unpack_rgb565, pixels);
+        checksum += pixels[i & 63];
+    }
+    const uint64_t sse2_start = test_now_nanos();
+    for (size_t i = 0; i < block_count; i += 1) {
+        dxt_decode_block_sse2(blocks + (i * 16), DXT_ALPHA_INTERPOLATED, unpack_rgb565, pixels);
+        checksum -= pixels[i & 63];
+    }
+    const uint64_t end = test_now_nanos();
+    free(blocks);
+    printf("s3tc: DXT5 block decode: scalar %.1fns, sse2 %.1fns (checksum %llu)\n",
+        (double)(sse2_start - scalar_start) / block_count, (double)(end - sse2_start) / block_count, (unsigned long long)checksum);
+    return failures ? 1 : 0;
+#else
+    printf("s3tc: skipped, no SSE2 path on this target\n");
+    return 0;
+#endif
+}
+
+/* s3tc eviction */
+
+// evicts the shadow of a texture which only ever had S3TC uploads, and checks that restoring it rebuilds it
+// from the retained blocks, with the blocks that were never uploaded still left as zeros
+static int test_s3tc_eviction() {
+    const GLsizei size = 64;
+    const size_t shadow_size = (size_t)size * size * 4;
+    const GLint blocks_x = size / 4;
+    const GLint blocks = blocks_x * blocks_x;
+    struct TextureShadows shadows = {0};
+    struct GLContext c = {0};
+    struct GLTexture2D a = {0};
+    struct GLTexture2D b = {0};
+    int failures = 0;
+    _bolt_rwlock_init(&shadows.rwlock);
+    c.texture_shadows = &shadows;
+    texture_shadow_alloc(&c, &a, size, size);
+    texture_shadow_alloc(&c, &b, size, size);
+
+    // upload everything except the last row of blocks, the same way glCompressedTexSubImage2D would
+    a.compressed = malloc((size_t)blocks * 8);
+    a.compressed_state = calloc(blocks, sizeof(*a.compressed_state));
+    a.compressed_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    test_rand_bytes(a.compressed, (size_t)blocks * 8);
+    for (GLint i = 0; i < blocks - blocks_x; i += 1) {
+        a.compressed_state[i] = COMPRESSED_BLOCK_PENDING;
+        a.compressed_pending += 1;
+    }
+    texture_shadow_lock(&c);
+    texture_shadow_touch(&c, &a, false);
+    texture_decode_region(&a, 0, 0, size, size, false);
+    uint8_t* expected = malloc(shadow_size);
+    memcpy(expected, a.data, shadow_size);
+    texture_shadow_unlock(&c);
+    if (!a.compressed) {
+        printf("s3tc_eviction: blocks of an unpinned texture were freed after decoding\n");
+        failures += 1;
+    }
+
+    // with room for only one shadow, touching `b` evicts `a`
+    shadows.budget = shadow_size;
+    texture_shadow_lock(&c);
+    texture_shadow_touch(&c, &b, false);
+    texture_shadow_unlock(&c);
+    if (!a.is_shadow_evicted || a.data || !b.data) {
+        printf("s3tc_eviction: shadow was not evicted\n");
+        failures += 1;
+    }
+
+    texture_shadow_lock(&c);
+    if (!texture_shadow_touch(&c, &a, true)) {
+        printf("s3tc_eviction: shadow was not restored\n");
+        failures += 1;
+    } else {
+        if (a.compressed_pending != (size_t)(blocks - blocks_x)) {
+            printf("s3tc_eviction: %zu blocks pending after restore, expected %i\n", a.compressed_pending, blocks - blocks_x);
+            failures += 1;
+        }
+        texture_decode_region(&a, 0, 0, size, size, false);
+        if (memcmp(expected, a.data, shadow_size)) {
+            printf("s3tc_eviction: restored shadow differs from the original\n");
+            failures += 1;
+        }
+    }
+    texture_shadow_unlock(&c);
+
+    free(expected);
+    texture_shadow_free(&c, &a);
+    texture_shadow_free(&c, &b);
+    _bolt_rwlock_destroy(&shadows.rwlock);
+    return failures ? 1 : 0;
+}
+
+/* attribute decoders */
+
+// the per-vertex type switch which attr_resolve_decoders replaced, kept as the reference for the resolved decoders.
+// returns false for unsupported combinations.
+static uint8_t reference_attr_decode(uint32_t type, uint8_t normalise, const uint8_t* ptr, size_t num_out, float* out) {
+    if (!normalise) {
+        switch (type) {
+            case GL_FLOAT: memcpy(out, ptr, num_out * sizeof(float)); return true;
+            case GL_HALF_FLOAT: for (size_t i = 0; i < num_out; i += 1) out[i] = f16_to_f32(*(uint16_t*)(ptr + (i * 2))); return true;
+            case GL_UNSIGNED_BYTE: for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint8_t*)(ptr + i); return true;
+            case GL_UNSIGNED_SHORT: for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint16_t*)(ptr + (i * 2)); return true;
+            case GL_UNSIGNED_INT: for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint32_t*)(ptr + (i * 4)); return true;
+            case GL_BYTE: for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int8_t*)(ptr + i); return true;
+            case GL_SHORT: for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int16_t*)(ptr + (i * 2)); return true;
+            case GL_INT: for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int32_t*)(ptr + (i * 4)); return true;
+        }
+    } else {
+        switch (type) {
+            case GL_FLOAT: memcpy(out, ptr, num_out * sizeof(float)); return true;
+            case GL_UNSIGNED_BYTE: for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint8_t*)(ptr + i)) / 255.0; return true;
+            case GL_UNSIGNED_SHORT: for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint16_t*)(ptr + (i * 2))) / 65535.0; return true;
+            case GL_UNSIGNED_INT: for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint32_t*)(ptr + (i * 4))) / 4294967295.0; return true;
+            case GL_BYTE: for (size_t i = 0; i < num_out; i += 1) out[i] = ((((float)*(int8_t*)(ptr + i)) + 128.0) * 2.0 / 255.0) - 1.0; return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t reference_attr_decode_int(uint32_t type, uint8_t normalise, const uint8_t* ptr, size_t num_out, int32_t* out) {
+    if (normalise) return false;
+    switch (type) {
+        case GL_UNSIGNED_BYTE: for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(uint8_t*)(ptr + i); return true;
+        case GL_UNSIGNED_SHORT: for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(uint16_t*)(ptr + (i * 2)); return true;
+        case GL_UNSIGNED_INT: for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(uint32_t*)(ptr + (i * 4)); return true;
+        case GL_BYTE: for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(int8_t*)(ptr + i); return true;
+        case GL_SHORT: for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(int16_t*)(ptr + (i * 2)); return true;
+        case GL_INT: for (size_t i = 0; i < num_out; i += 1) out[i] = (int32_t)*(int32_t*)(ptr + (i * 4)); return true;
+    }
+    return false;
+}
+
+// checks that for every attribute type, the decoders picked by attr_resolve_decoders give the same bits as the
+// reference switch, and that the batch functions give the same results as fetching one vertex at a time
+static int test_attr_decoders() {
+    const uint32_t types[] = {GL_FLOAT, GL_HALF_FLOAT, GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT, GL_BYTE, GL_SHORT, GL_INT};
+    const size_t vertex_count = 4096;
+    const unsigned int stride = 20; // big enough for 4 values of any type, and reads are unaligned since the offset is 3
+    uint8_t* data = malloc((vertex_count * stride) + 16);
+    unsigned short* indices = malloc(vertex_count * sizeof(*indices));
+    float* batch = malloc(vertex_count * 4 * sizeof(float));
+    int32_t* batch_int = malloc(vertex_count * 4 * sizeof(int32_t));
+    test_rand_bytes(data, (vertex_count * stride) + 16);
+    for (size_t i = 0; i < vertex_count; i += 1) indices[i] = (unsigned short)(test_rand() % vertex_count);
+    struct GLArrayBuffer buffer = {0};
+    buffer.data = data;
+    buffer.size = (vertex_count * stride) + 16;
+    int failures = 0;
+
+    for (size_t t = 0; t < sizeof(types) / sizeof(*types); t += 1) {
+        for (uint8_t normalise = 0; normalise < 2; normalise += 1) {
+            for (size_t num_out = 1; num_out <= 4; num_out += 1) {
+                struct GLAttrBinding binding = {
+                    .buffer = &buffer, .offset = 3, .stride = stride, .size = num_out, .type = types[t], .normalise = normalise, .enabled = true,
+                };
+                attr_resolve_decoders(&binding);
+                float ref[4];
+                int32_t ref_int[4];
+                const uint8_t supported = reference_attr_decode(types[t], normalise, data + binding.offset, num_out, ref);
+                const uint8_t supported_int = reference_attr_decode_int(types[t], normalise, data + binding.offset, num_out, ref_int);
+                if (supported != (binding.decode != NULL) || supported_int != (binding.decode_int != NULL)) {
+                    printf("attr_decoders: type %u normalise %u: decoder availability differs from reference\n", types[t], normalise);
+                    failures += 1;
+                    continue;
+                }
+                if (!supported) continue;
+
+                const uint8_t batch_ok = attr_get_binding_batch(NULL, &binding, indices, vertex_count, num_out, batch);
+                const uint8_t batch_int_ok = attr_get_binding_int_batch(NULL, &binding, indices, vertex_count, num_out, batch_int);
+                if (!batch_ok || batch_int_ok != supported_int) {
+                    printf("attr_decoders: type %u normalise %u: batch decode failed\n", types[t], normalise);
+                    failures += 1;
+                    continue;
+                }
+                for (size_t i = 0; i < vertex_count; i += 1) {
+                    const uint8_t* ptr = data + binding.offset + (stride * indices[i]);
+                    float actual[4];
+                    reference_attr_decode(types[t], normalise, ptr, num_out, ref);
+                    attr_get_binding(NULL, &binding, indices[i], num_out, actual);
+                    // compared bitwise, since random float and half-float bits include NaNs
+                    if (memcmp(ref, actual, num_out * sizeof(float)) || memcmp(ref, batch + (i * num_out), num_out * sizeof(float))) {
+                        if (failures < 10) printf("attr_decoders: type %u normalise %u size %zu: mismatch at vertex %zu\n", types[t], normalise, num_out, i);
+                        failures += 1;
+                    }
+                    if (supported_int) {
+                        int32_t actual_int[4];
+                        reference_attr_decode_int(types[t], normalise, ptr, num_out, ref_int);
+                        attr_get_binding_int(NULL, &binding, indices[i], num_out, actual_int);
+                        if (memcmp(ref_int, actual_int, num_out * sizeof(int32_t)) || memcmp(ref_int, batch_int + (i * num_out), num_out * sizeof(int32_t))) {
+                            if (failures < 10) printf("attr_decoders: type %u size %zu: integer mismatch at vertex %zu\n", types[t], num_out, i);
+                            failures += 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // a render3d position fetch: one vertex at a time through the old switch and the resolved decoder, then as a batch.
+    // the values are random bits, so they're only added up to stop the loops being optimised out.
+    struct GLAttrBinding binding = {.buffer = &buffer, .offset = 0, .stride = stride, .size = 3, .type = GL_FLOAT, .normalise = false, .enabled = true};
+    attr_resolve_decoders(&binding);
+    const size_t rounds = 200;
+    volatile float sink = 0.0f;
+    float pos[3];
+    const uint64_t switch_start = test_now_nanos();
+    for (size_t r = 0; r < rounds; r += 1) {
+        for (size_t i = 0; i < vertex_count; i += 1) {
+            reference_attr_decode(binding.type, binding.normalise, data + (stride * indices[i]), 3, pos);
+            sink += pos[r % 3];
+        }
+    }
+    const uint64_t resolved_start = test_now_nanos();
+    for (size_t r = 0; r < rounds; r += 1) {
+        for (size_t i = 0; i < vertex_count; i += 1) {
+            attr_get_binding(NULL, &binding, indices[i], 3, pos);
+            sink += pos[r % 3];
+        }
+    }
+    const uint64_t batch_start = test_now_nanos();
+    for (size_t r = 0; r < rounds; r += 1) {
+        attr_get_binding_batch(NULL, &binding, indices, vertex_count, 3, batch);
+        sink += batch[r % 3];
+    }
+    const uint64_t end = test_now_nanos();
+    const double fetches = (double)(rounds * vertex_count);
+    printf("attr_decoders: float3 fetch per vertex: switch %.2fns, resolved decoder %.2fns, batch %.2fns\n",
+        (resolved_start - switch_start) / fetches, (batch_start - resolved_start) / fetches, (end - batch_start) / fetches);
+
+    free(data);
+    free(indices);
+    free(batch);
+    free(batch_int);
+    return failures ? 1 : 0;
+}
+
+/* namemap */
+
+// what NameMap replaced: every lookup takes the read lock and hashes its name
+static uint64_t reference_name_hash(const void* item, uint64_t seed0, uint64_t seed1) {
+    const GLuint* const* const id = item;
+    return hashmap_sip(*id, sizeof(GLuint), seed0, seed1);
+}
+
+static void* reference_map_get(struct hashmap* map, RWLock* lock, GLuint name) {
+    const GLuint* const name_ptr = &name;
+    _bolt_rwlock_lock_read(lock);
+    void* const* const val = (void**)hashmap_get(map, &name_ptr);
+    void* const ret = val ? *val : NULL;
+    _bolt_rwlock_unlock_read(lock);
+    return ret;
+}
+
+#define NAMEMAP_TEST_NAMES 20000
+
+struct NameMapTestReader {
+    struct NameMap* map;
+    GLuint* names;
+    volatile uint8_t stop;
+    uint64_t lookups;
+    uint64_t errors;
+};
+
+// looks names up while the main thread changes the map. every result must be NULL or the right struct.
+static void* namemap_test_reader(void* userdata) {
+    struct NameMapTestReader* reader = userdata;
+    uint64_t rng = 12345;
+    while (!reader->stop) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        const GLuint name = reader->names[rng % NAMEMAP_TEST_NAMES];
+        const GLuint* const item = map_get(reader->map, name);
+        if (item && *item != name) reader->errors += 1;
+        reader->lookups += 1;
+    }
+    return NULL;
+}
+
+// checks NameMap against a hashmap through random inserts and deletes, both of small names and of names big
+// enough to go in the overflow, then looks names up from another thread while the map changes, then compares
+// lookup speed with the locked hashmap NameMap replaced
+static int test_namemap() {
+    // a NameMap item is anything whose first member is its name
+    GLuint* names = malloc(NAMEMAP_TEST_NAMES * sizeof(*names));
+    uint8_t* present = calloc(NAMEMAP_TEST_NAMES, 1);
+    for (size_t i = 0; i < NAMEMAP_TEST_NAMES; i += 1) {
+        // mostly small sequential-ish names as drivers hand out, with a few huge ones
+        names[i] = (i % 100 == 99) ? (GLuint)(0x400000 + (test_rand() % 0x7FFFFFFF)) : (GLuint)(i + 1);
+    }
+    struct NameMap map;
+    namemap_init(&map);
+    RWLock reference_lock;
+    _bolt_rwlock_init(&reference_lock);
+    struct hashmap* reference = hashmap_new(sizeof(void*), 0, 0, 0, reference_name_hash, namemap_overflow_compare, NULL, NULL);
+    int failures = 0;
+
+    for (size_t step = 0; step < 200000; step += 1) {
+        const size_t i = test_rand() % NAMEMAP_TEST_NAMES;
+        GLuint* const item = &names[i];
+        _bolt_rwlock_lock_write(&map.rwlock);
+        if (present[i]) {
+            const GLuint* const name_ptr = item;
+            const void* const removed = namemap_delete(&map, *item);
+            hashmap_delete(reference, &name_ptr);
+            if (removed != item) failures += 1;
+        } else {
+            namemap_set(&map, *item, item);
+            hashmap_set(reference, &item);
+        }
+        _bolt_rwlock_unlock_write(&map.rwlock);
+        present[i] = !present[i];
+    }
+    for (size_t i = 0; i < NAMEMAP_TEST_NAMES; i += 1) {
+        const void* const expected = reference_map_get(reference, &reference_lock, names[i]);
+        const void* const actual = map_get(&map, names[i]);
+        if (actual != expected || (actual != NULL) != present[i]) {
+            if (failures < 10) printf("namemap: wrong lookup result for name %u\n", names[i]);
+            failures += 1;
+        }
+    }
+    _bolt_rwlock_lock_write(&map.rwlock);
+    if (namemap_delete(&map, 0) != NULL) failures += 1;
+    _bolt_rwlock_unlock_write(&map.rwlock);
+
+    struct NameMapTestReader reader = {.map = &map, .names = names};
+    pthread_t thread;
+    pthread_create(&thread, NULL, namemap_test_reader, &reader);
+    for (size_t step = 0; step < 200000; step += 1) {
+        const size_t i = test_rand() % NAMEMAP_TEST_NAMES;
+        _bolt_rwlock_lock_write(&map.rwlock);
+        if (present[i]) namemap_delete(&map, names[i]);
+        else namemap_set(&map, names[i], &names[i]);
+        _bolt_rwlock_unlock_write(&map.rwlock);
+        present[i] = !present[i];
+    }
+    reader.stop = true;
+    pthread_join(thread, NULL);
+    if (reader.errors) {
+        printf("namemap: %llu wrong results out of %llu concurrent lookups\n", (unsigned long long)reader.errors, (unsigned long long)reader.lookups);
+        failures += 1;
+    }
+
+    // fill both maps completely, then time random lookups
+    for (size_t i = 0; i < NAMEMAP_TEST_NAMES; i += 1) {
+        GLuint* const item = &names[i];
+        _bolt_rwlock_lock_write(&map.rwlock);
+        namemap_set(&map, *item, item);
+        _bolt_rwlock_unlock_write(&map.rwlock);
+        hashmap_set(reference, &item);
+    }
+    const size_t lookups = 5000000;
+    uint64_t hits = 0;
+    const uint64_t reference_start = test_now_nanos();
+    for (size_t i = 0; i < lookups; i += 1) {
+        hits += reference_map_get(reference, &reference_lock, names[test_rand() % NAMEMAP_TEST_NAMES]) != NULL;
+    }
+    const uint64_t namemap_start = test_now_nanos();
+    for (size_t i = 0; i < lookups; i += 1) {
+        hits += map_get(&map, names[test_rand() % NAMEMAP_TEST_NAMES]) != NULL;
+    }
+    const uint64_t end = test_now_nanos();
+    if (hits != lookups * 2) failures += 1;
+    printf("namemap: lookup of %u live names: locked hashmap %.2fns, NameMap %.2fns\n", NAMEMAP_TEST_NAMES,
+        (double)(namemap_start - reference_start) / lookups, (double)(end - namemap_start) / lookups);
+
+    namemap_destroy(&map);
+    hashmap_free(reference);
+    _bolt_rwlock_destroy(&reference_lock);
+    free(names);
+    free(present);
+    return failures ? 1 : 0;
+}
+
+#undef NAMEMAP_TEST_NAMES
+
+/* transforms */
+
+static void test_rand_transform(struct Transform3D* out) {
+    for (size_t i = 0; i < 16; i += 1) out->matrix[i] = ((double)(int64_t)(test_rand() >> 11) / (double)(1ull << 52)) - 1.0;
+}
+
+// compares the SSE2 transform multiply and smooth-skinning blend with the scalar versions, bit for bit, on random
+// matrices in the range the game uses, then times the multiply
+static int test_transforms() {
+#if defined(BOLT_SSE2)
+    const size_t count = 4096;
+    struct Transform3D* left = malloc(count * sizeof(*left));
+    struct Transform3D* right = malloc(count * sizeof(*right));
+    struct Transform3D out;
+    int failures = 0;
+    for (size_t i = 0; i < count; i += 1) {
+        test_rand_transform(&left[i]);
+        test_rand_transform(&right[i]);
+    }
+    for (size_t i = 0; i < count; i += 1) {
+        struct Transform3D expected;
+        multiply_transforms_scalar(&left[i], &right[i], &expected);
+        multiply_transforms_sse2(&left[i], &right[i], &out);
+        if (memcmp(&expected, &out, sizeof(out))) {
+            if (failures < 10) printf("transforms: multiply mismatch for pair %zu\n", i);
+            failures += 1;
+        }
+    }
+    for (size_t i = 0; i + 4 <= count; i += 4) {
+        float weights[4];
+        for (size_t j = 0; j < 4; j += 1) weights[j] = (float)(test_rand() % 256) / 255.0f;
+        struct Transform3D expected;
+        blend_transforms_scalar(&left[i], weights, &expected);
+        blend_transforms_sse2(&left[i], weights, &out);
+        if (memcmp(&expected, &out, sizeof(out))) {
+            if (failures < 10) printf("transforms: blend mismatch at %zu\n", i);
+            failures += 1;
+        }
+    }
+
+    const size_t rounds = 500;
+    volatile double sink = 0.0;
+    const uint64_t scalar_start = test_now_nanos();
+    for (size_t r = 0; r < rounds; r += 1) {
+        for (size_t i = 0; i < count; i += 1) {
+            multiply_transforms_scalar(&left[i], &right[i], &out);
+            sink += out.matrix[r & 15];
+        }
+    }
+    const uint64_t sse2_start = test_now_nanos();
+    for (size_t r = 0; r < rounds; r += 1) {
+        for (size_t i = 0; i < count; i += 1) {
+            multiply_transforms_sse2(&left[i], &right[i], &out);
+            sink += out.matrix[r & 15];
+        }
+    }
+    const uint64_t end = test_now_nanos();
+    printf("transforms: multiply: scalar %.2fns, sse2 %.2fns\n",
+        (double)(sse2_start - scalar_start) / (rounds * count), (double)(end - sse2_start) / (rounds * count));
+    free(left);
+    free(right);
+    return failures ? 1 : 0;
+#else
+    printf("transforms: skipped, no SSE2 path on this target\n");
+    return 0;
+#endif
+}
+
+struct TestCase {
+    const char* name;
+    int (*func)();
+};
+
+static const struct TestCase test_cases[] = {
+    {"s3tc", test_s3tc},
+    {"s3tc_eviction", test_s3tc_eviction},
+    {"attr_decoders", test_attr_decoders},
+    {"namemap", test_namemap},
+    {"transforms", test_transforms},
+};
+
+int main(int argc, char** argv) {
+    int ret = 0;
+    uint8_t found = false;
+    for (size_t i = 0; i < sizeof(test_cases) / sizeof(*test_cases); i += 1) {
+        if (argc > 1 && strcmp(argv[1], test_cases[i].name)) continue;
+        found = true;
+        if (test_cases[i].func()) {
+            printf("%s: FAILED\n", test_cases[i].name);
+            ret = 1;
+        } else {
+            printf("%s: passed\n", test_cases[i].name);
+        }
+    }
+    if (!found) {
+        printf("no such test '%s'\n", argv[1]);
+        return 1;
+    }
+    return ret;
+}
@@ -0,0 +1,985 @@
+// replays a GL trace recorded by a BOLT_LIBRARY_TRACE build (see trace.h) through gl.c's hooks, against fake GL
+// functions which do no rendering, and reports how much CPU time bolt spent per frame. no GPU, window or game
+// client is needed, so this can be used to catch regressions in the hook layer.
+//
+// usage: bolt-gl-replay <trace file> [event bits | all]
+// the event bits are the PLUGIN_EVENT_BITs which are treated as having a plugin subscribed to them, defaulting
+// to none. build with -D BOLT_LIBRARY_PROFILE=1 to also get gl.c's own per-hook breakdown.
+//
+// the trace doesn't contain anything the game only ever got back from GL, such as uniform locations, uniform
+// block layouts, or data the game wrote through a real buffer mapping. the fakes report almost every uniform as
+// present at offset 0, and read back zeroes, so programs are only told apart by their attribute bindings, the
+// minimap terrain program isn't recognised, and render events carry meaningless data. otherwise the work done
+// per call is the same as in the game.
+#include "../gl.h"
+#include "../trace.h"
+#include "../plugin/plugin.h"
+#include "../../../modules/hashmap/hashmap.h"
+#include "stubs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* fake GL */
+
+// one entry in the fake GL's object tables. which fields are used depends on the table.
+struct FakeObject {
+    GLuint id;
+    GLuint colour; // framebuffers: the name attached to GL_COLOR_ATTACHMENT0
+    GLuint depth; // framebuffers: the name attached to GL_DEPTH_ATTACHMENT or GL_DEPTH_STENCIL_ATTACHMENT
+    GLuint element_buffer; // vertex arrays: the bound GL_ELEMENT_ARRAY_BUFFER
+    uint8_t* mapping; // buffers: the memory handed out by MapBufferRange until it's unmapped
+};
+
+static struct hashmap* fake_buffers;
+static struct hashmap* fake_framebuffers;
+static struct hashmap* fake_vaos;
+static GLuint fake_bound_array_buffer = 0;
+static GLuint fake_bound_uniform_buffer = 0;
+static GLuint fake_bound_pixel_pack_buffer = 0;
+static GLuint fake_bound_pixel_unpack_buffer = 0;
+static GLuint fake_bound_vao = 0;
+static GLuint fake_read_framebuffer = 0;
+static GLuint fake_draw_framebuffer = 0;
+
+// names for objects that bolt creates itself. objects created by the game get the names they had in the
+// trace, by setting fake_pending_names or fake_pending_program before calling the hook.
+static GLuint fake_next_name = 0x40000000;
+static GLint fake_next_location = 0;
+static const GLuint* fake_pending_names = NULL;
+static GLsizei fake_pending_name_count = 0;
+static GLuint fake_pending_program = 0;
+static char fake_fence;
+
+static int fake_object_compare(const void* a, const void* b, void* udata) {
+    const GLuint x = ((const struct FakeObject*)a)->id;
+    const GLuint y = ((const struct FakeObject*)b)->id;
+    return (x > y) - (x < y);
+}
+
+static uint64_t fake_object_hash(const void* item, uint64_t seed0, uint64_t seed1) {
+    const struct FakeObject* object = item;
+    return hashmap_sip(&object->id, sizeof(object->id), seed0, seed1);
+}
+
+// returns the entry for `id` in `map`, adding an empty one if there isn't one yet
+static struct FakeObject* fake_object(struct hashmap* map, GLuint id) {
+    const struct FakeObject key = {.id = id};
+    const struct FakeObject* object = hashmap_get(map, &key);
+    if (!object) {
+        hashmap_set(map, &key);
+        object = hashmap_get(map, &key);
+    }
+    return (struct FakeObject*)object;
+}
+
+static void fake_delete_objects(struct hashmap* map, GLsizei n, const GLuint* names) {
+    for (GLsizei i = 0; i < n; i += 1) {
+        const struct FakeObject key = {.id = names[i]};
+        const struct FakeObject* object = hashmap_delete(map, &key);
+        if (object) free(object->mapping);
+    }
+}
+
+static void fake_gen_names(GLsizei n, GLuint* out) {
+    for (GLsizei i = 0; i < n; i += 1) {
+        if (i < fake_pending_name_count) {
+            out[i] = fake_pending_names[i];
+        } else {
+            out[i] = fake_next_name;
+            fake_next_name += 1;
+        }
+    }
+    fake_pending_names = NULL;
+    fake_pending_name_count = 0;
+}
+
+// the fake equivalent of context_bound_buffer in gl.c
+static struct FakeObject* fake_bound_buffer(GLenum target) {
+    GLuint id = 0;
+    switch (target) {
+        case GL_ARRAY_BUFFER: id = fake_bound_array_buffer; break;
+        case GL_ELEMENT_ARRAY_BUFFER: id = fake_object(fake_vaos, fake_bound_vao)->element_buffer; break;
+        case GL_UNIFORM_BUFFER: id = fake_bound_uniform_buffer; break;
+        case GL_PIXEL_PACK_BUFFER: id = fake_bound_pixel_pack_buffer; break;
+        case GL_PIXEL_UNPACK_BUFFER: id = fake_bound_pixel_unpack_buffer; break;
+    }
+    return id ? fake_object(fake_buffers, id) : NULL;
+}
+
+static void fake_unmap(struct FakeObject* buffer) {
+    if (!buffer) return;
+    free(buffer->mapping);
+    buffer->mapping = NULL;
+}
+
+static void fake_attach(GLenum target, GLenum attachment, GLuint name) {
+    const GLuint fb = target == GL_READ_FRAMEBUFFER ? fake_read_framebuffer : fake_draw_framebuffer;
+    if (!fb) return;
+    struct FakeObject* framebuffer = fake_object(fake_framebuffers, fb);
+    if (attachment == GL_COLOR_ATTACHMENT0) framebuffer->colour = name;
+    if (attachment == GL_DEPTH_ATTACHMENT || attachment == GL_DEPTH_STENCIL_ATTACHMENT) framebuffer->depth = name;
+}
+
+#define FAKE_NOOP(NAME, ...) static void fake_##NAME(__VA_ARGS__) {}
+FAKE_NOOP(ActiveTexture, GLenum a)
+FAKE_NOOP(AttachShader, GLuint a, GLuint b)
+FAKE_NOOP(BindAttribLocation, GLuint a, GLuint b, const GLchar* c)
+FAKE_NOOP(BlendFuncSeparate, GLenum a, GLenum b, GLenum c, GLenum d)
+FAKE_NOOP(BlitFramebuffer, GLint a, GLint b, GLint c, GLint d, GLint e, GLint f, GLint g, GLint h, GLbitfield i, GLenum j)
+FAKE_NOOP(BufferSubData, GLenum a, GLintptr b, GLsizeiptr c, const void* d)
+FAKE_NOOP(CompileShader, GLuint a)
+FAKE_NOOP(CompressedTexSubImage2D, GLenum a, GLint b, GLint c, GLint d, GLsizei e, GLsizei f, GLenum g, GLsizei h, const void* i)
+FAKE_NOOP(CopyBufferSubData, GLenum a, GLenum b, GLintptr c, GLintptr d, GLsizeiptr e)
+FAKE_NOOP(CopyImageSubData, GLuint a, GLenum b, GLint c, GLint d, GLint e, GLint f, GLuint g, GLenum h, GLint i, GLint j, GLint k, GLint l, GLsizei m, GLsizei n, GLsizei o)
+FAKE_NOOP(DeleteProgram, GLuint a)
+FAKE_NOOP(DeleteShader, GLuint a)
+FAKE_NOOP(DeleteSync, GLsync a)
+FAKE_NOOP(DetachShader, GLuint a, GLuint b)
+FAKE_NOOP(DisableVertexAttribArray, GLuint a)
+FAKE_NOOP(EnableVertexAttribArray, GLuint a)
+FAKE_NOOP(FlushMappedBufferRange, GLenum a, GLintptr b, GLsizeiptr c)
+FAKE_NOOP(GetBufferSubData, GLenum a, GLintptr b, GLsizeiptr c, void* d)
+FAKE_NOOP(GetUniformfv, GLuint a, GLint b, GLfloat* c)
+FAKE_NOOP(LinkProgram, GLuint a)
+FAKE_NOOP(MultiDrawElements, GLenum a, const GLsizei* b, GLenum c, const void* const* d, GLsizei e)
+FAKE_NOOP(ShaderSource, GLuint a, GLsizei b, const GLchar** c, const GLint* d)
+FAKE_NOOP(TexStorage2D, GLenum a, GLsizei b, GLenum c, GLsizei d, GLsizei e)
+FAKE_NOOP(TexStorage2DMultisample, GLenum a, GLsizei b, GLenum c, GLsizei d, GLsizei e, GLboolean f)
+FAKE_NOOP(Uniform1f, GLint a, GLfloat b)
+FAKE_NOOP(Uniform2f, GLint a, GLfloat b, GLfloat c)
+FAKE_NOOP(Uniform3f, GLint a, GLfloat b, GLfloat c, GLfloat d)
+FAKE_NOOP(Uniform4f, GLint a, GLfloat b, GLfloat c, GLfloat d, GLfloat e)
+FAKE_NOOP(Uniform1fv, GLint a, GLsizei b, const GLfloat* c)
+FAKE_NOOP(Uniform2fv, GLint a, GLsizei b, const GLfloat* c)
+FAKE_NOOP(Uniform3fv, GLint a, GLsizei b, const GLfloat* c)
+FAKE_NOOP(Uniform4fv, GLint a, GLsizei b, const GLfloat* c)
+FAKE_NOOP(Uniform1i, GLint a, GLint b)
+FAKE_NOOP(Uniform2i, GLint a, GLint b, GLint c)
+FAKE_NOOP(Uniform3i, GLint a, GLint b, GLint c, GLint d)
+FAKE_NOOP(Uniform4i, GLint a, GLint b, GLint c, GLint d, GLint e)
+FAKE_NOOP(Uniform1iv, GLint a, GLsizei b, const GLint* c)
+FAKE_NOOP(Uniform2iv, GLint a, GLsizei b, const GLint* c)
+FAKE_NOOP(Uniform3iv, GLint a, GLsizei b, const GLint* c)
+FAKE_NOOP(Uniform4iv, GLint a, GLsizei b, const GLint* c)
+FAKE_NOOP(UniformBlockBinding, GLuint a, GLuint b, GLuint c)
+FAKE_NOOP(UniformMatrix2fv, GLint a, GLsizei b, GLboolean c, const GLfloat* d)
+FAKE_NOOP(UniformMatrix3fv, GLint a, GLsizei b, GLboolean c, const GLfloat* d)
+FAKE_NOOP(UniformMatrix4fv, GLint a, GLsizei b, GLboolean c, const GLfloat* d)
+FAKE_NOOP(UseProgram, GLuint a)
+FAKE_NOOP(VertexAttribLPointer, GLuint a, GLint b, GLenum c, GLsizei d, const void* e)
+FAKE_NOOP(VertexAttribPointer, GLuint a, GLint b, GLenum c, GLboolean d, GLsizei e, const void* f)
+FAKE_NOOP(BindTexture, GLenum a, GLuint b)
+FAKE_NOOP(BlendFunc, GLenum a, GLenum b)
+FAKE_NOOP(Clear, GLbitfield a)
+FAKE_NOOP(ClearColor, GLfloat a, GLfloat b, GLfloat c, GLfloat d)
+FAKE_NOOP(DeleteTextures, GLsizei a, const GLuint* b)
+FAKE_NOOP(Disable, GLenum a)
+FAKE_NOOP(DrawArrays, GLenum a, GLint b, GLsizei c)
+FAKE_NOOP(DrawElements, GLenum a, GLsizei b, GLenum c, const void* d)
+FAKE_NOOP(Enable, GLenum a)
+FAKE_NOOP(Flush, void)
+FAKE_NOOP(PixelStorei, GLenum a, GLint b)
+FAKE_NOOP(ReadPixels, GLint a, GLint b, GLsizei c, GLsizei d, GLenum e, GLenum f, void* g)
+FAKE_NOOP(TexParameteri, GLenum a, GLenum b, GLint c)
+FAKE_NOOP(TexSubImage2D, GLenum a, GLint b, GLint c, GLint d, GLsizei e, GLsizei f, GLenum g, GLenum h, const void* i)
+FAKE_NOOP(Viewport, GLint a, GLint b, GLsizei c, GLsizei d)
+#undef FAKE_NOOP
+
+static void fake_BindBuffer(GLenum target, GLuint buffer) {
+    switch (target) {
+        case GL_ARRAY_BUFFER: fake_bound_array_buffer = buffer; break;
+        case GL_ELEMENT_ARRAY_BUFFER: fake_object(fake_vaos, fake_bound_vao)->element_buffer = buffer; break;
+        case GL_UNIFORM_BUFFER: fake_bound_uniform_buffer = buffer; break;
+        case GL_PIXEL_PACK_BUFFER: fake_bound_pixel_pack_buffer = buffer; break;
+        case GL_PIXEL_UNPACK_BUFFER: fake_bound_pixel_unpack_buffer = buffer; break;
+    }
+}
+
+static void fake_BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    fake_BindBuffer(target, buffer);
+}
+
+static void fake_BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    fake_BindBuffer(target, buffer);
+}
+
+static void fake_BindFramebuffer(GLenum target, GLuint framebuffer) {
+    if (target == GL_READ_FRAMEBUFFER || target == GL_FRAMEBUFFER) fake_read_framebuffer = framebuffer;
+    if (target == GL_DRAW_FRAMEBUFFER || target == GL_FRAMEBUFFER) fake_draw_framebuffer = framebuffer;
+}
+
+static void fake_BindVertexArray(GLuint array) {
+    fake_bound_vao = array;
+}
+
+static void fake_BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    fake_unmap(fake_bound_buffer(target));
+}
+
+static void fake_BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+    fake_unmap(fake_bound_buffer(target));
+}
+
+static GLenum fake_ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    return GL_ALREADY_SIGNALED;
+}
+
+static GLuint fake_CreateProgram(void) {
+    GLuint ret = fake_pending_program;
+    fake_pending_program = 0;
+    if (!ret) fake_gen_names(1, &ret);
+    return ret;
+}
+
+static GLuint fake_CreateShader(GLenum type) {
+    GLuint ret;
+    fake_gen_names(1, &ret);
+    return ret;
+}
+
+static void fake_DeleteBuffers(GLsizei n, const GLuint* buffers) {
+    fake_delete_objects(fake_buffers, n, buffers);
+}
+
+static void fake_DeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+    fake_delete_objects(fake_framebuffers, n, framebuffers);
+}
+
+static void fake_DeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+    fake_delete_objects(fake_vaos, n, arrays);
+}
+
+static GLsync fake_FenceSync(GLenum condition, GLbitfield flags) {
+    return (GLsync)&fake_fence;
+}
+
+static void fake_FramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
+    fake_attach(target, attachment, renderbuffer);
+}
+
+static void fake_FramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level) {
+    fake_attach(target, attachment, texture);
+}
+
+static void fake_FramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+    fake_attach(target, attachment, texture);
+}
+
+static void fake_FramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) {
+    fake_attach(target, attachment, texture);
+}
+
+static void fake_GenBuffers(GLsizei n, GLuint* buffers) {
+    fake_gen_names(n, buffers);
+}
+
+static void fake_GenFramebuffers(GLsizei n, GLuint* framebuffers) {
+    fake_gen_names(n, framebuffers);
+}
+
+static void fake_GenVertexArrays(GLsizei n, GLuint* arrays) {
+    fake_gen_names(n, arrays);
+}
+
+static void fake_GenTextures(GLsizei n, GLuint* textures) {
+    fake_gen_names(n, textures);
+}
+
+// every uniform block index is bound to the binding point with the same number
+static void fake_GetActiveUniformBlockiv(GLuint program, GLuint index, GLenum pname, GLint* params) {
+    *params = (pname == GL_UNIFORM_BLOCK_BINDING) ? (GLint)index : 0;
+}
+
+static void fake_GetActiveUniformsiv(GLuint program, GLsizei count, const GLuint* indices, GLenum pname, GLint* params) {
+    memset(params, 0, count * sizeof(*params));
+}
+
+static void fake_GetFramebufferAttachmentParameteriv(GLenum target, GLenum attachment, GLenum pname, GLint* params) {
+    const GLuint fb = target == GL_READ_FRAMEBUFFER ? fake_read_framebuffer : fake_draw_framebuffer;
+    *params = 0;
+    if (!fb || pname != GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME) return;
+    const struct FakeObject* framebuffer = fake_object(fake_framebuffers, fb);
+    *params = (GLint)(attachment == GL_COLOR_ATTACHMENT0 ? framebuffer->colour : framebuffer->depth);
+}
+
+static void fake_GetIntegeri_v(GLenum target, GLuint index, GLint* data) {
+    *data = 0;
+}
+
+static void fake_GetProgramInfoLog(GLuint program, GLsizei max_length, GLsizei* length, GLchar* log) {
+    if (length) *length = 0;
+    if (max_length > 0) *log = '\0';
+}
+
+static void fake_GetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    switch (pname) {
+        case GL_LINK_STATUS: *params = 1; break;
+        case GL_ACTIVE_UNIFORM_BLOCKS: *params = 7; break;
+        default: *params = 0; break;
+    }
+}
+
+static void fake_GetShaderInfoLog(GLuint shader, GLsizei max_length, GLsizei* length, GLchar* log) {
+    fake_GetProgramInfoLog(shader, max_length, length, log);
+}
+
+static void fake_GetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+    *params = (pname == GL_COMPILE_STATUS) ? 1 : 0;
+}
+
+// every program gets all the uniform blocks that gl.c looks for, each with its own index, except TerrainConsts.
+// that one is left out because gl.c takes any program with both it and ViewTransforms to be the minimap's.
+static GLuint fake_GetUniformBlockIndex(GLuint program, const GLchar* name) {
+    const char* const names[] = {"ViewTransforms", "BatchConsts", "VertexTransformData", "ModelConsts", "ParticleConsts", "GUIConsts", "BilloardConsts"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(*names); i += 1) {
+        if (!strcmp(name, names[i])) return (GLuint)i;
+    }
+    return (GLuint)-1;
+}
+
+static void fake_GetUniformIndices(GLuint program, GLsizei count, const GLchar** names, GLuint* indices) {
+    for (GLsizei i = 0; i < count; i += 1) indices[i] = (GLuint)i;
+}
+
+static void fake_GetUniformiv(GLuint program, GLint location, GLint* params) {
+    *params = 0;
+}
+
+static GLint fake_GetUniformLocation(GLuint program, const GLchar* name) {
+    const GLint ret = fake_next_location;
+    fake_next_location += 1;
+    return ret;
+}
+
+static void* fake_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    struct FakeObject* buffer = fake_bound_buffer(target);
+    if (!buffer) return NULL;
+    fake_unmap(buffer);
+    buffer->mapping = calloc(length ? length : 1, 1);
+    return buffer->mapping;
+}
+
+static GLboolean fake_UnmapBuffer(GLenum target) {
+    fake_unmap(fake_bound_buffer(target));
+    return 1;
+}
+
+static void fake_GetBooleanv(GLenum pname, GLboolean* data) {
+    *data = 0;
+}
+
+static GLenum fake_GetError(void) {
+    return 0;
+}
+
+static void fake_GetIntegerv(GLenum pname, GLint* data) {
+    switch (pname) {
+        case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: *data = 192; break;
+        case GL_MAX_VERTEX_ATTRIBS: *data = 16; break;
+        case GL_ACTIVE_TEXTURE: *data = GL_TEXTURE0; break;
+        case GL_ARRAY_BUFFER_BINDING: *data = (GLint)fake_bound_array_buffer; break;
+        case GL_ELEMENT_ARRAY_BUFFER_BINDING: *data = (GLint)fake_object(fake_vaos, fake_bound_vao)->element_buffer; break;
+        case GL_UNIFORM_BUFFER_BINDING: *data = (GLint)fake_bound_uniform_buffer; break;
+        case GL_PIXEL_PACK_BUFFER_BINDING: *data = (GLint)fake_bound_pixel_pack_buffer; break;
+        case GL_VERTEX_ARRAY_BINDING: *data = (GLint)fake_bound_vao; break;
+        case GL_PACK_ALIGNMENT: *data = 4; break;
+        default: *data = 0; break;
+    }
+}
+
+static void* fake_get_proc_address(const char* name) {
+#define FAKE_PROC(NAME) if (!strcmp(name, "gl"#NAME)) return (void*)fake_##NAME;
+    FAKE_PROC(ActiveTexture)
+    FAKE_PROC(AttachShader)
+    FAKE_PROC(BindAttribLocation)
+    FAKE_PROC(BindBuffer)
+    FAKE_PROC(BindBufferBase)
+    FAKE_PROC(BindBufferRange)
+    FAKE_PROC(BindFramebuffer)
+    FAKE_PROC(BindVertexArray)
+    FAKE_PROC(BlendFuncSeparate)
+    FAKE_PROC(BlitFramebuffer)
+    FAKE_PROC(BufferData)
+    FAKE_PROC(BufferStorage)
+    FAKE_PROC(BufferSubData)
+    FAKE_PROC(ClientWaitSync)
+    FAKE_PROC(CompileShader)
+    FAKE_PROC(CompressedTexSubImage2D)
+    FAKE_PROC(CopyBufferSubData)
+    FAKE_PROC(CopyImageSubData)
+    FAKE_PROC(CreateProgram)
+    FAKE_PROC(CreateShader)
+    FAKE_PROC(DeleteBuffers)
+    FAKE_PROC(DeleteFramebuffers)
+    FAKE_PROC(DeleteProgram)
+    FAKE_PROC(DeleteShader)
+    FAKE_PROC(DeleteSync)
+    FAKE_PROC(DeleteVertexArrays)
+    FAKE_PROC(DetachShader)
+    FAKE_PROC(DisableVertexAttribArray)
+    FAKE_PROC(EnableVertexAttribArray)
+    FAKE_PROC(FenceSync)
+    FAKE_PROC(FlushMappedBufferRange)
+    FAKE_PROC(FramebufferRenderbuffer)
+    FAKE_PROC(FramebufferTexture)
+    FAKE_PROC(FramebufferTexture2D)
+    FAKE_PROC(FramebufferTextureLayer)
+    FAKE_PROC(GenBuffers)
+    FAKE_PROC(GenFramebuffers)
+    FAKE_PROC(GenVertexArrays)
+    FAKE_PROC(GetActiveUniformBlockiv)
+    FAKE_PROC(GetBufferSubData)
+    FAKE_PROC(GetActiveUniformsiv)
+    FAKE_PROC(GetFramebufferAttachmentParameteriv)
+    FAKE_PROC(GetIntegeri_v)
+    FAKE_PROC(GetProgramInfoLog)
+    FAKE_PROC(GetProgramiv)
+    FAKE_PROC(GetShaderInfoLog)
+    FAKE_PROC(GetShaderiv)
+    FAKE_PROC(GetUniformBlockIndex)
+    FAKE_PROC(GetUniformfv)
+    FAKE_PROC(GetUniformIndices)
+    FAKE_PROC(GetUniformiv)
+    FAKE_PROC(GetUniformLocation)
+    FAKE_PROC(LinkProgram)
+    FAKE_PROC(MapBufferRange)
+    FAKE_PROC(MultiDrawElements)
+    FAKE_PROC(ShaderSource)
+    FAKE_PROC(TexStorage2D)
+    FAKE_PROC(TexStorage2DMultisample)
+    FAKE_PROC(Uniform1f)
+    FAKE_PROC(Uniform2f)
+    FAKE_PROC(Uniform3f)
+    FAKE_PROC(Uniform4f)
+    FAKE_PROC(Uniform1fv)
+    FAKE_PROC(Uniform2fv)
+    FAKE_PROC(Uniform3fv)
+    FAKE_PROC(Uniform4fv)
+    FAKE_PROC(Uniform1i)
+    FAKE_PROC(Uniform2i)
+    FAKE_PROC(Uniform3i)
+    FAKE_PROC(Uniform4i)
+    FAKE_PROC(Uniform1iv)
+    FAKE_PROC(Uniform2iv)
+    FAKE_PROC(Uniform3iv)
+    FAKE_PROC(Uniform4iv)
+    FAKE_PROC(UniformBlockBinding)
+    FAKE_PROC(UniformMatrix2fv)
+    FAKE_PROC(UniformMatrix3fv)
+    FAKE_PROC(UniformMatrix4fv)
+    FAKE_PROC(UnmapBuffer)
+    FAKE_PROC(UseProgram)
+    FAKE_PROC(VertexAttribLPointer)
+    FAKE_PROC(VertexAttribPointer)
+#undef FAKE_PROC
+    return NULL;
+}
+
+static const struct GLLibFunctions fake_libgl = {
+    .BindTexture = fake_BindTexture,
+    .BlendFunc = fake_BlendFunc,
+    .Clear = fake_Clear,
+    .ClearColor = fake_ClearColor,
+    .DeleteTextures = fake_DeleteTextures,
+    .Disable = fake_Disable,
+    .DrawArrays = fake_DrawArrays,
+    .DrawElements = fake_DrawElements,
+    .Enable = fake_Enable,
+    .Flush = fake_Flush,
+    .GenTextures = fake_GenTextures,
+    .GetBooleanv = fake_GetBooleanv,
+    .GetError = fake_GetError,
+    .GetIntegerv = fake_GetIntegerv,
+    .PixelStorei = fake_PixelStorei,
+    .ReadPixels = fake_ReadPixels,
+    .TexParameteri = fake_TexParameteri,
+    .TexSubImage2D = fake_TexSubImage2D,
+    .Viewport = fake_Viewport,
+};
+
+/* trace reading */
+
+// a record as it's kept in memory for replaying, with any TRACE_DATACONTINUATION payloads already joined on.
+// followed by arg_count uint64 arguments, then data_len bytes of payload, padded to a multiple of 8 bytes.
+struct ReplayRecord {
+    uint16_t op;
+    uint16_t arg_count;
+    uint64_t context;
+    uint64_t data_len;
+};
+
+// the number of arguments passed to TRACE_CALL for each op in gl.c. records with fewer are skipped.
+static const uint8_t replay_arg_counts[] = {
+    [TRACE_CREATECONTEXT] = 3, [TRACE_MAKECURRENT] = 1, [TRACE_DESTROYCONTEXT] = 1, [TRACE_SWAPBUFFERS] = 2,
+    [TRACE_CREATEPROGRAM] = 1, [TRACE_DELETEPROGRAM] = 1, [TRACE_BINDATTRIBLOCATION] = 2, [TRACE_LINKPROGRAM] = 1,
+    [TRACE_USEPROGRAM] = 1, [TRACE_GENBUFFERS] = 1, [TRACE_DELETEBUFFERS] = 1, [TRACE_BUFFERDATA] = 3,
+    [TRACE_BUFFERSTORAGE] = 3, [TRACE_BUFFERSUBDATA] = 3, [TRACE_MAPBUFFERRANGE] = 4, [TRACE_FLUSHMAPPEDBUFFERRANGE] = 3,
+    [TRACE_UNMAPBUFFER] = 1, [TRACE_GENTEXTURES] = 1, [TRACE_DELETETEXTURES] = 1, [TRACE_BINDTEXTURE] = 2,
+    [TRACE_ACTIVETEXTURE] = 1, [TRACE_TEXSTORAGE2D] = 5, [TRACE_TEXSTORAGE2DMULTISAMPLE] = 6, [TRACE_TEXSUBIMAGE2D] = 10,
+    [TRACE_COMPRESSEDTEXSUBIMAGE2D] = 10, [TRACE_TEXPARAMETERI] = 3, [TRACE_COPYIMAGESUBDATA] = 15,
+    [TRACE_GENVERTEXARRAYS] = 1, [TRACE_DELETEVERTEXARRAYS] = 1, [TRACE_BINDVERTEXARRAY] = 1,
+    [TRACE_VERTEXATTRIBPOINTER] = 6, [TRACE_ENABLEVERTEXATTRIBARRAY] = 1, [TRACE_DISABLEVERTEXATTRIBARRAY] = 1,
+    [TRACE_BINDFRAMEBUFFER] = 2, [TRACE_BLITFRAMEBUFFER] = 10, [TRACE_DRAWELEMENTS] = 4, [TRACE_DRAWARRAYS] = 3,
+    [TRACE_CLEAR] = 1, [TRACE_VIEWPORT] = 4, [TRACE_BLENDFUNC] = 2, [TRACE_BLENDFUNCSEPARATE] = 4,
+    [TRACE_BINDBUFFER] = 2, [TRACE_BINDBUFFERBASE] = 3, [TRACE_BINDBUFFERRANGE] = 5, [TRACE_UNIFORM1I] = 2,
+    [TRACE_UNIFORM1IV] = 2, [TRACE_UNIFORMBLOCKBINDING] = 3, [TRACE_FRAMEBUFFERTEXTURE] = 4,
+    [TRACE_FRAMEBUFFERTEXTURE2D] = 5, [TRACE_FRAMEBUFFERTEXTURELAYER] = 5, [TRACE_FRAMEBUFFERRENDERBUFFER] = 4,
+    [TRACE_DELETEFRAMEBUFFERS] = 1,
+};
+
+// one frame's worth of records, i.e. everything up to and including a TRACE_SWAPBUFFERS
+struct ReplayFrame {
+    uint8_t* data;
+    size_t len;
+    size_t capacity;
+    size_t record_count;
+};
+
+static uint8_t* frame_reserve(struct ReplayFrame* frame, size_t len) {
+    if (frame->len + len > frame->capacity) {
+        size_t capacity = frame->capacity ? frame->capacity : (1 << 20);
+        while (capacity < frame->len + len) capacity *= 2;
+        frame->data = realloc(frame->data, capacity);
+        frame->capacity = capacity;
+    }
+    uint8_t* ret = frame->data + frame->len;
+    frame->len += len;
+    return ret;
+}
+
+#define REPLAY_ALIGN(N) (((N) + 7) & ~(size_t)7)
+
+// reads records from `f` into `frame`, replacing its previous contents, until the end of a frame or the end of
+// the file. returns false if nothing at all was read.
+static uint8_t read_frame(FILE* f, struct ReplayFrame* frame) {
+    struct TraceRecordHeader header;
+    size_t last_record = (size_t)-1;
+    frame->len = 0;
+    frame->record_count = 0;
+    while (fread(&header, sizeof(header), 1, f) == 1) {
+        if (header.op == TRACE_DATACONTINUATION) {
+            if (last_record == (size_t)-1) {
+                fseek(f, (long)header.arg_count * 8 + header.data_len, SEEK_CUR);
+                continue;
+            }
+            // the previous record's payload is at the end of the frame, so it can be extended in place
+            struct ReplayRecord* record = (struct ReplayRecord*)(frame->data + last_record);
+            const size_t old_len = record->data_len;
+            frame->len -= REPLAY_ALIGN(old_len) - old_len;
+            uint8_t* dest = frame_reserve(frame, REPLAY_ALIGN(old_len + header.data_len) - old_len);
+            record = (struct ReplayRecord*)(frame->data + last_record);
+            if (fread(dest, 1, header.data_len, f) != header.data_len) return frame->record_count > 0;
+            record->data_len += header.data_len;
+            continue;
+        }
+        last_record = frame->len;
+        uint8_t* dest = frame_reserve(frame, sizeof(struct ReplayRecord) + (header.arg_count * sizeof(uint64_t)) + REPLAY_ALIGN(header.data_len));
+        struct ReplayRecord* record = (struct ReplayRecord*)dest;
+        record->op = header.op;
+        record->arg_count = header.arg_count;
+        record->context = header.context;
+        record->data_len = header.data_len;
+        if (fread(dest + sizeof(*record), sizeof(uint64_t), header.arg_count, f) != header.arg_count) break;
+        if (fread(dest + sizeof(*record) + (header.arg_count * sizeof(uint64_t)), 1, header.data_len, f) != header.data_len) break;
+        frame->record_count += 1;
+        if (header.op == TRACE_SWAPBUFFERS) break;
+    }
+    return frame->record_count > 0;
+}
+
+/* replaying */
+
+// hooks returned by _bolt_gl_GetProcAddress, i.e. what the game calls instead of the real GL functions
+static struct GLProcFunctions hooks;
+static uint8_t hooks_loaded = false;
+
+// memory returned from the MapBufferRange hook, which the game would have written to before unmapping
+struct ReplayMapping {
+    uint64_t context;
+    GLenum target;
+    uint8_t* ptr;
+    size_t len;
+};
+#define MAX_REPLAY_MAPPINGS 64
+static struct ReplayMapping mappings[MAX_REPLAY_MAPPINGS];
+static size_t mapping_count = 0;
+
+// zeroes, for calls whose payload isn't in the trace but which the hooks read anyway
+static uint8_t* scratch = NULL;
+static size_t scratch_len = 0;
+
+static void load_hooks() {
+#define LOAD_HOOK(NAME) hooks.NAME = _bolt_gl_GetProcAddress("gl"#NAME);
+    LOAD_HOOK(ActiveTexture)
+    LOAD_HOOK(BindAttribLocation)
+    LOAD_HOOK(BindBuffer)
+    LOAD_HOOK(BindBufferBase)
+    LOAD_HOOK(BindBufferRange)
+    LOAD_HOOK(BindFramebuffer)
+    LOAD_HOOK(BindVertexArray)
+    LOAD_HOOK(BlendFuncSeparate)
+    LOAD_HOOK(BlitFramebuffer)
+    LOAD_HOOK(BufferData)
+    LOAD_HOOK(BufferStorage)
+    LOAD_HOOK(BufferSubData)
+    LOAD_HOOK(CompressedTexSubImage2D)
+    LOAD_HOOK(CopyImageSubData)
+    LOAD_HOOK(CreateProgram)
+    LOAD_HOOK(DeleteBuffers)
+    LOAD_HOOK(DeleteFramebuffers)
+    LOAD_HOOK(DeleteProgram)
+    LOAD_HOOK(DeleteVertexArrays)
+    LOAD_HOOK(DisableVertexAttribArray)
+    LOAD_HOOK(EnableVertexAttribArray)
+    LOAD_HOOK(FlushMappedBufferRange)
+    LOAD_HOOK(FramebufferRenderbuffer)
+    LOAD_HOOK(FramebufferTexture)
+    LOAD_HOOK(FramebufferTexture2D)
+    LOAD_HOOK(FramebufferTextureLayer)
+    LOAD_HOOK(GenBuffers)
+    LOAD_HOOK(GenVertexArrays)
+    LOAD_HOOK(LinkProgram)
+    LOAD_HOOK(MapBufferRange)
+    LOAD_HOOK(TexStorage2D)
+    LOAD_HOOK(TexStorage2DMultisample)
+    LOAD_HOOK(Uniform1i)
+    LOAD_HOOK(Uniform1iv)
+    LOAD_HOOK(UniformBlockBinding)
+    LOAD_HOOK(UnmapBuffer)
+    LOAD_HOOK(UseProgram)
+    LOAD_HOOK(VertexAttribPointer)
+#undef LOAD_HOOK
+    hooks_loaded = hooks.CreateProgram != NULL;
+}
+
+// returns `data` if it has at least `len` bytes, otherwise `len` zero bytes
+static const void* payload_or_zeroes(const uint8_t* data, uint64_t data_len, size_t len) {
+    if (data_len >= len) return data;
+    if (len > scratch_len) {
+        free(scratch);
+        scratch = calloc(len, 1);
+        scratch_len = len;
+    }
+    return scratch;
+}
+
+static struct ReplayMapping* find_mapping(uint64_t context, GLenum target) {
+    for (size_t i = 0; i < mapping_count; i += 1) {
+        if (mappings[i].context == context && mappings[i].target == target) return &mappings[i];
+    }
+    return NULL;
+}
+
+static void replay_record(const struct ReplayRecord* record) {
+    const uint64_t* a = (const uint64_t*)(record + 1);
+    const uint8_t* data = (const uint8_t*)(a + record->arg_count);
+    const uint64_t data_len = record->data_len;
+    if (record->op >= sizeof(replay_arg_counts) || record->arg_count < replay_arg_counts[record->op]) return;
+    if (!hooks_loaded && record->op != TRACE_CREATECONTEXT && record->op != TRACE_MAKECURRENT) return;
+    switch (record->op) {
+        case TRACE_CREATECONTEXT:
+            _bolt_gl_onCreateContext((void*)(uintptr_t)a[0], (void*)(uintptr_t)a[1], &fake_libgl, fake_get_proc_address, a[2] != 0);
+            if (!hooks_loaded) load_hooks();
+            break;
+        case TRACE_MAKECURRENT:
+            _bolt_gl_onMakeCurrent((void*)(uintptr_t)a[0]);
+            break;
+        case TRACE_DESTROYCONTEXT:
+            // same as eglDestroyContext in so/main.c
+            if (_bolt_gl_onDestroyContext((void*)(uintptr_t)a[0])) _bolt_gl_close();
+            break;
+        case TRACE_SWAPBUFFERS:
+            _bolt_gl_onSwapBuffers((uint32_t)a[0], (uint32_t)a[1]);
+            break;
+        case TRACE_CREATEPROGRAM:
+            fake_pending_program = (GLuint)a[0];
+            hooks.CreateProgram();
+            break;
+        case TRACE_DELETEPROGRAM:
+            hooks.DeleteProgram((GLuint)a[0]);
+            break;
+        case TRACE_BINDATTRIBLOCATION: {
+            char name[256];
+            const size_t len = data_len < sizeof(name) ? (size_t)data_len : sizeof(name) - 1;
+            memcpy(name, data, len);
+            name[len] = '\0';
+            hooks.BindAttribLocation((GLuint)a[0], (GLuint)a[1], name);
+            break;
+        }
+        case TRACE_LINKPROGRAM:
+            hooks.LinkProgram((GLuint)a[0]);
+            break;
+        case TRACE_USEPROGRAM:
+            hooks.UseProgram((GLuint)a[0]);
+            break;
+        case TRACE_GENBUFFERS:
+        case TRACE_GENTEXTURES:
+        case TRACE_GENVERTEXARRAYS: {
+            const GLsizei n = (GLsizei)a[0];
+            if (n <= 0) break;
+            GLuint* names = malloc(n * sizeof(*names));
+            fake_pending_names = (const GLuint*)data;
+            fake_pending_name_count = (GLsizei)(data_len / sizeof(GLuint));
+            if (record->op == TRACE_GENBUFFERS) {
+                hooks.GenBuffers(n, names);
+            } else if (record->op == TRACE_GENVERTEXARRAYS) {
+                hooks.GenVertexArrays(n, names);
+            } else {
+                // GenTextures is hooked from libgl, so the hook is called with the names the real function made
+                fake_GenTextures(n, names);
+                _bolt_gl_onGenTextures(n, names);
+            }
+            free(names);
+            break;
+        }
+        case TRACE_DELETEBUFFERS:
+        case TRACE_DELETETEXTURES:
+        case TRACE_DELETEVERTEXARRAYS:
+        case TRACE_DELETEFRAMEBUFFERS: {
+            const GLsizei n = (GLsizei)a[0];
+            if (n <= 0 || data_len < n * sizeof(GLuint)) break;
+            const GLuint* names = (const GLuint*)data;
+            if (record->op == TRACE_DELETEBUFFERS) hooks.DeleteBuffers(n, names);
+            if (record->op == TRACE_DELETETEXTURES) _bolt_gl_onDeleteTextures(n, names);
+            if (record->op == TRACE_DELETEVERTEXARRAYS) hooks.DeleteVertexArrays(n, names);
+            if (record->op == TRACE_DELETEFRAMEBUFFERS) hooks.DeleteFramebuffers(n, names);
+            break;
+        }
+        case TRACE_BUFFERDATA:
+            hooks.BufferData((GLenum)a[0], (GLsizeiptr)a[1], data_len ? data : NULL, (GLenum)a[2]);
+            break;
+        case TRACE_BUFFERSTORAGE:
+            hooks.BufferStorage((GLenum)a[0], (GLsizeiptr)a[1], data_len ? data : NULL, (GLbitfield)a[2]);
+            break;
+        case TRACE_BUFFERSUBDATA:
+            hooks.BufferSubData((GLenum)a[0], (GLintptr)a[1], (GLsizeiptr)a[2], payload_or_zeroes(data, data_len, (size_t)a[2]));
+            break;
+        case TRACE_MAPBUFFERRANGE: {
+            uint8_t* ptr = hooks.MapBufferRange((GLenum)a[0], (GLintptr)a[1], (GLsizeiptr)a[2], (GLbitfield)a[3]);
+            struct ReplayMapping* mapping = find_mapping(record->context, (GLenum)a[0]);
+            if (!mapping && mapping_count < MAX_REPLAY_MAPPINGS) {
+                mapping = &mappings[mapping_count];
+                mapping_count += 1;
+            }
+            if (mapping) {
+                mapping->context = record->context;
+                mapping->target = (GLenum)a[0];
+                mapping->ptr = ptr;
+                mapping->len = ptr ? (size_t)a[2] : 0;
+            }
+            break;
+        }
+        case TRACE_FLUSHMAPPEDBUFFERRANGE: {
+            // the game's writes to the mapping are the payload, so put them there before the hook reads it
+            const struct ReplayMapping* mapping = find_mapping(record->context, (GLenum)a[0]);
+            if (mapping && data_len && a[1] + data_len <= mapping->len) memcpy(mapping->ptr + a[1], data, data_len);
+            hooks.FlushMappedBufferRange((GLenum)a[0], (GLintptr)a[1], (GLsizeiptr)a[2]);
+            break;
+        }
+        case TRACE_UNMAPBUFFER: {
+            struct ReplayMapping* mapping = find_mapping(record->context, (GLenum)a[0]);
+            if (mapping && data_len) memcpy(mapping->ptr, data, data_len < mapping->len ? data_len : mapping->len);
+            hooks.UnmapBuffer((GLenum)a[0]);
+            if (mapping) {
+                mapping_count -= 1;
+                *mapping = mappings[mapping_count];
+            }
+            break;
+        }
+        case TRACE_BINDTEXTURE:
+            _bolt_gl_onBindTexture((GLenum)a[0], (GLuint)a[1]);
+            break;
+        case TRACE_ACTIVETEXTURE:
+            hooks.ActiveTexture((GLenum)a[0]);
+            break;
+        case TRACE_TEXSTORAGE2D:
+            hooks.TexStorage2D((GLenum)a[0], (GLsizei)a[1], (GLenum)a[2], (GLsizei)a[3], (GLsizei)a[4]);
+            break;
+        case TRACE_TEXSTORAGE2DMULTISAMPLE:
+            hooks.TexStorage2DMultisample((GLenum)a[0], (GLsizei)a[1], (GLenum)a[2], (GLsizei)a[3], (GLsizei)a[4], (GLboolean)a[5]);
+            break;
+        case TRACE_TEXSUBIMAGE2D: {
+            const size_t len = (size_t)(GLsizei)a[4] * (size_t)(GLsizei)a[5] * 4;
+            _bolt_gl_onTexSubImage2D((GLenum)a[0], (GLint)a[1], (GLint)a[2], (GLint)a[3], (GLsizei)a[4], (GLsizei)a[5], (GLenum)a[6], (GLenum)a[7], payload_or_zeroes(data, data_len, len));
+            break;
+        }
+        case TRACE_COMPRESSEDTEXSUBIMAGE2D:
+            hooks.CompressedTexSubImage2D((GLenum)a[0], (GLint)a[1], (GLint)a[2], (GLint)a[3], (GLsizei)a[4], (GLsizei)a[5], (GLenum)a[6], (GLsizei)a[7], payload_or_zeroes(data, data_len, (size_t)(GLsizei)a[7]));
+            break;
+        case TRACE_TEXPARAMETERI:
+            _bolt_gl_onTexParameteri((GLenum)a[0], (GLenum)a[1], (GLint)a[2]);
+            break;
+        case TRACE_COPYIMAGESUBDATA:
+            hooks.CopyImageSubData(
+                (GLuint)a[0], (GLenum)a[1], (GLint)a[2], (GLint)a[3], (GLint)a[4], (GLint)a[5],
+                (GLuint)a[6], (GLenum)a[7], (GLint)a[8], (GLint)a[9], (GLint)a[10], (GLint)a[11],
+                (GLsizei)a[12], (GLsizei)a[13], (GLsizei)a[14]
+            );
+            break;
+        case TRACE_BINDVERTEXARRAY:
+            hooks.BindVertexArray((GLuint)a[0]);
+            break;
+        case TRACE_VERTEXATTRIBPOINTER:
+            hooks.VertexAttribPointer((GLuint)a[0], (GLint)a[1], (GLenum)a[2], (GLboolean)a[3], (GLsizei)a[4], (const void*)(uintptr_t)a[5]);
+            break;
+        case TRACE_ENABLEVERTEXATTRIBARRAY:
+            hooks.EnableVertexAttribArray((GLuint)a[0]);
+            break;
+        case TRACE_DISABLEVERTEXATTRIBARRAY:
+            hooks.DisableVertexAttribArray((GLuint)a[0]);
+            break;
+        case TRACE_BINDFRAMEBUFFER:
+            hooks.BindFramebuffer((GLenum)a[0], (GLuint)a[1]);
+            break;
+        case TRACE_BLITFRAMEBUFFER:
+            hooks.BlitFramebuffer((GLint)a[0], (GLint)a[1], (GLint)a[2], (GLint)a[3], (GLint)a[4], (GLint)a[5], (GLint)a[6], (GLint)a[7], (GLbitfield)a[8], (GLenum)a[9]);
+            break;
+        case TRACE_DRAWELEMENTS:
+            _bolt_gl_onDrawElements((GLenum)a[0], (GLsizei)a[1], (GLenum)a[2], (const void*)(uintptr_t)a[3]);
+            break;
+        case TRACE_DRAWARRAYS:
+            _bolt_gl_onDrawArrays((GLenum)a[0], (GLint)a[1], (GLsizei)a[2]);
+            break;
+        case TRACE_CLEAR:
+            _bolt_gl_onClear((GLbitfield)a[0]);
+            break;
+        case TRACE_VIEWPORT:
+            _bolt_gl_onViewport((GLint)a[0], (GLint)a[1], (GLsizei)a[2], (GLsizei)a[3]);
+            break;
+        case TRACE_BLENDFUNC:
+            _bolt_gl_onBlendFunc((GLenum)a[0], (GLenum)a[1]);
+            break;
+        case TRACE_BLENDFUNCSEPARATE:
+            hooks.BlendFuncSeparate((GLenum)a[0], (GLenum)a[1], (GLenum)a[2], (GLenum)a[3]);
+            break;
+        case TRACE_BINDBUFFER:
+            hooks.BindBuffer((GLenum)a[0], (GLuint)a[1]);
+            break;
+        case TRACE_BINDBUFFERBASE:
+            hooks.BindBufferBase((GLenum)a[0], (GLuint)a[1], (GLuint)a[2]);
+            break;
+        case TRACE_BINDBUFFERRANGE:
+            hooks.BindBufferRange((GLenum)a[0], (GLuint)a[1], (GLuint)a[2], (GLintptr)a[3], (GLsizeiptr)a[4]);
+            break;
+        case TRACE_UNIFORM1I:
+            hooks.Uniform1i((GLint)a[0], (GLint)a[1]);
+            break;
+        case TRACE_UNIFORM1IV:
+            hooks.Uniform1iv((GLint)a[0], (GLsizei)a[1], payload_or_zeroes(data, data_len, (size_t)(GLsizei)a[1] * sizeof(GLint)));
+            break;
+        case TRACE_UNIFORMBLOCKBINDING:
+            hooks.UniformBlockBinding((GLuint)a[0], (GLuint)a[1], (GLuint)a[2]);
+            break;
+        case TRACE_FRAMEBUFFERTEXTURE:
+            hooks.FramebufferTexture((GLenum)a[0], (GLenum)a[1], (GLuint)a[2], (GLint)a[3]);
+            break;
+        case TRACE_FRAMEBUFFERTEXTURE2D:
+            hooks.FramebufferTexture2D((GLenum)a[0], (GLenum)a[1], (GLenum)a[2], (GLuint)a[3], (GLint)a[4]);
+            break;
+        case TRACE_FRAMEBUFFERTEXTURELAYER:
+            hooks.FramebufferTextureLayer((GLenum)a[0], (GLenum)a[1], (GLuint)a[2], (GLint)a[3], (GLint)a[4]);
+            break;
+        case TRACE_FRAMEBUFFERRENDERBUFFER:
+            hooks.FramebufferRenderbuffer((GLenum)a[0], (GLenum)a[1], (GLenum)a[2], (GLuint)a[3]);
+            break;
+    }
+}
+
+static int compare_u64(const void* a, const void* b) {
+    const uint64_t x = *(const uint64_t*)a;
+    const uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t now_nanos() {
+    uint64_t t = 0;
+    _bolt_monotonic_nanoseconds(&t);
+    return t;
+}
+
+int main(int argc, char** argv) {
+    const char* const event_names[] = {
+        "swapbuffers", "render2d", "render3d", "renderparticles", "renderbillboard", "rendericon", "renderbigicon",
+        "minimapterrain", "minimaprender2d", "renderminimap", "rendergameview", "mousemotion", "mousebutton",
+        "mousebuttonup", "scroll",
+    };
+    if (argc < 2) {
+        printf("usage: %s <trace file> [event bits | all]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) stub_subscribed_events = strcmp(argv[2], "all") ? (uint32_t)strtoul(argv[2], NULL, 0) : ~(uint32_t)0;
+
+    FILE* f = fopen(argv[1], "rb");
+    if (!f) {
+        printf("failed to open '%s'\n", argv[1]);
+        return 1;
+    }
+    char magic[8];
+    uint32_t version = 0;
+    if (fread(magic, 1, sizeof(magic), f) != sizeof(magic) || memcmp(magic, "BOLTTRCE", sizeof(magic)) || fread(&version, sizeof(version), 1, f) != 1) {
+        printf("'%s' is not a GL trace\n", argv[1]);
+        fclose(f);
+        return 1;
+    }
+    if (version != TRACE_FORMAT_VERSION) {
+        printf("'%s' is trace format version %u, expected %u\n", argv[1], (unsigned int)version, (unsigned int)TRACE_FORMAT_VERSION);
+        fclose(f);
+        return 1;
+    }
+
+    fake_buffers = hashmap_new(sizeof(struct FakeObject), 0, 0, 0, fake_object_hash, fake_object_compare, NULL, NULL);
+    fake_framebuffers = hashmap_new(sizeof(struct FakeObject), 0, 0, 0, fake_object_hash, fake_object_compare, NULL, NULL);
+    fake_vaos = hashmap_new(sizeof(struct FakeObject), 0, 0, 0, fake_object_hash, fake_object_compare, NULL, NULL);
+
+    // each frame is read into memory before it's replayed, so that only bolt's own time gets measured
+    struct ReplayFrame frame = {0};
+    uint64_t* frame_nanos = NULL;
+    size_t frame_count = 0;
+    size_t frame_capacity = 0;
+    size_t record_count = 0;
+    while (read_frame(f, &frame)) {
+        const uint64_t start = now_nanos();
+        size_t offset = 0;
+        for (size_t i = 0; i < frame.record_count; i += 1) {
+            const struct ReplayRecord* record = (const struct ReplayRecord*)(frame.data + offset);
+            replay_record(record);
+            offset += sizeof(*record) + (record->arg_count * sizeof(uint64_t)) + REPLAY_ALIGN(record->data_len);
+        }
+        const uint64_t elapsed = now_nanos() - start;
+        if (frame_count == frame_capacity) {
+            frame_capacity = frame_capacity ? frame_capacity * 2 : 1024;
+            frame_nanos = realloc(frame_nanos, frame_capacity * sizeof(*frame_nanos));
+        }
+        frame_nanos[frame_count] = elapsed;
+        frame_count += 1;
+        record_count += frame.record_count;
+    }
+    fclose(f);
+    if (!frame_count) {
+        printf("'%s' contains no records\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t total_nanos = 0;
+    for (size_t i = 0; i < frame_count; i += 1) total_nanos += frame_nanos[i];
+    qsort(frame_nanos, frame_count, sizeof(*frame_nanos), compare_u64);
+    printf("replayed %zu frames, %zu calls, with event bits 0x%x\n", frame_count, record_count, (unsigned int)stub_subscribed_events);
+    printf(
+        "bolt time per frame: %.1f us mean, %.1f us median, %.1f us 99th percentile, %.1f us worst\n",
+        (double)total_nanos / (frame_count * 1000.0), (double)frame_nanos[frame_count / 2] / 1000.0,
+        (double)frame_nanos[(frame_count * 99) / 100] / 1000.0, (double)frame_nanos[frame_count - 1] / 1000.0
+    );
+    for (size_t i = 0; i < PLUGIN_EVENT_COUNT && i < sizeof(event_names) / sizeof(*event_names); i += 1) {
+        if (stub_event_counts[i]) printf("  %-16s %8.1f events/frame\n", event_names[i], (double)stub_event_counts[i] / frame_count);
+    }
+
+    free(frame_nanos);
+    free(frame.data);
+    free(scratch);
+    hashmap_free(fake_buffers);
+    hashmap_free(fake_framebuffers);
+    hashmap_free(fake_vaos);
+    return 0;
+}
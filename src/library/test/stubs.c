@@ -0,0 +1,79 @@
+#include "stubs.h"
+#include "../gl.h"
+#include "../../../modules/hashmap/hashmap.h"
+
+#include <string.h>
+#include <time.h>
+
+uint32_t stub_subscribed_events = 0;
+uint64_t stub_event_counts[PLUGIN_EVENT_COUNT];
+
+static uint8_t inited = 0;
+
+void _bolt_plugin_init(const struct PluginManagedFunctions* functions) {
+    inited = 1;
+}
+
+uint8_t _bolt_plugin_is_inited() {
+    return inited;
+}
+
+void _bolt_plugin_close() {
+    inited = 0;
+}
+
+void _bolt_plugin_end_frame(uint32_t width, uint32_t height) {
+    stub_event_counts[PLUGIN_EVENT_SWAPBUFFERS] += 1;
+}
+
+uint32_t _bolt_plugin_subscribed_events() {
+    return stub_subscribed_events;
+}
+
+#define DEFHANDLER(NAME, STRUCT, TYPE) void _bolt_plugin_handle_##NAME(const struct STRUCT* e) { stub_event_counts[PLUGIN_EVENT_##TYPE] += 1; }
+DEFHANDLER(render2d, RenderBatch2D, RENDER2D)
+DEFHANDLER(render3d, Render3D, RENDER3D)
+DEFHANDLER(renderparticles, RenderParticles, RENDERPARTICLES)
+DEFHANDLER(renderbillboard, RenderBillboard, RENDERBILLBOARD)
+DEFHANDLER(rendericon, RenderIconEvent, RENDERICON)
+DEFHANDLER(renderbigicon, RenderIconEvent, RENDERBIGICON)
+DEFHANDLER(minimapterrain, MinimapTerrainEvent, MINIMAPTERRAIN)
+DEFHANDLER(minimaprender2d, RenderBatch2D, MINIMAPRENDER2D)
+DEFHANDLER(renderminimap, RenderMinimapEvent, RENDERMINIMAP)
+DEFHANDLER(rendergameview, RenderGameViewEvent, RENDERGAMEVIEW)
+#undef DEFHANDLER
+
+// same as in plugin.c
+int _bolt_plugin_itemicon_compare(const void* a, const void* b, void* udata) {
+    const struct Icon* i1 = a;
+    const struct Icon* i2 = b;
+    uint64_t xywh1, xywh2;
+    memcpy(&xywh1, &i1->x, sizeof xywh1);
+    memcpy(&xywh2, &i2->x, sizeof xywh2);
+    return xywh2 - xywh1;
+}
+
+uint64_t _bolt_plugin_itemicon_hash(const void* item, uint64_t seed0, uint64_t seed1) {
+    const struct Icon* icon = item;
+    return hashmap_sip(&icon->x, 4 * sizeof icon->x, seed0, seed1);
+}
+
+uint8_t _bolt_monotonic_microseconds(uint64_t* microseconds) {
+    struct timespec s;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &s);
+    *microseconds = (s.tv_sec * 1000000) + (s.tv_nsec / 1000);
+    return true;
+}
+
+uint8_t _bolt_monotonic_nanoseconds(uint64_t* nanoseconds) {
+    struct timespec s;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &s);
+    *nanoseconds = (s.tv_sec * 1000000000) + s.tv_nsec;
+    return true;
+}
+
+void _bolt_flash_window(void) {}
+
+uint8_t _bolt_window_has_focus(void) {
+    return 1;
+}
@@ -0,0 +1,15 @@
+#ifndef _BOLT_LIBRARY_TEST_STUBS_H_
+#define _BOLT_LIBRARY_TEST_STUBS_H_
+#include "../plugin/plugin.h"
+
+// stand-ins for the plugin and OS functions which gl.c calls, so that gl.c can be linked into the tests and
+// benchmarks without lua, IPC or a window. no plugins are running, so render events only get built if
+// stub_subscribed_events says something wants them.
+
+/// Event bits returned by _bolt_plugin_subscribed_events. Defaults to 0, i.e. no plugin handles anything.
+extern uint32_t stub_subscribed_events;
+
+/// Number of events passed to each _bolt_plugin_handle_* stub, indexed by enum PluginEventType.
+extern uint64_t stub_event_counts[PLUGIN_EVENT_COUNT];
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef _BOLT_LIBRARY_TRACE_H_
+#define _BOLT_LIBRARY_TRACE_H_
+#include <stdint.h>
+
+// format of the GL trace files written by BOLT_LIBRARY_TRACE builds and read by test/replay.c.
+//
+// file layout: the 8-byte magic "BOLTTRCE", a uint32 format version, then a stream of records. each
+// record is a struct TraceRecordHeader, followed by arg_count uint64 arguments, followed by data_len
+// bytes of payload. everything is in the host's byte order. op numbers must never be reused.
+// payloads longer than a uint32 can describe are split, with the remainder following immediately in
+// TRACE_DATACONTINUATION records that have no arguments. texture uploads read from a bound pixel unpack
+// buffer have no payload, since their pointer argument is an offset into that buffer.
+// the arguments of each op are listed at its TRACE_CALL in gl.c.
+
+enum TraceOp {
+    TRACE_CREATECONTEXT = 1,
+    TRACE_MAKECURRENT = 2,
+    TRACE_DESTROYCONTEXT = 3,
+    TRACE_SWAPBUFFERS = 4,
+    TRACE_CREATEPROGRAM = 5,
+    TRACE_DELETEPROGRAM = 6,
+    TRACE_BINDATTRIBLOCATION = 7,
+    TRACE_LINKPROGRAM = 8,
+    TRACE_USEPROGRAM = 9,
+    TRACE_GENBUFFERS = 10,
+    TRACE_DELETEBUFFERS = 11,
+    TRACE_BUFFERDATA = 12,
+    TRACE_BUFFERSTORAGE = 13,
+    TRACE_BUFFERSUBDATA = 14,
+    TRACE_MAPBUFFERRANGE = 15,
+    TRACE_FLUSHMAPPEDBUFFERRANGE = 16,
+    TRACE_UNMAPBUFFER = 17,
+    TRACE_GENTEXTURES = 18,
+    TRACE_DELETETEXTURES = 19,
+    TRACE_BINDTEXTURE = 20,
+    TRACE_ACTIVETEXTURE = 21,
+    TRACE_TEXSTORAGE2D = 22,
+    TRACE_TEXSTORAGE2DMULTISAMPLE = 23,
+    TRACE_TEXSUBIMAGE2D = 24,
+    TRACE_COMPRESSEDTEXSUBIMAGE2D = 25,
+    TRACE_TEXPARAMETERI = 26,
+    TRACE_COPYIMAGESUBDATA = 27,
+    TRACE_GENVERTEXARRAYS = 28,
+    TRACE_DELETEVERTEXARRAYS = 29,
+    TRACE_BINDVERTEXARRAY = 30,
+    TRACE_VERTEXATTRIBPOINTER = 31,
+    TRACE_ENABLEVERTEXATTRIBARRAY = 32,
+    TRACE_DISABLEVERTEXATTRIBARRAY = 33,
+    TRACE_BINDFRAMEBUFFER = 34,
+    TRACE_BLITFRAMEBUFFER = 35,
+    TRACE_DRAWELEMENTS = 36,
+    TRACE_DRAWARRAYS = 37,
+    TRACE_CLEAR = 38,
+    TRACE_VIEWPORT = 39,
+    TRACE_BLENDFUNC = 40,
+    TRACE_BLENDFUNCSEPARATE = 41,
+    TRACE_BINDBUFFER = 42,
+    TRACE_BINDBUFFERBASE = 43,
+    TRACE_BINDBUFFERRANGE = 44,
+    TRACE_UNIFORM1I = 45,
+    TRACE_UNIFORM1IV = 46,
+    TRACE_UNIFORMBLOCKBINDING = 47,
+    TRACE_FRAMEBUFFERTEXTURE = 48,
+    TRACE_FRAMEBUFFERTEXTURE2D = 49,
+    TRACE_FRAMEBUFFERTEXTURELAYER = 50,
+    TRACE_FRAMEBUFFERRENDERBUFFER = 51,
+    TRACE_DELETEFRAMEBUFFERS = 52,
+    TRACE_DATACONTINUATION = 53,
+};
+
+struct TraceRecordHeader {
+    uint16_t op;
+    uint16_t arg_count;
+    uint32_t data_len;
+    uint64_t context;
+    uint64_t timestamp_micros;
+};
+
+#define TRACE_FORMAT_VERSION 2
+#define TRACE_MAX_RECORD_DATA 0x80000000u
+
+#endif